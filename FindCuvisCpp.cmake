@@ -68,8 +68,48 @@ else()
 		if (NOT WIN32)
 			set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -pthread")
 		endif()
-		
-  endif()		
+
+	  option(CUVIS_CPP_BUILD_BENCHMARKS "Build the benchmarks of the cpp interface (requires Google Benchmark)" FALSE)
+
+	  if(CUVIS_CPP_BUILD_BENCHMARKS AND NOT TARGET cuvis_cpp_benchmark)
+		  find_package(benchmark REQUIRED)
+
+		  # the spectral helpers need OpenCV, their benchmarks are left out without it
+		  find_package(OpenCV QUIET)
+
+		  set(CUVIS_CPP_BENCHMARK_DIR ${CMAKE_CURRENT_LIST_DIR}/benchmark)
+		  set(CUVIS_CPP_BENCHMARK_SOURCES
+			${CUVIS_CPP_BENCHMARK_DIR}/main.cpp
+			${CUVIS_CPP_BENCHMARK_DIR}/bench_measurement.cpp
+			${CUVIS_CPP_BENCHMARK_DIR}/bench_processing.cpp
+			${CUVIS_CPP_BENCHMARK_DIR}/bench_exporter.cpp
+			${CUVIS_CPP_BENCHMARK_DIR}/bench_worker.cpp)
+
+		  add_executable(cuvis_cpp_benchmark ${CUVIS_CPP_BENCHMARK_SOURCES})
+		  target_link_libraries(cuvis_cpp_benchmark PRIVATE cuvis::cpp benchmark::benchmark)
+
+		  if(OpenCV_FOUND)
+			  target_sources(cuvis_cpp_benchmark PRIVATE ${CUVIS_CPP_BENCHMARK_DIR}/bench_spectral.cpp)
+			  target_include_directories(cuvis_cpp_benchmark PRIVATE ${OpenCV_INCLUDE_DIRS})
+			  target_link_libraries(cuvis_cpp_benchmark PRIVATE ${OpenCV_LIBS})
+		  else()
+			  message(STATUS "OpenCV not found, the benchmarks of the spectral helpers are not built.")
+		  endif()
+	  endif()
+
+	  option(CUVIS_CPP_BUILD_TESTS "Build the tests of the auxiliary helpers" FALSE)
+
+	  if(CUVIS_CPP_BUILD_TESTS AND NOT TARGET cuvis_cpp_test_export_pipeline)
+		  enable_testing()
+
+		  # the tests need the SDK, they are skipped if CUVIS_TEST_SETTINGS is not set
+		  add_executable(cuvis_cpp_test_export_pipeline ${CMAKE_CURRENT_LIST_DIR}/test/test_export_pipeline.cpp)
+		  target_link_libraries(cuvis_cpp_test_export_pipeline PRIVATE cuvis::cpp)
+		  add_test(NAME cuvis_cpp_test_export_pipeline COMMAND cuvis_cpp_test_export_pipeline)
+		  set_tests_properties(cuvis_cpp_test_export_pipeline PROPERTIES SKIP_RETURN_CODE 77)
+	  endif()
+
+  endif()
 	
   # Function to extract version from DLL
   function(get_library_version LIB_PATH OUTPUT_VARIABLE)
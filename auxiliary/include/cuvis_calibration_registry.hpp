@@ -0,0 +1,329 @@
+#pragma once
+
+/** @file cuvis_calibration_registry.hpp
+  *
+  *
+  * @details Sharing of calibrations and reuse of processing contexts within a process.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cuvis.hpp>
+
+/**
+  * @brief Calibration handling of the auxiliary helpers.
+  * */
+namespace cuvis::aux::calibration
+{
+  /** @brief Loads every calibration once and keeps idle processing contexts for reuse
+    *
+    * A calibration is loaded only once per factory directory, also when it is requested by several threads at the same
+    * time, and shared by all users afterwards. Loading can be started in the background with @ref preload, so it
+    * overlaps with the remaining startup.
+    *
+    * Processing contexts are handed out as shared pointers. When the last copy is released, the context returns to
+    * the registry under the processing arguments it has then, so arguments changed with
+    * @ref ProcessingContext::set_processingArgs are taken into account, and is handed out again for the same calibration
+    * and processing arguments. On release the references are cleared and the instrumentation is removed, so the next
+    * user gets a context without references. Contexts with added reference profiles are not returned and are freed.
+    * Contexts may outlive the registry; they are freed normally then.
+    * */
+  class calibration_registry_t
+  {
+  public:
+    calibration_registry_t() : _state(std::make_shared<state_t>()) {}
+
+    calibration_registry_t(calibration_registry_t const&) = delete;
+    calibration_registry_t& operator=(calibration_registry_t const&) = delete;
+
+    /** @brief The registry shared by the whole process */
+    static calibration_registry_t& instance();
+
+    /** @brief Starts loading a calibration in the background, if it is not loaded or loading yet
+      *
+      * @param[in] path The path to the factory directory
+      * */
+    std::shared_future<std::shared_ptr<Calibration const>> preload(std::filesystem::path const& path);
+
+    /** @brief Returns the calibration of a factory directory, loads it if necessary
+      *
+      * Waits for a load already in progress. If loading fails, the exception is rethrown and a later call tries again.
+      *
+      * @param[in] path The path to the factory directory
+      * */
+    std::shared_ptr<Calibration const> get(std::filesystem::path const& path);
+
+    /** @brief Returns a processing context for the calibration and the processing arguments
+      *
+      * Reuses an idle context created with the same calibration and arguments, or creates a new one.
+      * */
+    std::shared_ptr<ProcessingContext> acquire_context(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args = ProcessingArgs());
+
+    /** @brief Returns a processing context for the calibration of a factory directory, see @ref acquire_context */
+    std::shared_ptr<ProcessingContext> acquire_context(std::filesystem::path const& path, ProcessingArgs const& args = ProcessingArgs());
+
+    /** @brief Creates idle processing contexts in advance, so the next acquisitions return right away
+      *
+      * @param[in] calib The calibration
+      * @param[in] args The processing arguments
+      * @param[in] count Number of idle contexts to have available
+      * */
+    void reserve_contexts(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args, std::size_t count);
+
+    /** @brief Number of idle processing contexts */
+    std::size_t idle_contexts() const;
+
+    /** @brief Drops all calibrations and idle processing contexts
+      *
+      * Calibrations and contexts still in use stay valid.
+      * */
+    void clear();
+
+  private:
+    using calibration_future_t = std::shared_future<std::shared_ptr<Calibration const>>;
+
+    /* calibration, processing mode, allow recalib, channel subset, region, discard full cube */
+    using context_key_t =
+        std::tuple<Calibration const*, int, bool, std::vector<std::size_t>, std::tuple<bool, std::size_t, std::size_t, std::size_t, std::size_t>, bool>;
+
+    /* an idle context holds its calibration, so the address in the key is not reused meanwhile */
+    struct idle_context_t
+    {
+      std::shared_ptr<Calibration const> calib;
+      std::unique_ptr<ProcessingContext> context;
+    };
+
+    struct state_t
+    {
+      std::mutex mutex;
+      std::map<std::filesystem::path, calibration_future_t> calibrations;
+      std::map<context_key_t, std::vector<idle_context_t>> idle;
+    };
+
+    static constexpr reference_type_t reference_types[] = {reference_type_t::Reference_Dark,
+                                                           reference_type_t::Reference_White,
+                                                           reference_type_t::Reference_WhiteDark,
+                                                           reference_type_t::Reference_SpRad,
+                                                           reference_type_t::Reference_Distance};
+
+    static context_key_t make_key(Calibration const& calib, ProcessingArgs const& args);
+
+    std::unique_ptr<ProcessingContext> create_context(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args);
+
+    std::shared_ptr<state_t> _state;
+  };
+
+  /** @cond INTERNAL */
+  inline calibration_registry_t& calibration_registry_t::instance()
+  {
+    static calibration_registry_t registry;
+    return registry;
+  }
+
+  inline std::shared_future<std::shared_ptr<Calibration const>> calibration_registry_t::preload(std::filesystem::path const& path)
+  {
+    std::filesystem::path const key = std::filesystem::weakly_canonical(path);
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    auto it = _state->calibrations.find(key);
+    if (it != _state->calibrations.end())
+    {
+      return it->second;
+    }
+    calibration_future_t future =
+        std::async(std::launch::async, [key]() -> std::shared_ptr<Calibration const> { return std::make_shared<Calibration const>(key); }).share();
+    _state->calibrations.emplace(key, future);
+    return future;
+  }
+
+  inline std::shared_ptr<Calibration const> calibration_registry_t::get(std::filesystem::path const& path)
+  {
+    calibration_future_t future;
+    std::filesystem::path const key = std::filesystem::weakly_canonical(path);
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      auto it = _state->calibrations.find(key);
+      if (it != _state->calibrations.end())
+      {
+        future = it->second;
+      }
+    }
+    if (!future.valid())
+    {
+      // load in the calling thread, concurrent callers wait for the same future
+      std::promise<std::shared_ptr<Calibration const>> loaded;
+      bool inserted;
+      {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        auto emplaced = _state->calibrations.emplace(key, loaded.get_future().share());
+        future = emplaced.first->second;
+        inserted = emplaced.second;
+      }
+      if (inserted)
+      {
+        try
+        {
+          loaded.set_value(std::make_shared<Calibration const>(key));
+        }
+        catch (...)
+        {
+          loaded.set_exception(std::current_exception());
+        }
+      }
+    }
+
+    try
+    {
+      return future.get();
+    }
+    catch (...)
+    {
+      // forget the failed load, so a later call tries again
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      auto it = _state->calibrations.find(key);
+      if (it != _state->calibrations.end() && it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+      {
+        try
+        {
+          it->second.get();
+        }
+        catch (...)
+        {
+          _state->calibrations.erase(it);
+        }
+      }
+      throw;
+    }
+  }
+
+  inline calibration_registry_t::context_key_t calibration_registry_t::make_key(Calibration const& calib, ProcessingArgs const& args)
+  {
+    cube_region_t const region = args.region.value_or(cube_region_t());
+    return context_key_t{&calib,
+                         int(args.processing_mode),
+                         args.allow_recalib,
+                         args.channel_subset,
+                         std::make_tuple(args.region.has_value(), region.x, region.y, region.width, region.height),
+                         args.discard_full_cube};
+  }
+
+  inline std::unique_ptr<ProcessingContext> calibration_registry_t::create_context(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args)
+  {
+    auto context = std::make_unique<ProcessingContext>(*calib);
+    context->set_processingArgs(args);
+    return context;
+  }
+
+  inline std::shared_ptr<ProcessingContext> calibration_registry_t::acquire_context(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args)
+  {
+    context_key_t key = make_key(*calib, args);
+    std::unique_ptr<ProcessingContext> context;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      auto it = _state->idle.find(key);
+      if (it != _state->idle.end() && !it->second.empty())
+      {
+        context = std::move(it->second.back().context);
+        it->second.pop_back();
+      }
+    }
+    if (!context)
+    {
+      context = create_context(calib, args);
+    }
+
+    std::weak_ptr<state_t> registry = _state;
+    return std::shared_ptr<ProcessingContext>(context.release(), [registry, calib](ProcessingContext* released) {
+      std::unique_ptr<ProcessingContext> owned(released);
+      auto state = registry.lock();
+      if (!state)
+      {
+        return;
+      }
+      try
+      {
+        // the user may have changed the context, it is pooled under its current arguments without references
+        if (owned->get_reference_profiles().size() > 1)
+        {
+          return;
+        }
+        for (reference_type_t type : reference_types)
+        {
+          if (owned->has_reference(type))
+          {
+            owned->clear_reference(type);
+          }
+        }
+        owned->set_instrumentation(nullptr);
+        context_key_t key = make_key(*calib, owned->get_processingArgs());
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->idle[std::move(key)].push_back(idle_context_t{calib, std::move(owned)});
+      }
+      catch (...)
+      {
+        // the context is freed instead of pooled
+      }
+    });
+  }
+
+  inline std::shared_ptr<ProcessingContext> calibration_registry_t::acquire_context(std::filesystem::path const& path, ProcessingArgs const& args)
+  {
+    return acquire_context(get(path), args);
+  }
+
+  inline void calibration_registry_t::reserve_contexts(std::shared_ptr<Calibration const> const& calib, ProcessingArgs const& args, std::size_t count)
+  {
+    // created one by one outside the lock and released into the idle list
+    std::vector<std::shared_ptr<ProcessingContext>> contexts;
+    context_key_t const key = make_key(*calib, args);
+    while (true)
+    {
+      {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        auto it = _state->idle.find(key);
+        if ((it != _state->idle.end() ? it->second.size() : 0) + contexts.size() >= count)
+        {
+          break;
+        }
+      }
+      contexts.push_back(acquire_context(calib, args));
+    }
+  }
+
+  inline std::size_t calibration_registry_t::idle_contexts() const
+  {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    std::size_t count = 0;
+    for (auto const& entry : _state->idle)
+    {
+      count += entry.second.size();
+    }
+    return count;
+  }
+
+  inline void calibration_registry_t::clear()
+  {
+    std::map<std::filesystem::path, calibration_future_t> calibrations;
+    std::map<context_key_t, std::vector<idle_context_t>> idle;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      calibrations.swap(_state->calibrations);
+      idle.swap(_state->idle);
+    }
+    // the SDK handles are freed outside the lock
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::calibration
@@ -0,0 +1,493 @@
+#pragma once
+
+/** @file cuvis_device.hpp
+  *
+  *
+  * @details Images in the memory of a compute device and spectral helpers running on the device.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cuvis.hpp>
+#include <cuvis_spectral.hpp>
+
+/**
+  * @brief Compute devices of the auxiliary helpers.
+  *
+  * A @ref backend_t owns the memory and runs the algorithms of a device. The @ref host_backend_t runs on the CPU and
+  * needs no additional dependency. The CUDA backend is in cuvis_device_cuda.cuh, which must be compiled by nvcc.
+  * */
+namespace cuvis::aux::device
+{
+  /** @brief Untyped description of an image in device memory, as passed to a @ref backend_t */
+  struct device_view_t
+  {
+    /** The device pointer, BIP interleave.*/
+    void const* data = nullptr;
+
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t channels = 0;
+
+    cuvis_imbuffer_format_t format = cuvis_imbuffer_format_t::imbuffer_format_uint16;
+  };
+
+  /** @brief Running moments of the pixels covered by spans, see @ref backend_t::accumulate_spans */
+  struct span_moments_t
+  {
+    /** Number of covered pixels.*/
+    std::uint64_t n = 0;
+
+    /** Per channel values the sums are taken relative to, the values of the first covered pixel.*/
+    std::vector<double> shift;
+
+    std::vector<double> sum;
+    std::vector<double> sq_sum;
+  };
+
+  /** @brief Memory and algorithms of a compute device
+    *
+    * Operations are ordered as issued. Operations returning results to the host wait for all previous operations.
+    * A backend is used by one thread at a time.
+    * */
+  class backend_t
+  {
+  public:
+    virtual ~backend_t() = default;
+
+    virtual char const* name() const = 0;
+
+    /** @brief Whether the device accesses host memory without copying it, e.g. an integrated GPU
+      *
+      * If so, @ref device_image_t::map is preferable to @ref device_image_t::upload.
+      * */
+    virtual bool shares_host_memory() const = 0;
+
+    virtual void* allocate(std::size_t bytes) = 0;
+    virtual void deallocate(void* data) noexcept = 0;
+
+    /** @brief Copies host memory to the device, the host memory may be reused on return */
+    virtual void upload(void* device, void const* host, std::size_t bytes) = 0;
+
+    /** @brief Copies device memory to the host, waits for the copy */
+    virtual void download(void* host, void const* device, std::size_t bytes) = 0;
+
+    /** @brief Makes host memory accessible to the device without copying
+      *
+      * @returns The device pointer, valid until @ref unmap_host
+      * */
+    virtual void* map_host(void const* host, std::size_t bytes) = 0;
+    virtual void unmap_host(void const* host) noexcept = 0;
+
+    /** @brief Waits for all issued operations */
+    virtual void synchronize() = 0;
+
+    /** @brief Accumulates the moments of the pixels covered by the spans, see @ref spectral::get_spectrum_polygon
+      *
+      * @param[in] img The image
+      * @param[in] spans The spans, sorted by row, within the image
+      * @param[out] moments The moments, sized to the channels of the image
+      * */
+    virtual void accumulate_spans(device_view_t const& img, spectral::span_list_t const& spans, span_moments_t& moments) = 0;
+
+    /** @brief Counts all histograms of a layout, see @ref spectral::compute_histogram_table
+      *
+      * @param[in] img The image
+      * @param[in] layout The layout of the histograms
+      * @param[in] max_value Upper limit of the count range, it is detected from the data if not set
+      * @param[out] res The occurrences and the used max value
+      * */
+    virtual void histogram(device_view_t const& img, spectral::histogram_layout_t const& layout, std::optional<double> max_value, spectral::histogram_table_t& res) = 0;
+  };
+
+  /** @cond INTERNAL */
+  namespace device_impl
+  {
+    template <typename data_t>
+    constexpr cuvis_imbuffer_format_t format_of()
+    {
+      static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+      if constexpr (std::is_same<data_t, std::uint8_t>::value)
+      {
+        return cuvis_imbuffer_format_t::imbuffer_format_uint8;
+      }
+      else if constexpr (std::is_same<data_t, std::uint16_t>::value)
+      {
+        return cuvis_imbuffer_format_t::imbuffer_format_uint16;
+      }
+      else if constexpr (std::is_same<data_t, std::uint32_t>::value)
+      {
+        return cuvis_imbuffer_format_t::imbuffer_format_uint32;
+      }
+      else
+      {
+        return cuvis_imbuffer_format_t::imbuffer_format_float;
+      }
+    }
+
+    /* calls fn with a typed null pointer of the data type of the format */
+    template <typename fn_t>
+    inline void visit_format(cuvis_imbuffer_format_t format, fn_t&& fn)
+    {
+      switch (format)
+      {
+        case cuvis_imbuffer_format_t::imbuffer_format_uint8: fn(static_cast<std::uint8_t const*>(nullptr)); break;
+        case cuvis_imbuffer_format_t::imbuffer_format_uint16: fn(static_cast<std::uint16_t const*>(nullptr)); break;
+        case cuvis_imbuffer_format_t::imbuffer_format_uint32: fn(static_cast<std::uint32_t const*>(nullptr)); break;
+        case cuvis_imbuffer_format_t::imbuffer_format_float: fn(static_cast<float const*>(nullptr)); break;
+        default: throw std::invalid_argument("unsupported image data type");
+      }
+    }
+
+    /* a host image of a view in host memory, without wavelengths */
+    template <typename data_t>
+    inline image_t<data_t> host_image(device_view_t const& img)
+    {
+      image_t<data_t> image{};
+      image._width = img.width;
+      image._height = img.height;
+      image._channels = img.channels;
+      image._data = static_cast<data_t const*>(img.data);
+      image._wavelength = nullptr;
+      return image;
+    }
+  } // namespace device_impl
+  /** @endcond */
+
+  /** @brief Backend running on the CPU, with the algorithms of @ref spectral
+    *
+    * Serves as fallback where no device is available and as reference for other backends.
+    * */
+  class host_backend_t : public backend_t
+  {
+  public:
+    /** @param[in] exec Execution settings of the algorithms */
+    explicit host_backend_t(parallel::execution_t const& exec = {}) : _exec(exec) {}
+
+    char const* name() const override { return "host"; }
+    bool shares_host_memory() const override { return true; }
+
+    void* allocate(std::size_t bytes) override { return ::operator new(std::max<std::size_t>(bytes, 1)); }
+    void deallocate(void* data) noexcept override { ::operator delete(data); }
+
+    void upload(void* device, void const* host, std::size_t bytes) override { std::memcpy(device, host, bytes); }
+    void download(void* host, void const* device, std::size_t bytes) override { std::memcpy(host, device, bytes); }
+
+    void* map_host(void const* host, std::size_t) override { return const_cast<void*>(host); }
+    void unmap_host(void const*) noexcept override {}
+
+    void synchronize() override {}
+
+    void accumulate_spans(device_view_t const& img, spectral::span_list_t const& spans, span_moments_t& moments) override
+    {
+      device_impl::visit_format(img.format, [&](auto typed) {
+        using data_t = std::remove_const_t<std::remove_pointer_t<decltype(typed)>>;
+        image_t<data_t> const image = device_impl::host_image<data_t>(img);
+
+        std::vector<spectral::spectral_impl::moments_t> result(1);
+        result[0].reset(img.channels);
+        spectral::spectral_impl::set_shift(image, spans, result[0]);
+        spectral::spectral_impl::accumulate_roi_spans(image, spectral::spectral_impl::merge_roi_spans({spans}), result, _exec);
+
+        moments.n = result[0].n;
+        moments.shift = std::move(result[0].shift);
+        moments.sum = std::move(result[0].sum);
+        moments.sq_sum = std::move(result[0].sq_sum);
+      });
+    }
+
+    void histogram(device_view_t const& img, spectral::histogram_layout_t const& layout, std::optional<double> max_value, spectral::histogram_table_t& res) override
+    {
+      device_impl::visit_format(img.format, [&](auto typed) {
+        using data_t = std::remove_const_t<std::remove_pointer_t<decltype(typed)>>;
+        spectral::compute_histogram_table(device_impl::host_image<data_t>(img), layout, max_value, false, _exec, _workspace, res);
+      });
+    }
+
+  private:
+    parallel::execution_t _exec;
+    spectral::histogram_workspace_t _workspace;
+  };
+
+  /** @brief An image in the memory of a compute device
+    *
+    * The device memory is either owned and filled with @ref upload, or mapped host memory of a measurement,
+    * see @ref map. An owned allocation is reused by the next @ref upload of an image of the same size or smaller,
+    * so a device image kept across frames does not allocate per frame.
+    * The wavelengths are kept in host memory.
+    *
+    * @tparam data_t The data type, either std::uint8_t, std::uint16_t, std::uint32_t or float
+    * */
+  template <typename data_t>
+  class device_image_t
+  {
+    static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+
+  public:
+    explicit device_image_t(std::shared_ptr<backend_t> backend);
+    ~device_image_t();
+
+    device_image_t(device_image_t const&) = delete;
+    device_image_t& operator=(device_image_t const&) = delete;
+
+    /** @brief Copies an image to the device */
+    void upload(image_t<data_t> const& img);
+
+    /** @brief Copies the processed cube of a measurement to the device
+      *
+      * The SDK processes into host memory only, so the cube is copied after @ref ProcessingContext::apply.
+      *
+      * @throws std::runtime_error if the measurement has no cube of the data type
+      * */
+    void upload_cube(Measurement const& mesu);
+
+    /** @brief Makes the memory of an image accessible to the device without copying
+      *
+      * Keeps the owner of the image data alive until the next @ref upload or @ref map. The data must not be changed
+      * meanwhile. Without a copy, the device may read host memory at a lower rate, unless @ref backend_t::shares_host_memory.
+      * */
+    void map(image_t<data_t> const& img);
+
+    /** @brief Copies the image back to host memory
+      *
+      * @param[out] host At least @ref size elements
+      * */
+    void download(data_t* host) const;
+
+    /** @brief The device image as a host image, for mapped images or the host backend, where no copy is needed */
+    image_t<data_t> host_image() const;
+
+    std::size_t width() const { return _width; }
+    std::size_t height() const { return _height; }
+    std::size_t channels() const { return _channels; }
+
+    /** @brief Number of elements */
+    std::size_t size() const { return _width * _height * _channels; }
+
+    /** @brief The device pointer, e.g. for own kernels */
+    data_t const* data() const { return _data; }
+
+    std::vector<std::uint32_t> const& wavelength() const { return _wavelength; }
+
+    device_view_t view() const { return device_view_t{_data, _width, _height, _channels, device_impl::format_of<data_t>()}; }
+
+    backend_t& backend() const { return *_backend; }
+
+  private:
+    void release_mapping();
+    void set_shape(image_t<data_t> const& img);
+
+    std::shared_ptr<backend_t> _backend;
+
+    /* owned device memory */
+    void* _buffer = nullptr;
+    std::size_t _capacity = 0;
+
+    /* mapped host memory and its owner */
+    void const* _mapped = nullptr;
+    std::shared_ptr<void const> _mapped_owner;
+
+    data_t const* _data = nullptr;
+    std::size_t _width = 0;
+    std::size_t _height = 0;
+    std::size_t _channels = 0;
+    std::vector<std::uint32_t> _wavelength;
+  };
+
+  /** @brief Calculates the spectrum of a polygon on the device, see @ref spectral::get_spectrum_polygon */
+  template <typename data_t>
+  spectral::spectrum_t get_spectrum_polygon(device_image_t<data_t> const& img, spectral::polygon_t const& poly);
+
+  /** @brief Calculates the spectra of several polygons on the device, see @ref spectral::get_spectra_polygons */
+  template <typename data_t>
+  std::vector<spectral::spectrum_t> get_spectra_polygons(device_image_t<data_t> const& img, std::vector<spectral::polygon_t> const& polys);
+
+  /** @brief Calculates the histograms of an image on the device, see @ref spectral::get_histogram
+    *
+    * The result is identical to the one of @ref spectral::get_histogram.
+    * */
+  template <typename data_t>
+  spectral::histogram_vector_t get_histogram(
+      device_image_t<data_t> const& img, std::size_t count_bins, std::size_t wavelength_bins, bool detect_max_value, cuvis_processing_mode_t proc_mode);
+
+  /** @cond INTERNAL */
+  template <typename data_t>
+  inline device_image_t<data_t>::device_image_t(std::shared_ptr<backend_t> backend) : _backend(std::move(backend))
+  {
+    if (!_backend)
+    {
+      throw std::invalid_argument("device image requires a backend");
+    }
+  }
+
+  template <typename data_t>
+  inline device_image_t<data_t>::~device_image_t()
+  {
+    release_mapping();
+    if (_buffer != nullptr)
+    {
+      _backend->deallocate(_buffer);
+    }
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::release_mapping()
+  {
+    if (_mapped != nullptr)
+    {
+      // the device may still read the mapping
+      _backend->synchronize();
+      _backend->unmap_host(_mapped);
+      _mapped = nullptr;
+    }
+    _mapped_owner.reset();
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::set_shape(image_t<data_t> const& img)
+  {
+    _width = img._width;
+    _height = img._height;
+    _channels = img._channels;
+    if (img._wavelength != nullptr)
+    {
+      _wavelength.assign(img._wavelength, img._wavelength + img._channels);
+    }
+    else
+    {
+      _wavelength.clear();
+    }
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::upload(image_t<data_t> const& img)
+  {
+    release_mapping();
+    std::size_t const bytes = img._width * img._height * img._channels * sizeof(data_t);
+    if (bytes > _capacity)
+    {
+      // the previous contents may still be in use by the device
+      _backend->synchronize();
+      if (_buffer != nullptr)
+      {
+        _backend->deallocate(_buffer);
+        _buffer = nullptr;
+        _capacity = 0;
+      }
+      _buffer = _backend->allocate(bytes);
+      _capacity = bytes;
+    }
+    _backend->upload(_buffer, img._data, bytes);
+    _data = static_cast<data_t const*>(_buffer);
+    set_shape(img);
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::upload_cube(Measurement const& mesu)
+  {
+    auto const cube = mesu.cube<data_t>();
+    if (!cube.has_value())
+    {
+      throw std::runtime_error("measurement has no cube of the data type");
+    }
+    upload(*cube);
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::map(image_t<data_t> const& img)
+  {
+    release_mapping();
+    std::size_t const bytes = img._width * img._height * img._channels * sizeof(data_t);
+    _data = static_cast<data_t const*>(_backend->map_host(img._data, bytes));
+    _mapped = img._data;
+    _mapped_owner = img.get_owner();
+    set_shape(img);
+  }
+
+  template <typename data_t>
+  inline void device_image_t<data_t>::download(data_t* host) const
+  {
+    _backend->download(host, _data, size() * sizeof(data_t));
+  }
+
+  template <typename data_t>
+  inline image_t<data_t> device_image_t<data_t>::host_image() const
+  {
+    if (_mapped == nullptr && dynamic_cast<host_backend_t const*>(_backend.get()) == nullptr)
+    {
+      throw std::runtime_error("device image is not in host memory");
+    }
+    image_t<data_t> image{};
+    image._width = _width;
+    image._height = _height;
+    image._channels = _channels;
+    // the mapped host memory, not the device pointer of the mapping
+    image._data = _mapped != nullptr ? static_cast<data_t const*>(_mapped) : _data;
+    image._wavelength = _wavelength.empty() ? nullptr : _wavelength.data();
+    return image;
+  }
+
+  template <typename data_t>
+  inline std::vector<spectral::spectrum_t> get_spectra_polygons(device_image_t<data_t> const& img, std::vector<spectral::polygon_t> const& polys)
+  {
+    if (img.width() < 2 || img.height() < 2 || img.channels() == 0 || img.wavelength().empty())
+    {
+      throw std::invalid_argument("device image has no spectral data");
+    }
+
+    std::vector<spectral::spectrum_t> res;
+    res.reserve(polys.size());
+    span_moments_t moments;
+    for (auto const& poly : polys)
+    {
+      spectral::span_list_t const spans = spectral::rasterize_polygon(poly, img.width(), img.height());
+      res.emplace_back(img.channels());
+      if (spans.empty())
+      {
+        spectral::spectral_impl::finalize(0.0, nullptr, nullptr, nullptr, img.wavelength().data(), res.back());
+        continue;
+      }
+      img.backend().accumulate_spans(img.view(), spans, moments);
+      spectral::spectral_impl::finalize(
+          double(moments.n), moments.shift.data(), moments.sum.data(), moments.sq_sum.data(), img.wavelength().data(), res.back());
+    }
+    return res;
+  }
+
+  template <typename data_t>
+  inline spectral::spectrum_t get_spectrum_polygon(device_image_t<data_t> const& img, spectral::polygon_t const& poly)
+  {
+    return std::move(get_spectra_polygons(img, {poly}).front());
+  }
+
+  template <typename data_t>
+  inline spectral::histogram_vector_t get_histogram(
+      device_image_t<data_t> const& img, std::size_t count_bins, std::size_t wavelength_bins, bool detect_max_value, cuvis_processing_mode_t proc_mode)
+  {
+    auto const layout = spectral::make_histogram_layout(img.channels(), img.wavelength().empty() ? nullptr : img.wavelength().data(), count_bins, wavelength_bins);
+
+    std::optional<double> max_value;
+    if (!detect_max_value)
+    {
+      max_value = double(std::numeric_limits<data_t>::max());
+    }
+
+    spectral::histogram_table_t table;
+    img.backend().histogram(img.view(), layout, max_value, table);
+    return spectral::make_histogram_vector(layout, table, proc_mode);
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::device
@@ -0,0 +1,437 @@
+#pragma once
+
+/** @file cuvis_device_cuda.cuh
+  *
+  *
+  * @details CUDA backend of the device images, must be compiled by nvcc. Requires compute capability 6.0 or later.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include <cuvis_device.hpp>
+
+namespace cuvis::aux::device
+{
+  /** @cond INTERNAL */
+  namespace cuda_impl
+  {
+    inline void check(cudaError_t error)
+    {
+      if (error != cudaSuccess)
+      {
+        throw std::runtime_error(cudaGetErrorString(error));
+      }
+    }
+
+    /* a span as element offset of its first pixel and its number of pixels */
+    struct device_span_t
+    {
+      std::uint64_t offset;
+      std::uint64_t pixels;
+    };
+
+    /* device memory grown on demand and reused by later calls */
+    class scratch_t
+    {
+    public:
+      scratch_t() = default;
+      scratch_t(scratch_t const&) = delete;
+      scratch_t& operator=(scratch_t const&) = delete;
+      ~scratch_t()
+      {
+        if (_data != nullptr)
+        {
+          cudaFree(_data);
+        }
+      }
+
+      template <typename value_t>
+      value_t* reserve(std::size_t count)
+      {
+        std::size_t const bytes = count * sizeof(value_t);
+        if (bytes > _capacity)
+        {
+          if (_data != nullptr)
+          {
+            check(cudaFree(_data));
+            _data = nullptr;
+            _capacity = 0;
+          }
+          check(cudaMalloc(&_data, bytes));
+          _capacity = bytes;
+        }
+        return static_cast<value_t*>(_data);
+      }
+
+    private:
+      void* _data = nullptr;
+      std::size_t _capacity = 0;
+    };
+
+    constexpr unsigned block_size = 256;
+
+    /* the shared memory available to a block without opting in */
+    constexpr std::size_t shared_limit = 48 * 1024;
+
+    /* one block per span, sums per channel relative to the shift */
+    template <typename data_t>
+    __global__ void accumulate_spans_kernel(
+        data_t const* data, std::size_t channels, device_span_t const* spans, double const* shift, double* sum, double* sq_sum, bool use_shared)
+    {
+      extern __shared__ double shared_sums[];
+      double* block_sum = use_shared ? shared_sums : sum;
+      double* block_sq_sum = use_shared ? shared_sums + channels : sq_sum;
+      if (use_shared)
+      {
+        for (std::size_t c = threadIdx.x; c < 2 * channels; c += blockDim.x)
+        {
+          shared_sums[c] = 0.0;
+        }
+        __syncthreads();
+      }
+
+      // the channel vectors of all pixels of a span are contiguous
+      device_span_t const span = spans[blockIdx.x];
+      data_t const* first = data + span.offset;
+      std::size_t const count = std::size_t(span.pixels) * channels;
+      for (std::size_t i = threadIdx.x; i < count; i += blockDim.x)
+      {
+        std::size_t const c = i % channels;
+        double const value = double(first[i]) - shift[c];
+        atomicAdd(&block_sum[c], value);
+        atomicAdd(&block_sq_sum[c], value * value);
+      }
+
+      if (use_shared)
+      {
+        __syncthreads();
+        for (std::size_t c = threadIdx.x; c < channels; c += blockDim.x)
+        {
+          atomicAdd(&sum[c], block_sum[c]);
+          atomicAdd(&sq_sum[c], block_sq_sum[c]);
+        }
+      }
+    }
+
+    /* max value of each block */
+    template <typename data_t>
+    __global__ void max_kernel(data_t const* data, std::size_t count, double* block_max)
+    {
+      extern __shared__ double shared_max[];
+      double max_value = -DBL_MAX;
+      for (std::size_t i = std::size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < count; i += std::size_t(gridDim.x) * blockDim.x)
+      {
+        max_value = fmax(max_value, double(data[i]));
+      }
+      shared_max[threadIdx.x] = max_value;
+      __syncthreads();
+      for (unsigned step = blockDim.x / 2; step > 0; step /= 2)
+      {
+        if (threadIdx.x < step)
+        {
+          shared_max[threadIdx.x] = fmax(shared_max[threadIdx.x], shared_max[threadIdx.x + step]);
+        }
+        __syncthreads();
+      }
+      if (threadIdx.x == 0)
+      {
+        block_max[blockIdx.x] = shared_max[0];
+      }
+    }
+
+    /* counts the used channels into the histograms, with the binning of spectral::histogram_impl::binning_t */
+    template <typename data_t>
+    __global__ void histogram_kernel(
+        data_t const* data,
+        std::size_t pixels,
+        std::size_t channels,
+        std::size_t used_channels,
+        std::size_t channels_per_histogram,
+        std::size_t count_bins,
+        double max_value,
+        double scale,
+        unsigned long long* table,
+        std::size_t table_size,
+        bool use_shared)
+    {
+      extern __shared__ unsigned int shared_table[];
+      if (use_shared)
+      {
+        for (std::size_t slot = threadIdx.x; slot < table_size; slot += blockDim.x)
+        {
+          shared_table[slot] = 0;
+        }
+        __syncthreads();
+      }
+
+      // each histogram has an extra slot at the end for out of range values
+      std::size_t const stride = count_bins + 1;
+      std::size_t const total = pixels * used_channels;
+      for (std::size_t i = std::size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < total; i += std::size_t(gridDim.x) * blockDim.x)
+      {
+        std::size_t const p = i / used_channels;
+        std::size_t const c = i - p * used_channels;
+        double const value = double(data[p * channels + c]);
+        std::size_t bin = count_bins;
+        if (value >= 0.0 && value <= max_value)
+        {
+          bin = static_cast<std::size_t>(value * scale);
+          bin = bin < count_bins - 1 ? bin : count_bins - 1;
+        }
+        std::size_t const slot = (c / channels_per_histogram) * stride + bin;
+        if (use_shared)
+        {
+          atomicAdd(&shared_table[slot], 1u);
+        }
+        else
+        {
+          atomicAdd(&table[slot], 1ull);
+        }
+      }
+
+      if (use_shared)
+      {
+        __syncthreads();
+        for (std::size_t slot = threadIdx.x; slot < table_size; slot += blockDim.x)
+        {
+          if (shared_table[slot] != 0)
+          {
+            atomicAdd(&table[slot], (unsigned long long)shared_table[slot]);
+          }
+        }
+      }
+    }
+  } // namespace cuda_impl
+  /** @endcond */
+
+  /** @brief Backend running on a CUDA device
+    *
+    * All operations are issued to the stream of the backend. Own kernels working on a @ref device_image_t should use
+    * @ref stream, so they are ordered with the operations of the backend.
+    *
+    * The spectra are equal to the ones of the host backend up to floating point rounding, as the sums are accumulated
+    * in a different order. The histograms are identical.
+    * */
+  class cuda_backend_t : public backend_t
+  {
+  public:
+    /** @param[in] device The CUDA device ordinal */
+    explicit cuda_backend_t(int device = 0) : _device(device)
+    {
+      cuda_impl::check(cudaSetDevice(_device));
+      int integrated = 0;
+      cuda_impl::check(cudaDeviceGetAttribute(&integrated, cudaDevAttrIntegrated, _device));
+      _integrated = integrated != 0;
+      cuda_impl::check(cudaDeviceGetAttribute(&_multiprocessors, cudaDevAttrMultiProcessorCount, _device));
+      cuda_impl::check(cudaStreamCreateWithFlags(&_stream, cudaStreamNonBlocking));
+    }
+
+    ~cuda_backend_t() override
+    {
+      cudaSetDevice(_device);
+      cudaStreamSynchronize(_stream);
+      cudaStreamDestroy(_stream);
+    }
+
+    cuda_backend_t(cuda_backend_t const&) = delete;
+    cuda_backend_t& operator=(cuda_backend_t const&) = delete;
+
+    /** @brief The stream of the backend */
+    cudaStream_t stream() const { return _stream; }
+
+    int device() const { return _device; }
+
+    char const* name() const override { return "cuda"; }
+    bool shares_host_memory() const override { return _integrated; }
+
+    void* allocate(std::size_t bytes) override
+    {
+      activate();
+      void* data = nullptr;
+      cuda_impl::check(cudaMalloc(&data, bytes));
+      return data;
+    }
+
+    void deallocate(void* data) noexcept override
+    {
+      cudaSetDevice(_device);
+      cudaFree(data);
+    }
+
+    void upload(void* device, void const* host, std::size_t bytes) override
+    {
+      activate();
+      cuda_impl::check(cudaMemcpyAsync(device, host, bytes, cudaMemcpyHostToDevice, _stream));
+      // the host memory may be page-locked, where the copy returns before it is done
+      cuda_impl::check(cudaStreamSynchronize(_stream));
+    }
+
+    void download(void* host, void const* device, std::size_t bytes) override
+    {
+      activate();
+      cuda_impl::check(cudaMemcpyAsync(host, device, bytes, cudaMemcpyDeviceToHost, _stream));
+      cuda_impl::check(cudaStreamSynchronize(_stream));
+    }
+
+    void* map_host(void const* host, std::size_t bytes) override
+    {
+      activate();
+      void* mutable_host = const_cast<void*>(host);
+      cuda_impl::check(cudaHostRegister(mutable_host, bytes, cudaHostRegisterMapped));
+      void* device = nullptr;
+      cudaError_t const error = cudaHostGetDevicePointer(&device, mutable_host, 0);
+      if (error != cudaSuccess)
+      {
+        cudaHostUnregister(mutable_host);
+        cuda_impl::check(error);
+      }
+      return device;
+    }
+
+    void unmap_host(void const* host) noexcept override
+    {
+      cudaSetDevice(_device);
+      cudaHostUnregister(const_cast<void*>(host));
+    }
+
+    void synchronize() override
+    {
+      activate();
+      cuda_impl::check(cudaStreamSynchronize(_stream));
+    }
+
+    void accumulate_spans(device_view_t const& img, spectral::span_list_t const& spans, span_moments_t& moments) override
+    {
+      activate();
+      std::size_t const channels = img.channels;
+      moments.n = 0;
+      moments.shift.assign(channels, 0.0);
+      moments.sum.assign(channels, 0.0);
+      moments.sq_sum.assign(channels, 0.0);
+      if (spans.empty())
+      {
+        return;
+      }
+
+      _spans.clear();
+      for (auto const& span : spans)
+      {
+        std::uint64_t const pixels = span.x_end - span.x_begin;
+        _spans.push_back(cuda_impl::device_span_t{(span.y * img.width + span.x_begin) * channels, pixels});
+        moments.n += pixels;
+      }
+
+      device_impl::visit_format(img.format, [&](auto typed) {
+        using data_t = std::remove_const_t<std::remove_pointer_t<decltype(typed)>>;
+        data_t const* data = static_cast<data_t const*>(img.data);
+
+        // the shift is the first covered pixel, as for the host backend
+        std::vector<data_t> first_pixel(channels);
+        cuda_impl::check(cudaMemcpyAsync(first_pixel.data(), data + _spans.front().offset, channels * sizeof(data_t), cudaMemcpyDeviceToHost, _stream));
+        cuda_impl::check(cudaStreamSynchronize(_stream));
+        for (std::size_t c = 0; c < channels; c++)
+        {
+          moments.shift[c] = double(first_pixel[c]);
+        }
+
+        auto* spans_device = _span_scratch.reserve<cuda_impl::device_span_t>(_spans.size());
+        auto* shift_device = _shift_scratch.reserve<double>(channels);
+        auto* sums_device = _sum_scratch.reserve<double>(2 * channels);
+        cuda_impl::check(cudaMemcpyAsync(spans_device, _spans.data(), _spans.size() * sizeof(cuda_impl::device_span_t), cudaMemcpyHostToDevice, _stream));
+        cuda_impl::check(cudaMemcpyAsync(shift_device, moments.shift.data(), channels * sizeof(double), cudaMemcpyHostToDevice, _stream));
+        cuda_impl::check(cudaMemsetAsync(sums_device, 0, 2 * channels * sizeof(double), _stream));
+
+        std::size_t const shared_bytes = 2 * channels * sizeof(double);
+        bool const use_shared = shared_bytes <= cuda_impl::shared_limit;
+        cuda_impl::accumulate_spans_kernel<data_t><<<unsigned(_spans.size()), cuda_impl::block_size, use_shared ? shared_bytes : 0, _stream>>>(
+            data, channels, spans_device, shift_device, sums_device, sums_device + channels, use_shared);
+        cuda_impl::check(cudaGetLastError());
+
+        cuda_impl::check(cudaMemcpyAsync(moments.sum.data(), sums_device, channels * sizeof(double), cudaMemcpyDeviceToHost, _stream));
+        cuda_impl::check(cudaMemcpyAsync(moments.sq_sum.data(), sums_device + channels, channels * sizeof(double), cudaMemcpyDeviceToHost, _stream));
+        cuda_impl::check(cudaStreamSynchronize(_stream));
+      });
+    }
+
+    void histogram(device_view_t const& img, spectral::histogram_layout_t const& layout, std::optional<double> max_value, spectral::histogram_table_t& res) override
+    {
+      activate();
+      std::size_t const pixels = img.width * img.height;
+      std::size_t const used_channels = layout.histogram_count * layout.channels_per_histogram;
+      std::size_t const stride = layout.count_bins + 1;
+      std::size_t const table_size = layout.histogram_count * stride;
+
+      device_impl::visit_format(img.format, [&](auto typed) {
+        using data_t = std::remove_const_t<std::remove_pointer_t<decltype(typed)>>;
+        data_t const* data = static_cast<data_t const*>(img.data);
+
+        // per block counters are 32 bit, so no block counts more than 2^31 values
+        std::size_t const total = pixels * used_channels;
+        unsigned const blocks = unsigned(std::max<std::size_t>(std::size_t(_multiprocessors) * 4, total / (std::size_t(1) << 31) + 1));
+
+        if (max_value)
+        {
+          res.max_value = *max_value;
+        }
+        else
+        {
+          auto* block_max_device = _max_scratch.reserve<double>(blocks);
+          cuda_impl::max_kernel<data_t><<<blocks, cuda_impl::block_size, cuda_impl::block_size * sizeof(double), _stream>>>(
+              data, pixels * img.channels, block_max_device);
+          cuda_impl::check(cudaGetLastError());
+          std::vector<double> block_max(blocks);
+          cuda_impl::check(cudaMemcpyAsync(block_max.data(), block_max_device, blocks * sizeof(double), cudaMemcpyDeviceToHost, _stream));
+          cuda_impl::check(cudaStreamSynchronize(_stream));
+          res.max_value = pixels * img.channels > 0 ? *std::max_element(block_max.begin(), block_max.end()) : 0.0;
+        }
+
+        auto* table_device = _table_scratch.reserve<unsigned long long>(table_size);
+        cuda_impl::check(cudaMemsetAsync(table_device, 0, table_size * sizeof(unsigned long long), _stream));
+
+        spectral::histogram_impl::binning_t const binning(res.max_value, layout.count_bins);
+        std::size_t const shared_bytes = table_size * sizeof(unsigned int);
+        bool const use_shared = shared_bytes <= cuda_impl::shared_limit;
+        cuda_impl::histogram_kernel<data_t><<<blocks, cuda_impl::block_size, use_shared ? shared_bytes : 0, _stream>>>(
+            data, pixels, img.channels, used_channels, layout.channels_per_histogram, layout.count_bins, binning.max_value, binning.scale, table_device, table_size, use_shared);
+        cuda_impl::check(cudaGetLastError());
+
+        std::vector<unsigned long long> table(table_size);
+        cuda_impl::check(cudaMemcpyAsync(table.data(), table_device, table_size * sizeof(unsigned long long), cudaMemcpyDeviceToHost, _stream));
+        cuda_impl::check(cudaStreamSynchronize(_stream));
+
+        res.occurrence.assign(layout.histogram_count * layout.count_bins, 0);
+        for (std::size_t h = 0; h < layout.histogram_count; h++)
+        {
+          for (std::size_t b = 0; b < layout.count_bins; b++)
+          {
+            res.occurrence[h * layout.count_bins + b] = table[h * stride + b];
+          }
+        }
+      });
+    }
+
+  private:
+    void activate() const { cuda_impl::check(cudaSetDevice(_device)); }
+
+    int _device;
+    bool _integrated = false;
+    int _multiprocessors = 1;
+    cudaStream_t _stream = nullptr;
+
+    std::vector<cuda_impl::device_span_t> _spans;
+    cuda_impl::scratch_t _span_scratch;
+    cuda_impl::scratch_t _shift_scratch;
+    cuda_impl::scratch_t _sum_scratch;
+    cuda_impl::scratch_t _max_scratch;
+    cuda_impl::scratch_t _table_scratch;
+  };
+
+} // namespace cuvis::aux::device
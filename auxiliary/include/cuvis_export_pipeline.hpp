@@ -0,0 +1,487 @@
+#pragma once
+
+/** @file cuvis_export_pipeline.hpp
+  *
+  *
+  * @details Parallel export of measurements with several exporters and a bounded memory budget.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <cuvis.hpp>
+
+/**
+  * @brief Export of measurements.
+  * */
+namespace cuvis::aux::exporting
+{
+  /** @brief Statistics of a single exporter lane */
+  struct lane_stats_t
+  {
+    /** Number of exported measurements.*/
+    std::size_t frames = 0;
+
+    /** Estimated number of exported bytes.*/
+    std::size_t bytes = 0;
+
+    /** Number of measurements whose export failed.*/
+    std::size_t errors = 0;
+
+    /** Time spent in the exporter.*/
+    std::chrono::nanoseconds busy = std::chrono::nanoseconds(0);
+
+    /** Exported bytes per second of busy time.*/
+    double bytes_per_second() const { return busy.count() > 0 ? double(bytes) * 1e9 / double(busy.count()) : 0.0; }
+
+    /** Exported measurements per second of busy time.*/
+    double frames_per_second() const { return busy.count() > 0 ? double(frames) * 1e9 / double(busy.count()) : 0.0; }
+  };
+
+  /** @brief Statistics of an @ref export_pipeline_t */
+  struct pipeline_stats_t
+  {
+    std::vector<lane_stats_t> lanes;
+
+    /** Number of accepted measurements.*/
+    std::size_t submitted = 0;
+
+    /** Number of measurements dropped because the budget was exhausted.*/
+    std::size_t dropped = 0;
+
+    /** Measurements and bytes accepted but not exported yet.*/
+    std::size_t frames_in_flight = 0;
+    std::size_t bytes_in_flight = 0;
+
+    /** Time since the pipeline was created.*/
+    std::chrono::nanoseconds elapsed = std::chrono::nanoseconds(0);
+
+    /** Exported bytes per second of wall time, over all lanes.*/
+    double bytes_per_second() const
+    {
+      std::size_t bytes = 0;
+      for (auto const& lane : lanes)
+      {
+        bytes += lane.bytes;
+      }
+      return elapsed.count() > 0 ? double(bytes) * 1e9 / double(elapsed.count()) : 0.0;
+    }
+  };
+
+  /** @brief Settings of an @ref export_pipeline_t */
+  struct pipeline_settings_t
+  {
+    /** Number of exporters, each driven by its own thread.*/
+    std::size_t lane_count = 2;
+
+    /** Upper limit of the estimated bytes of all accepted, not yet exported measurements.
+      * A single measurement above the limit is accepted while nothing else is in flight.*/
+    std::size_t max_bytes_in_flight = std::size_t(1) << 30;
+
+    /** Upper limit of accepted, not yet exported measurements, 0 for no limit.*/
+    std::size_t max_frames_in_flight = 0;
+
+    /** Drop measurements instead of waiting, when the budget is exhausted.*/
+    bool drop_when_full = false;
+
+    /** Number of measurements an exporter may queue internally before its lane flushes it.
+      * Measurements queued within the SDK are not counted in the budget.*/
+    std::size_t sdk_queue_limit = 0;
+
+    /** Estimated size of a measurement in bytes, by default the size of all its images.*/
+    std::function<std::size_t(Measurement const&)> byte_estimate;
+
+    /** Called with exceptions of the exporters, from the lane thread.*/
+    std::function<void(std::exception_ptr)> error_callback;
+  };
+
+  /** @cond INTERNAL */
+  namespace exporting_impl
+  {
+    inline std::size_t image_bytes(Measurement const& mesu)
+    {
+      std::size_t bytes = 0;
+      for (auto const& entry : *mesu.get_image_table())
+      {
+        std::visit(
+            [&bytes](auto const& image) { bytes += image._width * image._height * image._channels * sizeof(*image._data); },
+            entry.image);
+      }
+      return bytes;
+    }
+
+    /* threads of exporter lanes with the flush and close protocol shared by the export pipeline and the fan-out exporter
+       the owner guards its state with mutex(), has_work, work and drained are called with the lock held and work returns with it held */
+    class lane_group_t
+    {
+    public:
+      using has_work_t = std::function<bool(std::size_t lane)>;
+      using work_t = std::function<void(std::size_t lane, std::unique_lock<std::mutex>& lock)>;
+      using flush_t = std::function<void(std::size_t lane)>;
+      using drained_t = std::function<bool()>;
+
+      lane_group_t() = default;
+      ~lane_group_t() { close(); }
+
+      lane_group_t(lane_group_t const&) = delete;
+      lane_group_t& operator=(lane_group_t const&) = delete;
+
+      void start(std::size_t lane_count, has_work_t has_work, work_t work, flush_t flush_lane, drained_t drained)
+      {
+        _has_work = std::move(has_work);
+        _do_work = std::move(work);
+        _flush_lane = std::move(flush_lane);
+        _drained = std::move(drained);
+        _flushed.assign(lane_count, 0);
+        _threads.reserve(lane_count);
+        for (std::size_t lane = 0; lane < lane_count; lane++)
+        {
+          _threads.emplace_back(&lane_group_t::run, this, lane);
+        }
+      }
+
+      /* waits until the lanes are drained and every lane flushed, returns at once after close */
+      void flush()
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_closed || _threads.empty())
+        {
+          // close exported and flushed everything, the lanes are stopped
+          return;
+        }
+        std::size_t const request = ++_flush_requests;
+        _work.notify_all();
+        _done.wait(lock, [&] {
+          return _closed || (_drained() && std::all_of(_flushed.begin(), _flushed.end(), [request](std::size_t flushed) { return flushed >= request; }));
+        });
+      }
+
+      /* flushes and stops the lanes */
+      void close()
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (_closed)
+          {
+            return;
+          }
+        }
+        flush();
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _closed = true;
+        }
+        _work.notify_all();
+        _space.notify_all();
+        _done.notify_all();
+        for (auto& thread : _threads)
+        {
+          thread.join();
+        }
+      }
+
+      /* requires the lock */
+      bool closed() const { return _closed; }
+
+      std::mutex& mutex() const { return _mutex; }
+
+      /* notified when work is queued */
+      std::condition_variable& work() { return _work; }
+
+      /* notified when queued work is taken and on close */
+      std::condition_variable& space() { return _space; }
+
+      /* notified when work or a flush completes and on close */
+      std::condition_variable& done() { return _done; }
+
+    private:
+      void run(std::size_t lane)
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+          _work.wait(lock, [&] { return _closed || _flushed[lane] < _flush_requests || _has_work(lane); });
+          if (_has_work(lane))
+          {
+            _do_work(lane, lock);
+            continue;
+          }
+          if (_flushed[lane] < _flush_requests)
+          {
+            // all work is taken, flush the exporter for a pending flush request
+            std::size_t const request = _flush_requests;
+            lock.unlock();
+            _flush_lane(lane);
+            lock.lock();
+            _flushed[lane] = request;
+            _done.notify_all();
+            continue;
+          }
+          if (_closed)
+          {
+            return;
+          }
+        }
+      }
+
+      has_work_t _has_work;
+      work_t _do_work;
+      flush_t _flush_lane;
+      drained_t _drained;
+
+      mutable std::mutex _mutex;
+      std::condition_variable _work;
+      std::condition_variable _space;
+      std::condition_variable _done;
+      std::size_t _flush_requests = 0;
+      std::vector<std::size_t> _flushed;
+      bool _closed = false;
+
+      std::vector<std::thread> _threads;
+    };
+  } // namespace exporting_impl
+  /** @endcond */
+
+  /** @brief Exports measurements with several exporters in parallel
+    *
+    * Every lane owns an exporter created by the factory and takes the next measurement from a shared queue,
+    * so encoding and writing of several measurements overlap. A lane flushes its exporter whenever the exporter queues
+    * more than @ref pipeline_settings_t::sdk_queue_limit measurements. The memory of waiting measurements is bounded by
+    * @ref pipeline_settings_t::max_bytes_in_flight. Measurements are exported in any order.
+    * */
+  class export_pipeline_t
+  {
+  public:
+    /** @brief Creates the exporter of a lane, e.g. a @ref TiffExporter */
+    using exporter_factory_t = std::function<std::unique_ptr<Exporter>(std::size_t lane)>;
+
+    /** @brief Creates the exporters and starts the lanes
+      *
+      * @param[in] factory Creates the exporter of every lane
+      * @param[in] settings The settings
+      * */
+    export_pipeline_t(exporter_factory_t const& factory, pipeline_settings_t settings);
+
+    /** @brief Calls @ref close */
+    ~export_pipeline_t();
+
+    export_pipeline_t(export_pipeline_t const&) = delete;
+    export_pipeline_t& operator=(export_pipeline_t const&) = delete;
+
+    /** @brief Submits a measurement, waits while the budget is exhausted
+      *
+      * @return false, if the measurement was dropped, see @ref pipeline_settings_t::drop_when_full
+      * */
+    bool submit(Measurement&& mesu);
+
+    /** @brief Submits a measurement shared with other users, which must not modify it during the export */
+    bool submit(std::shared_ptr<Measurement const> mesu);
+
+    /** @brief Waits until all submitted measurements are exported and flushes all exporters
+      *
+      * Returns at once after @ref close, which already exported and flushed everything.
+      * */
+    void flush();
+
+    /** @brief Exports the remaining measurements and stops the lanes, further submissions are rejected */
+    void close();
+
+    pipeline_stats_t stats() const;
+
+  private:
+    struct item_t
+    {
+      std::shared_ptr<Measurement const> mesu;
+      std::size_t bytes;
+    };
+
+    void export_next(std::size_t lane, std::unique_lock<std::mutex>& lock);
+
+    void flush_lane(std::size_t lane);
+
+    void report(std::exception_ptr error) const;
+
+    pipeline_settings_t _settings;
+    std::vector<std::unique_ptr<Exporter>> _exporters;
+    std::chrono::steady_clock::time_point _start;
+
+    /* guarded by the mutex of the lanes */
+    std::deque<item_t> _queue;
+    std::size_t _frames_in_flight = 0;
+    std::size_t _bytes_in_flight = 0;
+    std::size_t _submitted = 0;
+    std::size_t _dropped = 0;
+    std::vector<lane_stats_t> _lane_stats;
+
+    /* stopped first, while the exporters still exist */
+    exporting_impl::lane_group_t _lanes;
+  };
+
+  /** @cond INTERNAL */
+  inline export_pipeline_t::export_pipeline_t(exporter_factory_t const& factory, pipeline_settings_t settings)
+      : _settings(std::move(settings)), _start(std::chrono::steady_clock::now())
+  {
+    std::size_t const lane_count = std::max<std::size_t>(_settings.lane_count, 1);
+    if (!_settings.byte_estimate)
+    {
+      _settings.byte_estimate = exporting_impl::image_bytes;
+    }
+
+    _exporters.reserve(lane_count);
+    for (std::size_t lane = 0; lane < lane_count; lane++)
+    {
+      _exporters.push_back(factory(lane));
+      if (!_exporters.back())
+      {
+        throw std::invalid_argument("exporter factory returned no exporter");
+      }
+    }
+    _lane_stats.resize(lane_count);
+
+    _lanes.start(
+        lane_count,
+        [this](std::size_t) { return !_queue.empty(); },
+        [this](std::size_t lane, std::unique_lock<std::mutex>& lock) { export_next(lane, lock); },
+        [this](std::size_t lane) { flush_lane(lane); },
+        [this] { return _frames_in_flight == 0; });
+  }
+
+  inline export_pipeline_t::~export_pipeline_t() { close(); }
+
+  inline bool export_pipeline_t::submit(Measurement&& mesu) { return submit(std::make_shared<Measurement const>(std::move(mesu))); }
+
+  inline bool export_pipeline_t::submit(std::shared_ptr<Measurement const> mesu)
+  {
+    std::size_t const bytes = _settings.byte_estimate(*mesu);
+
+    std::unique_lock<std::mutex> lock(_lanes.mutex());
+    auto has_room = [&] {
+      if (_frames_in_flight == 0)
+      {
+        return true;
+      }
+      bool const frames_ok = _settings.max_frames_in_flight == 0 || _frames_in_flight < _settings.max_frames_in_flight;
+      return frames_ok && _bytes_in_flight + bytes <= _settings.max_bytes_in_flight;
+    };
+
+    if (_settings.drop_when_full && !has_room())
+    {
+      _dropped++;
+      return false;
+    }
+    _lanes.space().wait(lock, [&] { return _lanes.closed() || has_room(); });
+    if (_lanes.closed())
+    {
+      throw std::runtime_error("export pipeline is closed");
+    }
+
+    _frames_in_flight++;
+    _bytes_in_flight += bytes;
+    _submitted++;
+    _queue.push_back(item_t{std::move(mesu), bytes});
+    lock.unlock();
+    _lanes.work().notify_one();
+    return true;
+  }
+
+  inline void export_pipeline_t::report(std::exception_ptr error) const
+  {
+    if (_settings.error_callback)
+    {
+      try
+      {
+        _settings.error_callback(error);
+      }
+      catch (...)
+      {}
+    }
+  }
+
+  inline void export_pipeline_t::export_next(std::size_t lane, std::unique_lock<std::mutex>& lock)
+  {
+    item_t item = std::move(_queue.front());
+    _queue.pop_front();
+    lock.unlock();
+
+    Exporter& exporter = *_exporters[lane];
+    auto const begin = std::chrono::steady_clock::now();
+    bool failed = false;
+    try
+    {
+      exporter.apply(*item.mesu);
+      if (exporter.get_queue_used() > _settings.sdk_queue_limit)
+      {
+        exporter.flush();
+      }
+    }
+    catch (...)
+    {
+      failed = true;
+      report(std::current_exception());
+    }
+    auto const busy = std::chrono::steady_clock::now() - begin;
+    item.mesu.reset();
+
+    lock.lock();
+    lane_stats_t& stats = _lane_stats[lane];
+    stats.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(busy);
+    if (failed)
+    {
+      stats.errors++;
+    }
+    else
+    {
+      stats.frames++;
+      stats.bytes += item.bytes;
+    }
+    _frames_in_flight--;
+    _bytes_in_flight -= item.bytes;
+    _lanes.space().notify_all();
+    _lanes.done().notify_all();
+  }
+
+  inline void export_pipeline_t::flush_lane(std::size_t lane)
+  {
+    try
+    {
+      _exporters[lane]->flush();
+    }
+    catch (...)
+    {
+      report(std::current_exception());
+    }
+  }
+
+  inline void export_pipeline_t::flush() { _lanes.flush(); }
+
+  inline void export_pipeline_t::close() { _lanes.close(); }
+
+  inline pipeline_stats_t export_pipeline_t::stats() const
+  {
+    std::lock_guard<std::mutex> lock(_lanes.mutex());
+    pipeline_stats_t stats;
+    stats.lanes = _lane_stats;
+    stats.submitted = _submitted;
+    stats.dropped = _dropped;
+    stats.frames_in_flight = _frames_in_flight;
+    stats.bytes_in_flight = _bytes_in_flight;
+    stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+    return stats;
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::exporting
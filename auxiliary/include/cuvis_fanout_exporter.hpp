@@ -0,0 +1,298 @@
+#pragma once
+
+/** @file cuvis_fanout_exporter.hpp
+  *
+  *
+  * @details Export of every measurement to several exporters in parallel.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <cuvis.hpp>
+#include <cuvis_export_pipeline.hpp>
+
+namespace cuvis::aux::exporting
+{
+  /** @brief Settings of a @ref fanout_exporter_t */
+  struct fanout_settings_t
+  {
+    /** Number of measurements a sink may lag behind the submissions.*/
+    std::size_t queue_size = 4;
+
+    /** Drop measurements instead of waiting, when a sink lags behind by @ref queue_size measurements.*/
+    bool drop_when_full = false;
+
+    /** Called with exceptions of the sinks for submitted measurements and flushes, from the sink thread.*/
+    std::function<void(std::size_t sink, std::exception_ptr)> error_callback;
+  };
+
+  /** @brief Exports every measurement with several exporters (sinks) in parallel
+    *
+    * Every sink is driven by its own thread and receives the measurements in the order of submission.
+    * All sinks share the same measurement, it is neither copied nor converted in between, so e.g. a @ref CubeExporter,
+    * a @ref ViewExporter and a @ref TiffExporter run side by side instead of one after the other.
+    *
+    * To export the results of a @ref Worker, call @ref submit from the worker callback, keeping the mandatory exporter
+    * at @ref Worker::set_exporter if needed.
+    * */
+  class fanout_exporter_t
+  {
+  public:
+    /** @brief Starts a thread for every sink
+      *
+      * @param[in] sinks The exporters
+      * @param[in] settings The settings
+      * */
+    fanout_exporter_t(std::vector<std::unique_ptr<Exporter>> sinks, fanout_settings_t settings = fanout_settings_t());
+
+    /** @brief Calls @ref close */
+    ~fanout_exporter_t();
+
+    fanout_exporter_t(fanout_exporter_t const&) = delete;
+    fanout_exporter_t& operator=(fanout_exporter_t const&) = delete;
+
+    /** @brief Exports the measurement with all sinks and waits until they are done
+      *
+      * Rethrows the first exception of the sinks, after all sinks finished.
+      * */
+    Measurement const& apply(Measurement const& mesu);
+
+    /** @brief Submits a measurement to all sinks without waiting for the export
+      *
+      * The measurement must not be modified until it is released by all sinks.
+      * Waits while a sink lags behind by @ref fanout_settings_t::queue_size measurements.
+      *
+      * @return false, if the measurement was dropped, see @ref fanout_settings_t::drop_when_full
+      * */
+    bool submit(std::shared_ptr<Measurement const> mesu);
+
+    /** @brief Submits a measurement to all sinks, see @ref submit */
+    bool submit(Measurement&& mesu);
+
+    /** @brief Waits until all submitted measurements are exported and flushes all sinks
+      *
+      * Returns at once after @ref close, which already exported and flushed everything.
+      * */
+    void flush();
+
+    /** @brief Exports the remaining measurements and stops the sink threads, further submissions are rejected */
+    void close();
+
+    /** @brief Number of sinks */
+    std::size_t size() const { return _sinks.size(); }
+
+    /** @brief Access to a sink, e.g. to query its queue */
+    Exporter& sink(std::size_t index) { return *_sinks.at(index); }
+
+    /** @brief Statistics of every sink, bytes are not counted */
+    std::vector<lane_stats_t> stats() const;
+
+  private:
+    /* completion of a synchronous apply */
+    struct ticket_t
+    {
+      std::size_t remaining;
+      std::exception_ptr error;
+    };
+
+    struct item_t
+    {
+      std::shared_ptr<Measurement const> mesu;
+      std::shared_ptr<ticket_t> ticket;
+    };
+
+    struct sink_state_t
+    {
+      std::deque<item_t> queue;
+      lane_stats_t stats;
+    };
+
+    bool enqueue(item_t const& item, bool may_drop);
+
+    void export_next(std::size_t sink, std::unique_lock<std::mutex>& lock);
+
+    void flush_sink(std::size_t sink);
+
+    void report(std::size_t sink, std::exception_ptr error) const;
+
+    std::vector<std::unique_ptr<Exporter>> _sinks;
+    fanout_settings_t _settings;
+
+    /* guarded by the mutex of the lanes */
+    std::vector<sink_state_t> _states;
+
+    /* stopped first, while the sinks still exist */
+    exporting_impl::lane_group_t _lanes;
+  };
+
+  /** @cond INTERNAL */
+  inline fanout_exporter_t::fanout_exporter_t(std::vector<std::unique_ptr<Exporter>> sinks, fanout_settings_t settings)
+      : _sinks(std::move(sinks)), _settings(std::move(settings))
+  {
+    if (_sinks.empty())
+    {
+      throw std::invalid_argument("fan-out exporter requires at least one sink");
+    }
+    if (std::any_of(_sinks.begin(), _sinks.end(), [](std::unique_ptr<Exporter> const& sink) { return !sink; }))
+    {
+      throw std::invalid_argument("fan-out exporter sink must not be empty");
+    }
+    _settings.queue_size = std::max<std::size_t>(_settings.queue_size, 1);
+    _states.resize(_sinks.size());
+
+    // an item stays queued while its sink exports it, so the queue size counts the measurements the sink holds
+    _lanes.start(
+        _sinks.size(),
+        [this](std::size_t sink) { return !_states[sink].queue.empty(); },
+        [this](std::size_t sink, std::unique_lock<std::mutex>& lock) { export_next(sink, lock); },
+        [this](std::size_t sink) { flush_sink(sink); },
+        [this] { return std::all_of(_states.begin(), _states.end(), [](sink_state_t const& state) { return state.queue.empty(); }); });
+  }
+
+  inline fanout_exporter_t::~fanout_exporter_t() { close(); }
+
+  inline bool fanout_exporter_t::enqueue(item_t const& item, bool may_drop)
+  {
+    std::unique_lock<std::mutex> lock(_lanes.mutex());
+    auto has_room = [this] {
+      return std::all_of(_states.begin(), _states.end(), [this](sink_state_t const& state) { return state.queue.size() < _settings.queue_size; });
+    };
+
+    if (may_drop && !has_room())
+    {
+      return false;
+    }
+    _lanes.space().wait(lock, [&] { return _lanes.closed() || has_room(); });
+    if (_lanes.closed())
+    {
+      throw std::runtime_error("fan-out exporter is closed");
+    }
+    for (auto& state : _states)
+    {
+      state.queue.push_back(item);
+    }
+    lock.unlock();
+    _lanes.work().notify_all();
+    return true;
+  }
+
+  inline Measurement const& fanout_exporter_t::apply(Measurement const& mesu)
+  {
+    // the caller keeps the measurement alive until all sinks are done
+    auto ticket = std::make_shared<ticket_t>(ticket_t{_sinks.size(), nullptr});
+    enqueue(item_t{std::shared_ptr<Measurement const>(&mesu, [](Measurement const*) {}), ticket}, false);
+
+    std::unique_lock<std::mutex> lock(_lanes.mutex());
+    _lanes.done().wait(lock, [&] { return ticket->remaining == 0; });
+    if (ticket->error)
+    {
+      std::rethrow_exception(ticket->error);
+    }
+    return mesu;
+  }
+
+  inline bool fanout_exporter_t::submit(std::shared_ptr<Measurement const> mesu) { return enqueue(item_t{std::move(mesu), nullptr}, _settings.drop_when_full); }
+
+  inline bool fanout_exporter_t::submit(Measurement&& mesu) { return submit(std::make_shared<Measurement const>(std::move(mesu))); }
+
+  inline void fanout_exporter_t::report(std::size_t sink, std::exception_ptr error) const
+  {
+    if (_settings.error_callback)
+    {
+      try
+      {
+        _settings.error_callback(sink, error);
+      }
+      catch (...)
+      {}
+    }
+  }
+
+  inline void fanout_exporter_t::export_next(std::size_t sink, std::unique_lock<std::mutex>& lock)
+  {
+    sink_state_t& state = _states[sink];
+    item_t item = state.queue.front();
+    lock.unlock();
+
+    auto const begin = std::chrono::steady_clock::now();
+    std::exception_ptr error;
+    try
+    {
+      _sinks[sink]->apply(*item.mesu);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    auto const busy = std::chrono::steady_clock::now() - begin;
+    if (error && !item.ticket)
+    {
+      report(sink, error);
+    }
+    item.mesu.reset();
+
+    lock.lock();
+    state.queue.pop_front();
+    state.stats.busy += std::chrono::duration_cast<std::chrono::nanoseconds>(busy);
+    if (error)
+    {
+      state.stats.errors++;
+    }
+    else
+    {
+      state.stats.frames++;
+    }
+    if (item.ticket)
+    {
+      if (error && !item.ticket->error)
+      {
+        item.ticket->error = error;
+      }
+      item.ticket->remaining--;
+    }
+    _lanes.space().notify_all();
+    _lanes.done().notify_all();
+  }
+
+  inline void fanout_exporter_t::flush_sink(std::size_t sink)
+  {
+    try
+    {
+      _sinks[sink]->flush();
+    }
+    catch (...)
+    {
+      report(sink, std::current_exception());
+    }
+  }
+
+  inline void fanout_exporter_t::flush() { _lanes.flush(); }
+
+  inline void fanout_exporter_t::close() { _lanes.close(); }
+
+  inline std::vector<lane_stats_t> fanout_exporter_t::stats() const
+  {
+    std::lock_guard<std::mutex> lock(_lanes.mutex());
+    std::vector<lane_stats_t> stats;
+    stats.reserve(_states.size());
+    for (auto const& state : _states)
+    {
+      stats.push_back(state.stats);
+    }
+    return stats;
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::exporting
@@ -0,0 +1,38 @@
+#pragma once
+
+/** @file cuvis_interop.hpp
+  *
+  *
+  * @details Common types of the adapters to third party libraries.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <cuvis.hpp>
+#include <memory>
+
+/**
+  * @brief Zero-copy adapters of @ref image_t and @ref view_t to third party libraries.
+  *
+  * The adapters wrap the SDK buffers without copying. The adapters for OpenCV, Eigen and DLPack are
+  * located in separate headers, so only the used library is required.
+  * */
+namespace cuvis::aux::interop
+{
+  /** @brief An adapter bundled with the owner of the wrapped data
+    *
+    * The data stays valid as long as the owner is held, also when the measurement or view is released.
+    *
+    * @tparam adapter_t The type of the adapter, e.g. cv::Mat
+    * */
+  template <typename adapter_t>
+  struct owned_t
+  {
+    /** The adapter of the data.*/
+    adapter_t value;
+
+    /** The owner of the data, see @ref image_t::get_owner.*/
+    std::shared_ptr<void const> owner;
+  };
+
+} // namespace cuvis::aux::interop
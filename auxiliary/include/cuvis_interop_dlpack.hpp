@@ -0,0 +1,146 @@
+#pragma once
+
+/** @file cuvis_interop_dlpack.hpp
+  *
+  *
+  * @details Zero-copy DLPack tensors of cuvis images, e.g. for PyTorch via torch.utils.dlpack.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <cuvis.hpp>
+#include <cuvis_interop.hpp>
+#include <dlpack/dlpack.h>
+#include <memory>
+
+namespace cuvis::aux::interop
+{
+  /** @cond INTERNAL */
+  namespace dlpack_impl
+  {
+    /** @brief The manager context of a tensor, holds the owner and the shape */
+    struct context_t
+    {
+      std::shared_ptr<void const> owner;
+      std::int64_t shape[3];
+    };
+
+    template <typename data_t>
+    constexpr DLDataType data_type()
+    {
+      static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+      if constexpr (std::is_floating_point<data_t>::value)
+      {
+        return DLDataType{std::uint8_t(kDLFloat), std::uint8_t(8 * sizeof(data_t)), std::uint16_t(1)};
+      }
+      else
+      {
+        return DLDataType{std::uint8_t(kDLUInt), std::uint8_t(8 * sizeof(data_t)), std::uint16_t(1)};
+      }
+    }
+
+    template <typename data_t>
+    inline void fill_tensor(common_image_t<data_t> const& img, context_t& ctx, DLTensor& tensor)
+    {
+      ctx.shape[0] = std::int64_t(img._height);
+      ctx.shape[1] = std::int64_t(img._width);
+      ctx.shape[2] = std::int64_t(img._channels);
+
+      tensor.data = const_cast<void*>(static_cast<void const*>(img._data));
+      tensor.device = DLDevice{kDLCPU, 0};
+      tensor.ndim = 3;
+      tensor.dtype = data_type<data_t>();
+      tensor.shape = ctx.shape;
+      // compact row-major, i.e. BIP
+      tensor.strides = nullptr;
+      tensor.byte_offset = 0;
+    }
+
+    template <typename tensor_t>
+    inline void delete_tensor(tensor_t* self)
+    {
+      delete static_cast<context_t*>(self->manager_ctx);
+      delete self;
+    }
+
+    template <typename data_t>
+    inline DLManagedTensor* make_tensor(common_image_t<data_t> const& img, std::shared_ptr<void const> owner)
+    {
+      auto ctx = std::make_unique<context_t>();
+      ctx->owner = std::move(owner);
+      auto tensor = std::make_unique<DLManagedTensor>();
+      fill_tensor(img, *ctx, tensor->dl_tensor);
+      tensor->deleter = &delete_tensor<DLManagedTensor>;
+      tensor->manager_ctx = ctx.release();
+      return tensor.release();
+    }
+
+#if defined(DLPACK_MAJOR_VERSION) && DLPACK_MAJOR_VERSION >= 1
+    template <typename data_t>
+    inline DLManagedTensorVersioned* make_tensor_versioned(common_image_t<data_t> const& img, std::shared_ptr<void const> owner)
+    {
+      auto ctx = std::make_unique<context_t>();
+      ctx->owner = std::move(owner);
+      auto tensor = std::make_unique<DLManagedTensorVersioned>();
+      tensor->version = DLPackVersion{DLPACK_MAJOR_VERSION, DLPACK_MINOR_VERSION};
+      tensor->flags = DLPACK_FLAG_BITMASK_READ_ONLY;
+      fill_tensor(img, *ctx, tensor->dl_tensor);
+      tensor->deleter = &delete_tensor<DLManagedTensorVersioned>;
+      tensor->manager_ctx = ctx.release();
+      return tensor.release();
+    }
+#endif
+  } // namespace dlpack_impl
+  /** @endcond */
+
+  /** @brief Exports a measurement image as DLPack tensor without copying
+    *
+    * The tensor is a compact row-major CPU tensor of shape (_height, _width, _channels), which matches the BIP layout.
+    * The tensor holds the owner of the data until its deleter is called. As usual for DLPack, the ownership
+    * of the returned tensor is passed to the consumer, which calls the deleter. The data must not be modified.
+    *
+    * @param[in] img The image from @ref Measurement
+    * @returns The managed tensor
+    * */
+  template <typename data_t>
+  inline DLManagedTensor* to_dlpack(image_t<data_t> const& img)
+  {
+    return dlpack_impl::make_tensor(img, img.get_owner());
+  }
+
+  /** @brief Exports a view as DLPack tensor without copying, see @ref to_dlpack
+    *
+    * @param[in] view The view from @ref Viewer
+    * @returns The managed tensor
+    * */
+  template <typename data_t>
+  inline DLManagedTensor* to_dlpack(view_t<data_t> const& view)
+  {
+    return dlpack_impl::make_tensor(view, view.get_owner());
+  }
+
+#if defined(DLPACK_MAJOR_VERSION) && DLPACK_MAJOR_VERSION >= 1
+  /** @brief Exports a measurement image as versioned DLPack tensor, flagged read-only, see @ref to_dlpack
+    *
+    * @param[in] img The image from @ref Measurement
+    * @returns The managed tensor
+    * */
+  template <typename data_t>
+  inline DLManagedTensorVersioned* to_dlpack_versioned(image_t<data_t> const& img)
+  {
+    return dlpack_impl::make_tensor_versioned(img, img.get_owner());
+  }
+
+  /** @brief Exports a view as versioned DLPack tensor, flagged read-only, see @ref to_dlpack
+    *
+    * @param[in] view The view from @ref Viewer
+    * @returns The managed tensor
+    * */
+  template <typename data_t>
+  inline DLManagedTensorVersioned* to_dlpack_versioned(view_t<data_t> const& view)
+  {
+    return dlpack_impl::make_tensor_versioned(view, view.get_owner());
+  }
+#endif
+
+} // namespace cuvis::aux::interop
@@ -0,0 +1,116 @@
+#pragma once
+
+/** @file cuvis_interop_eigen.hpp
+  *
+  *
+  * @details Zero-copy Eigen::Map adapters of cuvis images.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <Eigen/Core>
+#include <cuvis.hpp>
+#include <cuvis_interop.hpp>
+
+namespace cuvis::aux::interop
+{
+  /** @brief Read-only map of all pixels, one row per pixel and one column per channel */
+  template <typename data_t>
+  using pixel_matrix_map_t = Eigen::Map<Eigen::Matrix<data_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> const>;
+
+  /** @brief Read-only map of a single band, one row per image row */
+  template <typename data_t>
+  using band_map_t = Eigen::Map<Eigen::Matrix<data_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> const, Eigen::Unaligned, Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+  /** @brief Read-only map of the channel vector of a single pixel */
+  template <typename data_t>
+  using spectrum_map_t = Eigen::Map<Eigen::Matrix<data_t, Eigen::Dynamic, 1> const>;
+
+  /** @brief Maps all pixels of an image as (_width * _height) x _channels matrix
+    *
+    * Each row is the contiguous channel vector of a pixel, e.g. for spectral unmixing or PCA.
+    *
+    * @param[in] img The image data
+    * @returns The map, which is valid as long as the image data
+    * */
+  template <typename data_t>
+  inline pixel_matrix_map_t<data_t> wrap_pixel_matrix(common_image_t<data_t> const& img)
+  {
+    return pixel_matrix_map_t<data_t>(img._data, Eigen::Index(img._width * img._height), Eigen::Index(img._channels));
+  }
+
+  /** @brief Maps a single band of an image as _height x _width matrix
+    *
+    * @param[in] img The image data
+    * @param[in] z The band (0 - @ref common_image_t::_channels - 1)
+    * @returns The map, which is valid as long as the image data
+    * */
+  template <typename data_t>
+  inline band_map_t<data_t> wrap_band(common_image_t<data_t> const& img, std::size_t z)
+  {
+    assert(z < img._channels);
+    Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> const stride(Eigen::Index(img._width * img._channels), Eigen::Index(img._channels));
+    return band_map_t<data_t>(img._data + z, Eigen::Index(img._height), Eigen::Index(img._width), stride);
+  }
+
+  /** @brief Maps the channel vector of a single pixel
+    *
+    * @param[in] img The image data
+    * @param[in] x x pixel position (0 - @ref common_image_t::_width - 1)
+    * @param[in] y y pixel position (0 - @ref common_image_t::_height - 1)
+    * @returns The map, which is valid as long as the image data
+    * */
+  template <typename data_t>
+  inline spectrum_map_t<data_t> wrap_spectrum(common_image_t<data_t> const& img, std::size_t x, std::size_t y)
+  {
+    auto const px = img.pixel(x, y);
+    return spectrum_map_t<data_t>(px.data(), Eigen::Index(px.size()));
+  }
+
+  /** @brief Maps all pixels of a measurement image, see @ref wrap_pixel_matrix
+    *
+    * @param[in] img The image from @ref Measurement
+    * @returns The map and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<pixel_matrix_map_t<data_t>> to_pixel_matrix(image_t<data_t> const& img)
+  {
+    return owned_t<pixel_matrix_map_t<data_t>>{wrap_pixel_matrix(img), img.get_owner()};
+  }
+
+  /** @brief Maps all pixels of a view, see @ref wrap_pixel_matrix
+    *
+    * @param[in] view The view from @ref Viewer
+    * @returns The map and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<pixel_matrix_map_t<data_t>> to_pixel_matrix(view_t<data_t> const& view)
+  {
+    return owned_t<pixel_matrix_map_t<data_t>>{wrap_pixel_matrix(view), view.get_owner()};
+  }
+
+  /** @brief Maps a band of a measurement image, see @ref wrap_band
+    *
+    * @param[in] img The image from @ref Measurement
+    * @param[in] z The band
+    * @returns The map and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<band_map_t<data_t>> to_band(image_t<data_t> const& img, std::size_t z)
+  {
+    return owned_t<band_map_t<data_t>>{wrap_band(img, z), img.get_owner()};
+  }
+
+  /** @brief Maps a band of a view, see @ref wrap_band
+    *
+    * @param[in] view The view from @ref Viewer
+    * @param[in] z The band
+    * @returns The map and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<band_map_t<data_t>> to_band(view_t<data_t> const& view, std::size_t z)
+  {
+    return owned_t<band_map_t<data_t>>{wrap_band(view, z), view.get_owner()};
+  }
+
+} // namespace cuvis::aux::interop
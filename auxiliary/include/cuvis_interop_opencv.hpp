@@ -0,0 +1,132 @@
+#pragma once
+
+/** @file cuvis_interop_opencv.hpp
+  *
+  *
+  * @details Zero-copy cv::Mat adapters of cuvis images.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <cuvis.hpp>
+#include <cuvis_interop.hpp>
+#include <opencv2/opencv.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace cuvis::aux::interop
+{
+  /** @brief The OpenCV type of a multi-channel Mat of data_t
+    *
+    * @param[in] channel_count Number of channels (1 - 511)
+    * @returns The OpenCV type (CV_MAKETYPE)
+    * */
+  template <typename data_t>
+  inline int get_mat_datatype(int channel_count)
+  {
+    if (channel_count < 1 || channel_count > 511)
+      throw std::invalid_argument("Invalid channel count");
+
+    if constexpr (!std::is_floating_point<data_t>::value)
+    {
+      if constexpr (!std::is_signed<data_t>::value)
+      {
+        switch (sizeof(data_t))
+        {
+          case 1: return CV_MAKETYPE(CV_8U, channel_count);
+          case 2: return CV_MAKETYPE(CV_16U, channel_count);
+          default: throw std::invalid_argument("Invalid bitdepth for unsigned integer data type");
+        }
+      }
+      else
+      {
+        switch (sizeof(data_t))
+        {
+          case 1: return CV_MAKETYPE(CV_8S, channel_count);
+          case 2: return CV_MAKETYPE(CV_16S, channel_count);
+          case 4: return CV_MAKETYPE(CV_32S, channel_count);
+          default: throw std::invalid_argument("Invalid bitdepth for signed integer data type");
+        }
+      }
+    }
+    else
+    {
+      switch (sizeof(data_t))
+      {
+        case 2: return CV_MAKETYPE(CV_16F, channel_count);
+        case 4: return CV_MAKETYPE(CV_32F, channel_count);
+        case 8: return CV_MAKETYPE(CV_64F, channel_count);
+        default: throw std::invalid_argument("Invalid bitdepth for floating point data type");
+      }
+    }
+  }
+
+  /** @brief Wraps image data in a cv::Mat header without copying
+    *
+    * The Mat has @ref common_image_t::_height rows, @ref common_image_t::_width columns and
+    * @ref common_image_t::_channels interleaved channels, which matches the BIP layout.
+    * OpenCV has no read-only Mat, the data must not be modified through the Mat.
+    * std::uint32_t data is not supported by OpenCV.
+    *
+    * @param[in] img The image data
+    * @returns The Mat header
+    * */
+  template <typename data_t>
+  inline cv::Mat wrap_mat(common_image_t<data_t> const& img)
+  {
+    // Yes, the 'const' needs to be removed, OpenCV does not have a cv::ConstMat
+    auto const type = get_mat_datatype<data_t>(static_cast<int>(img._channels));
+    return cv::Mat(static_cast<int>(img._height), static_cast<int>(img._width), type, const_cast<void*>(static_cast<void const*>(img._data)));
+  }
+
+  /** @brief Wraps a measurement image in a cv::Mat, which keeps the measurement data alive
+    *
+    * See @ref wrap_mat.
+    *
+    * @param[in] img The image from @ref Measurement
+    * @returns The Mat header and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<cv::Mat> to_mat(image_t<data_t> const& img)
+  {
+    return owned_t<cv::Mat>{wrap_mat(img), img.get_owner()};
+  }
+
+  /** @brief Wraps a view in a cv::Mat, which keeps the view data alive
+    *
+    * See @ref wrap_mat.
+    *
+    * @param[in] view The view from @ref Viewer
+    * @returns The Mat header and the owner of the data
+    * */
+  template <typename data_t>
+  inline owned_t<cv::Mat> to_mat(view_t<data_t> const& view)
+  {
+    return owned_t<cv::Mat>{wrap_mat(view), view.get_owner()};
+  }
+
+  /** @brief A view target writing into a cv::Mat, see @ref Viewer::apply(Measurement const&, std::vector<Viewer::view_target_t>&)
+    *
+    * The Mat must be allocated with the size and type of the view and must stay allocated while the target is used.
+    * Padded rows, e.g. of a Mat mapped to a pixel buffer, are supported.
+    *
+    * @param[in] id The id of the view
+    * @param[in] mat The destination
+    * @returns The target
+    * */
+  inline Viewer::view_target_t make_view_target(std::string id, cv::Mat& mat)
+  {
+    if (mat.dims != 2)
+    {
+      throw std::invalid_argument("view target Mat must be two-dimensional");
+    }
+    Viewer::view_target_t target;
+    target.id = std::move(id);
+    target.data = mat.data;
+    target.row_stride = mat.step[0];
+    target.capacity = mat.rows > 0 ? (std::size_t(mat.rows) - 1) * mat.step[0] + std::size_t(mat.cols) * mat.elemSize() : 0;
+    return target;
+  }
+
+} // namespace cuvis::aux::interop
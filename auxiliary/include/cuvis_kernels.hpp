@@ -0,0 +1,393 @@
+#pragma once
+
+/** @file cuvis_kernels.hpp
+  *
+  *
+  * @details Vectorized kernels for per-pixel reductions over the channel vector of an image.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cuvis.hpp>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define CUVIS_KERNELS_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define CUVIS_KERNELS_TARGET(isa)
+  #else
+    #define CUVIS_KERNELS_TARGET(isa) __attribute__((target(isa)))
+  #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #define CUVIS_KERNELS_NEON
+  #include <arm_neon.h>
+#endif
+
+/**
+  * @brief Vectorized kernels for image data.
+  *
+  * The kernels widen the image data (any type of @ref is_supported_image_data_t) to double precision.
+  * The instruction set is detected at runtime (SSE4.2, AVX2, AVX-512 on x86, NEON on ARM64),
+  * with a scalar fallback for all other platforms.
+  * */
+namespace cuvis::aux::kernels
+{
+  /** @brief Instruction set used by the kernels */
+  enum class isa_t
+  {
+    scalar,
+    sse42,
+    avx2,
+    avx512,
+    neon
+  };
+
+  /** @brief Detects the best instruction set supported by the CPU and the operating system */
+  inline isa_t detect_isa()
+  {
+#if defined(CUVIS_KERNELS_X86)
+  #if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int const max_leaf = info[0];
+    __cpuid(info, 1);
+    bool const sse42 = (info[2] & (1 << 20)) != 0;
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    unsigned long long const xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool const ymm_state = (xcr0 & 0x6) == 0x6;
+    bool const zmm_state = (xcr0 & 0xe6) == 0xe6;
+    int leaf7_ebx = 0;
+    if (max_leaf >= 7)
+    {
+      __cpuidex(info, 7, 0);
+      leaf7_ebx = info[1];
+    }
+    if (zmm_state && (leaf7_ebx & (1 << 16)) != 0)
+    {
+      return isa_t::avx512;
+    }
+    if (ymm_state && (leaf7_ebx & (1 << 5)) != 0)
+    {
+      return isa_t::avx2;
+    }
+    if (sse42)
+    {
+      return isa_t::sse42;
+    }
+  #else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return isa_t::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return isa_t::avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+      return isa_t::sse42;
+    }
+  #endif
+    return isa_t::scalar;
+#elif defined(CUVIS_KERNELS_NEON)
+    return isa_t::neon;
+#else
+    return isa_t::scalar;
+#endif
+  }
+
+  /** @brief Checks if the kernels for an instruction set can be used on this machine */
+  inline bool is_isa_supported(isa_t isa)
+  {
+    isa_t const detected = detect_isa();
+    switch (isa)
+    {
+      case isa_t::scalar: return true;
+      case isa_t::neon: return detected == isa_t::neon;
+      default: return detected != isa_t::neon && static_cast<int>(isa) <= static_cast<int>(detected);
+    }
+  }
+
+  /** @cond INTERNAL */
+  namespace kernels_impl
+  {
+    inline std::atomic<isa_t>& active_isa()
+    {
+      static std::atomic<isa_t> isa(detect_isa());
+      return isa;
+    }
+
+    template <typename data_t>
+    inline void accumulate_moments_tail(data_t const* px, std::size_t z, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      for (; z < channels; z++)
+      {
+        double const loc_val = double(px[z]) - shift[z];
+        sum[z] += loc_val;
+        sq_sum[z] += loc_val * loc_val;
+      }
+    }
+
+    template <typename data_t>
+    inline void accumulate_moments_scalar(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      for (std::size_t p = 0; p < pixel_count; p++, px += channels)
+      {
+        accumulate_moments_tail(px, 0, channels, shift, sum, sq_sum);
+      }
+    }
+
+#if defined(CUVIS_KERNELS_X86)
+    // widening loads, 2 channels
+    CUVIS_KERNELS_TARGET("sse4.2") inline __m128d load_sse42(std::uint8_t const* p)
+    {
+      std::uint16_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return _mm_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+    }
+    CUVIS_KERNELS_TARGET("sse4.2") inline __m128d load_sse42(std::uint16_t const* p)
+    {
+      std::int32_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return _mm_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_cvtsi32_si128(v)));
+    }
+    CUVIS_KERNELS_TARGET("sse4.2") inline __m128d load_sse42(std::uint32_t const* p)
+    {
+      // no unsigned conversion before AVX-512: flip the sign bit, convert signed, add the offset back
+      __m128i const v = _mm_xor_si128(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p)), _mm_set1_epi32(INT_MIN));
+      return _mm_add_pd(_mm_cvtepi32_pd(v), _mm_set1_pd(2147483648.0));
+    }
+    CUVIS_KERNELS_TARGET("sse4.2") inline __m128d load_sse42(float const* p)
+    {
+      return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+    }
+
+    template <typename data_t>
+    CUVIS_KERNELS_TARGET("sse4.2")
+    inline void accumulate_moments_sse42(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      for (std::size_t p = 0; p < pixel_count; p++, px += channels)
+      {
+        std::size_t z = 0;
+        for (; z + 2 <= channels; z += 2)
+        {
+          __m128d const v = _mm_sub_pd(load_sse42(px + z), _mm_loadu_pd(shift + z));
+          _mm_storeu_pd(sum + z, _mm_add_pd(_mm_loadu_pd(sum + z), v));
+          _mm_storeu_pd(sq_sum + z, _mm_add_pd(_mm_loadu_pd(sq_sum + z), _mm_mul_pd(v, v)));
+        }
+        accumulate_moments_tail(px, z, channels, shift, sum, sq_sum);
+      }
+    }
+
+    // widening loads, 4 channels
+    CUVIS_KERNELS_TARGET("avx2") inline __m256d load_avx2(std::uint8_t const* p)
+    {
+      std::int32_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)));
+    }
+    CUVIS_KERNELS_TARGET("avx2") inline __m256d load_avx2(std::uint16_t const* p)
+    {
+      return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+    }
+    CUVIS_KERNELS_TARGET("avx2") inline __m256d load_avx2(std::uint32_t const* p)
+    {
+      __m128i const v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)), _mm_set1_epi32(INT_MIN));
+      return _mm256_add_pd(_mm256_cvtepi32_pd(v), _mm256_set1_pd(2147483648.0));
+    }
+    CUVIS_KERNELS_TARGET("avx2") inline __m256d load_avx2(float const* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+
+    template <typename data_t>
+    CUVIS_KERNELS_TARGET("avx2")
+    inline void accumulate_moments_avx2(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      for (std::size_t p = 0; p < pixel_count; p++, px += channels)
+      {
+        std::size_t z = 0;
+        for (; z + 4 <= channels; z += 4)
+        {
+          __m256d const v = _mm256_sub_pd(load_avx2(px + z), _mm256_loadu_pd(shift + z));
+          _mm256_storeu_pd(sum + z, _mm256_add_pd(_mm256_loadu_pd(sum + z), v));
+          _mm256_storeu_pd(sq_sum + z, _mm256_add_pd(_mm256_loadu_pd(sq_sum + z), _mm256_mul_pd(v, v)));
+        }
+        accumulate_moments_tail(px, z, channels, shift, sum, sq_sum);
+      }
+    }
+
+    // widening loads, 8 channels
+    CUVIS_KERNELS_TARGET("avx512f") inline __m512d load_avx512(std::uint8_t const* p)
+    {
+      return _mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+    }
+    CUVIS_KERNELS_TARGET("avx512f") inline __m512d load_avx512(std::uint16_t const* p)
+    {
+      return _mm512_cvtepi32_pd(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))));
+    }
+    CUVIS_KERNELS_TARGET("avx512f") inline __m512d load_avx512(std::uint32_t const* p)
+    {
+      return _mm512_cvtepu32_pd(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)));
+    }
+    CUVIS_KERNELS_TARGET("avx512f") inline __m512d load_avx512(float const* p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+
+    CUVIS_KERNELS_TARGET("avx512f")
+    inline void accumulate_avx512(__m512d x, __mmask8 mask, double const* shift, double* sum, double* sq_sum)
+    {
+      // explicit rounding variants, as the compiler may otherwise contract multiply and add to FMA (AVX-512 implies FMA)
+      constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+      __m512d const v = _mm512_sub_round_pd(x, _mm512_maskz_loadu_pd(mask, shift), rounding);
+      __m512d const sq = _mm512_mul_round_pd(v, v, rounding);
+      _mm512_mask_storeu_pd(sum, mask, _mm512_add_round_pd(_mm512_maskz_loadu_pd(mask, sum), v, rounding));
+      _mm512_mask_storeu_pd(sq_sum, mask, _mm512_add_round_pd(_mm512_maskz_loadu_pd(mask, sq_sum), sq, rounding));
+    }
+
+    template <typename data_t>
+    CUVIS_KERNELS_TARGET("avx512f")
+    inline void accumulate_moments_avx512(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      std::size_t const tail = channels % 8;
+      __mmask8 const tail_mask = static_cast<__mmask8>((1u << tail) - 1u);
+      for (std::size_t p = 0; p < pixel_count; p++, px += channels)
+      {
+        std::size_t z = 0;
+        for (; z + 8 <= channels; z += 8)
+        {
+          accumulate_avx512(load_avx512(px + z), 0xff, shift + z, sum + z, sq_sum + z);
+        }
+        if (tail != 0)
+        {
+          // the scalar tail would be compiled with FMA as well, use masked lanes instead
+          data_t buffer[8] = {};
+          std::memcpy(buffer, px + z, tail * sizeof(data_t));
+          accumulate_avx512(load_avx512(buffer), tail_mask, shift + z, sum + z, sq_sum + z);
+        }
+      }
+    }
+#endif
+
+#if defined(CUVIS_KERNELS_NEON)
+    inline void accumulate_neon_f64(float64x2_t x, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      float64x2_t const v = vsubq_f64(x, vld1q_f64(shift + z));
+      vst1q_f64(sum + z, vaddq_f64(vld1q_f64(sum + z), v));
+      // separate multiply and add (no vfmaq), to round like the scalar kernel
+      vst1q_f64(sq_sum + z, vaddq_f64(vld1q_f64(sq_sum + z), vmulq_f64(v, v)));
+    }
+
+    inline void accumulate_neon_u32(uint32x4_t x, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      accumulate_neon_f64(vcvtq_f64_u64(vmovl_u32(vget_low_u32(x))), z, shift, sum, sq_sum);
+      accumulate_neon_f64(vcvtq_f64_u64(vmovl_high_u32(x)), z + 2, shift, sum, sq_sum);
+    }
+
+    inline void accumulate_neon_u16(uint16x8_t x, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      accumulate_neon_u32(vmovl_u16(vget_low_u16(x)), z, shift, sum, sq_sum);
+      accumulate_neon_u32(vmovl_high_u16(x), z + 4, shift, sum, sq_sum);
+    }
+
+    // widening steps, 8 channels for 8 and 16 bit data, 4 channels for 32 bit data
+    inline constexpr std::size_t neon_step(std::uint8_t const*) { return 8; }
+    inline constexpr std::size_t neon_step(std::uint16_t const*) { return 8; }
+    inline constexpr std::size_t neon_step(std::uint32_t const*) { return 4; }
+    inline constexpr std::size_t neon_step(float const*) { return 4; }
+
+    inline void accumulate_neon_step(std::uint8_t const* p, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      accumulate_neon_u16(vmovl_u8(vld1_u8(p)), z, shift, sum, sq_sum);
+    }
+    inline void accumulate_neon_step(std::uint16_t const* p, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      accumulate_neon_u16(vld1q_u16(p), z, shift, sum, sq_sum);
+    }
+    inline void accumulate_neon_step(std::uint32_t const* p, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      accumulate_neon_u32(vld1q_u32(p), z, shift, sum, sq_sum);
+    }
+    inline void accumulate_neon_step(float const* p, std::size_t z, double const* shift, double* sum, double* sq_sum)
+    {
+      float32x4_t const x = vld1q_f32(p);
+      accumulate_neon_f64(vcvt_f64_f32(vget_low_f32(x)), z, shift, sum, sq_sum);
+      accumulate_neon_f64(vcvt_high_f64_f32(x), z + 2, shift, sum, sq_sum);
+    }
+
+    template <typename data_t>
+    inline void accumulate_moments_neon(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+    {
+      constexpr std::size_t step = neon_step(static_cast<data_t const*>(nullptr));
+      for (std::size_t p = 0; p < pixel_count; p++, px += channels)
+      {
+        std::size_t z = 0;
+        for (; z + step <= channels; z += step)
+        {
+          accumulate_neon_step(px + z, z, shift, sum, sq_sum);
+        }
+        accumulate_moments_tail(px, z, channels, shift, sum, sq_sum);
+      }
+    }
+#endif
+  } // namespace kernels_impl
+  /** @endcond */
+
+  /** @brief Get the instruction set currently used by the kernels
+    *
+    * Defaults to the result of @ref detect_isa.
+    * */
+  inline isa_t get_isa() { return kernels_impl::active_isa().load(std::memory_order_relaxed); }
+
+  /** @brief Set the instruction set used by the kernels
+    *
+    * Mainly intended for testing and benchmarking, e.g. comparing against the @ref isa_t::scalar kernels.
+    *
+    * @param[in] isa The instruction set to use, must be supported by this machine (see @ref is_isa_supported)
+    * */
+  inline void set_isa(isa_t isa)
+  {
+    if (!is_isa_supported(isa))
+    {
+      throw std::invalid_argument("Instruction set not supported on this machine");
+    }
+    kernels_impl::active_isa().store(isa, std::memory_order_relaxed);
+  }
+
+  /** @brief Accumulates the channel vectors of consecutive pixels into sum and sum of squares.
+    *
+    * For each channel z and pixel p: v = px[p * channels + z] - shift[z]; sum[z] += v; sq_sum[z] += v * v.\n
+    * All arithmetic is done in double precision. The kernels of all instruction sets add up
+    * the pixels in the same order; results can still differ in the last bits, if the compiler contracts
+    * multiply and add of the scalar kernel.
+    *
+    * @param[in] px The channel vector of the first pixel (BIP interleave, see @ref common_image_t._data)
+    * @param[in] pixel_count Number of consecutive pixels to add
+    * @param[in] channels Number of channels per pixel
+    * @param[in] shift Array of size @p channels, subtracted from each value
+    * @param[in,out] sum Array of size @p channels, growing sum
+    * @param[in,out] sq_sum Array of size @p channels, growing sum of squares
+    * */
+  template <typename data_t>
+  inline void accumulate_moments(data_t const* px, std::size_t pixel_count, std::size_t channels, double const* shift, double* sum, double* sq_sum)
+  {
+    static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+
+    switch (get_isa())
+    {
+#if defined(CUVIS_KERNELS_X86)
+      case isa_t::avx512: kernels_impl::accumulate_moments_avx512(px, pixel_count, channels, shift, sum, sq_sum); return;
+      case isa_t::avx2: kernels_impl::accumulate_moments_avx2(px, pixel_count, channels, shift, sum, sq_sum); return;
+      case isa_t::sse42: kernels_impl::accumulate_moments_sse42(px, pixel_count, channels, shift, sum, sq_sum); return;
+#endif
+#if defined(CUVIS_KERNELS_NEON)
+      case isa_t::neon: kernels_impl::accumulate_moments_neon(px, pixel_count, channels, shift, sum, sq_sum); return;
+#endif
+      default: kernels_impl::accumulate_moments_scalar(px, pixel_count, channels, shift, sum, sq_sum); return;
+    }
+  }
+
+} // namespace cuvis::aux::kernels
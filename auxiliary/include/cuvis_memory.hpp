@@ -0,0 +1,119 @@
+#pragma once
+
+/** @file cuvis_memory.hpp
+  *
+  *
+  * @details Allocator tuning for steady frame rates.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#if defined(__GLIBC__)
+  #include <malloc.h>
+#endif
+
+/**
+  * @brief Memory handling of the auxiliary helpers.
+  * */
+namespace cuvis::aux::memory
+{
+  /** @cond INTERNAL */
+  namespace memory_impl
+  {
+    /* the mmap threshold set by tune_allocator, the glibc default until then */
+    inline std::atomic<std::size_t>& mmap_threshold()
+    {
+      static std::atomic<std::size_t> threshold{std::size_t(128) << 10};
+      return threshold;
+    }
+  } // namespace memory_impl
+  /** @endcond */
+
+  /** @brief Settings for @ref tune_allocator */
+  struct allocator_settings_t
+  {
+    /** Size of the largest buffer of a frame, e.g. the processed cube, in bytes.*/
+    std::size_t frame_bytes = 0;
+
+    /** Number of frames alive at the same time, e.g. the worker queue sizes plus the frames held by the application.*/
+    std::size_t frames_in_flight = 4;
+
+    /** Limit the number of malloc arenas, which keeps freed frames reusable by every thread.*/
+    std::optional<int> arena_max;
+  };
+
+  /** @brief Tunes the process allocator, so freed frame buffers are reused for the next frames
+    *
+    * The cube of a processed measurement is allocated by the SDK with the process allocator. By default, glibc serves
+    * such large blocks with mmap and returns them to the operating system on free, so every frame costs a fresh mapping
+    * and its page faults. With the allocator tuned, frame buffers are allocated from the heap and the memory of
+    * @ref allocator_settings_t::frames_in_flight frames is kept when they are freed, so the next frame reuses it.
+    *
+    * The settings apply to the whole process and should be set once at startup, before the first frame is processed.
+    * Only supported with glibc.
+    *
+    * @return true, if the allocator was tuned
+    * */
+  inline bool tune_allocator(allocator_settings_t const& settings)
+  {
+#if defined(__GLIBC__)
+    if (settings.frame_bytes == 0)
+    {
+      return false;
+    }
+    // glibc limits the mmap threshold to 32 MiB on 64 bit systems, larger frames are still mapped
+    std::size_t const mmap_threshold = std::min<std::size_t>(settings.frame_bytes + 1, std::size_t(32) << 20);
+    std::size_t const retained = settings.frame_bytes * std::max<std::size_t>(settings.frames_in_flight, 1) * 2;
+
+    bool ok = mallopt(M_MMAP_THRESHOLD, int(mmap_threshold)) != 0;
+    if (ok)
+    {
+      memory_impl::mmap_threshold() = mmap_threshold;
+    }
+    ok = mallopt(M_TRIM_THRESHOLD, int(std::min<std::size_t>(retained, std::size_t(1) << 30))) != 0 && ok;
+    if (settings.arena_max.has_value())
+    {
+      ok = mallopt(M_ARENA_MAX, *settings.arena_max) != 0 && ok;
+    }
+    return ok;
+#else
+    (void)settings;
+    return false;
+#endif
+  }
+
+  /** @brief Grows the heap of the calling thread by allocating and touching the given number of bytes
+    *
+    * Together with @ref tune_allocator, the first frames do not pay for page faults. Blocks at or above the mmap
+    * threshold are mapped and returned to the operating system on free, they would not grow the heap. Such blocks
+    * are skipped with glibc, so call @ref tune_allocator with a frame size of at least the block size first.
+    *
+    * @return false, if the blocks are served by mmap and nothing was allocated
+    * */
+  inline bool prefault(std::size_t bytes, std::size_t block_bytes)
+  {
+    block_bytes = std::max<std::size_t>(block_bytes, 1);
+#if defined(__GLIBC__)
+    if (block_bytes >= memory_impl::mmap_threshold().load())
+    {
+      return false;
+    }
+#endif
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    for (std::size_t allocated = 0; allocated < bytes; allocated += block_bytes)
+    {
+      blocks.emplace_back(new std::byte[block_bytes]);
+      std::memset(blocks.back().get(), 0, block_bytes);
+    }
+    return true;
+  }
+
+} // namespace cuvis::aux::memory
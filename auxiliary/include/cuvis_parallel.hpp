@@ -0,0 +1,264 @@
+#pragma once
+
+/** @file cuvis_parallel.hpp
+  *
+  *
+  * @details Thread pool and execution settings for the auxiliary helpers.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+  * @brief Parallel execution of the auxiliary helpers.
+  *
+  * Work is split into independent tasks (e.g. row tiles of an image), which are distributed over the
+  * threads of a @ref thread_pool_t.
+  * */
+namespace cuvis::aux::parallel
+{
+  /** @brief A fixed set of threads executing parallel loops
+    *
+    * The thread calling @ref parallel_for takes part in the loop, so a pool of size N starts N-1 threads.
+    * Loops of different callers on the same pool are executed one after another.
+    * */
+  class thread_pool_t
+  {
+  public:
+    /** @brief A job of a parallel loop, called with the task index and the index of the executing worker */
+    using job_t = std::function<void(std::size_t task, std::size_t worker)>;
+
+    /** @brief Creates the pool
+      *
+      * @param[in] thread_count Number of workers including the calling thread, 0 selects the number of hardware threads
+      * */
+    explicit thread_pool_t(std::size_t thread_count = 0);
+
+    ~thread_pool_t();
+
+    thread_pool_t(thread_pool_t const&) = delete;
+    thread_pool_t& operator=(thread_pool_t const&) = delete;
+
+    /** @brief Number of workers including the calling thread */
+    std::size_t size() const { return _threads.size() + 1; }
+
+    /** @brief Executes job for the tasks [0, task_count) and waits for all of them.
+      *
+      * The worker index is within [0, @ref size()), a worker executes its tasks one after another.
+      * The first exception thrown by a job is rethrown after all tasks have finished.
+      *
+      * @param[in] task_count Number of tasks
+      * @param[in] job The job to execute for every task
+      * */
+    void parallel_for(std::size_t task_count, job_t const& job);
+
+  private:
+    void work(std::size_t worker);
+
+    void run_tasks(std::size_t worker);
+
+    std::vector<std::thread> _threads;
+
+    /** serializes the loops of different callers */
+    std::mutex _loop_mutex;
+
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    std::uint64_t _generation = 0;
+    std::size_t _active = 0;
+    bool _stop = false;
+
+    job_t const* _job = nullptr;
+    std::size_t _task_count = 0;
+    std::atomic<std::size_t> _next_task{0};
+    std::exception_ptr _error;
+  };
+
+  /** @brief Settings for the parallel execution of the auxiliary helpers
+    *
+    * Images are split into tiles of @ref tile_rows rows. With @ref deterministic set, every tile is reduced
+    * separately and the partial results are merged in tile order. The result then only depends on the tile size,
+    * so it is identical bit-for-bit for any number of threads, including a single thread.
+    * Otherwise, each worker reduces its tiles into a single partial result, which saves memory, but the result
+    * may differ in the last bits of floating point values between runs.
+    * Integer results (e.g. histograms) are always exact.
+    * */
+  struct execution_t
+  {
+    /** Number of threads, if no @ref pool is set. More than one thread creates a temporary pool for every call.*/
+    std::size_t thread_count = 1;
+
+    /** Number of image rows per tile.*/
+    std::size_t tile_rows = 64;
+
+    /** Merge per-tile results in tile order, see @ref execution_t.*/
+    bool deterministic = true;
+
+    /** Pool to use instead of temporary threads, must outlive the call.*/
+    thread_pool_t* pool = nullptr;
+  };
+
+  /** @brief Number of workers used for an execution */
+  inline std::size_t worker_count(execution_t const& exec)
+  {
+    if (exec.pool != nullptr)
+    {
+      return exec.pool->size();
+    }
+    return std::max<std::size_t>(exec.thread_count, 1);
+  }
+
+  /** @brief Number of tiles of an image with the given height */
+  inline std::size_t tile_count(execution_t const& exec, std::size_t height)
+  {
+    std::size_t const rows = std::max<std::size_t>(exec.tile_rows, 1);
+    return (height + rows - 1) / rows;
+  }
+
+  /** @brief Executes job(task, worker) for the tasks [0, task_count) as configured by exec.
+    *
+    * A worker index is within [0, @ref worker_count(exec)).
+    *
+    * @param[in] exec The execution settings
+    * @param[in] task_count Number of tasks
+    * @param[in] job The job to execute for every task
+    * */
+  template <typename job_t>
+  inline void run(execution_t const& exec, std::size_t task_count, job_t const& job)
+  {
+    if (exec.pool == nullptr && (exec.thread_count <= 1 || task_count <= 1))
+    {
+      for (std::size_t task = 0; task < task_count; task++)
+      {
+        job(task, std::size_t(0));
+      }
+      return;
+    }
+
+    thread_pool_t::job_t const wrapped = [&job](std::size_t task, std::size_t worker) { job(task, worker); };
+    if (exec.pool != nullptr)
+    {
+      exec.pool->parallel_for(task_count, wrapped);
+    }
+    else
+    {
+      thread_pool_t pool(exec.thread_count);
+      pool.parallel_for(task_count, wrapped);
+    }
+  }
+
+  /** @cond INTERNAL */
+  inline thread_pool_t::thread_pool_t(std::size_t thread_count)
+  {
+    if (thread_count == 0)
+    {
+      thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    _threads.reserve(thread_count - 1);
+    for (std::size_t worker = 1; worker < thread_count; worker++)
+    {
+      _threads.emplace_back(&thread_pool_t::work, this, worker);
+    }
+  }
+
+  inline thread_pool_t::~thread_pool_t()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _start.notify_all();
+    for (auto& thread : _threads)
+    {
+      thread.join();
+    }
+  }
+
+  inline void thread_pool_t::run_tasks(std::size_t worker)
+  {
+    for (std::size_t task = _next_task++; task < _task_count; task = _next_task++)
+    {
+      try
+      {
+        (*_job)(task, worker);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error)
+        {
+          _error = std::current_exception();
+        }
+      }
+    }
+  }
+
+  inline void thread_pool_t::work(std::size_t worker)
+  {
+    std::uint64_t generation = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _start.wait(lock, [&] { return _stop || _generation != generation; });
+        if (_stop)
+        {
+          return;
+        }
+        generation = _generation;
+      }
+
+      run_tasks(worker);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_active == 0)
+        {
+          _done.notify_one();
+        }
+      }
+    }
+  }
+
+  inline void thread_pool_t::parallel_for(std::size_t task_count, job_t const& job)
+  {
+    std::lock_guard<std::mutex> loop_lock(_loop_mutex);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _job = &job;
+      _task_count = task_count;
+      _next_task = 0;
+      _error = nullptr;
+      _active = _threads.size();
+      _generation++;
+    }
+    _start.notify_all();
+
+    run_tasks(0);
+
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [&] { return _active == 0; });
+      _job = nullptr;
+      error = _error;
+    }
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::parallel
@@ -0,0 +1,349 @@
+#pragma once
+
+/** @file cuvis_session_processor.hpp
+  *
+  *
+  * @details Parallel processing of session files with one processing context per shard.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cuvis.hpp>
+
+/**
+  * @brief Processing of recorded sessions.
+  * */
+namespace cuvis::aux::session
+{
+  /** @brief A processed frame */
+  struct frame_result_t
+  {
+    /** Index of the session in the order of @ref session_processor_t::add_session.*/
+    std::size_t session;
+
+    /** Index of the frame within the session.*/
+    int_t frame;
+
+    /** The processed measurement, empty if the session has no measurement for the frame or processing failed.*/
+    std::optional<Measurement> mesu;
+
+    /** The exception thrown while loading or processing the frame, if any.*/
+    std::exception_ptr error;
+  };
+
+  /** @brief Progress of a @ref session_processor_t */
+  struct progress_t
+  {
+    /** Number of selected frames of all sessions.*/
+    std::size_t total = 0;
+
+    /** Number of processed frames, including the ones waiting for delivery.*/
+    std::size_t processed = 0;
+
+    /** Number of frames delivered in order.*/
+    std::size_t delivered = 0;
+
+    /** Fraction of delivered frames in [0, 1].*/
+    double fraction() const { return total > 0 ? double(delivered) / double(total) : 1.0; }
+  };
+
+  /** @brief Settings of the @ref session_processor_t */
+  struct processor_settings_t
+  {
+    /** Number of shards, each with its own processing context and thread. 0 selects the number of hardware threads.*/
+    std::size_t shard_count = 0;
+
+    /** Number of frames which may be processed ahead of the delivery. 0 selects four frames per shard.*/
+    std::size_t reorder_window = 0;
+
+    /** Processing arguments of all shards.*/
+    ProcessingArgs processing_args;
+
+    /** Called for each new processing context, e.g. to set references.*/
+    std::function<void(ProcessingContext&)> configure;
+
+    /** Called for every frame in order of sessions and frames.*/
+    std::function<void(frame_result_t&)> callback;
+
+    /** Exporter applied to every processed frame in order, may be nullptr. Must outlive the processor.*/
+    Exporter const* exporter = nullptr;
+  };
+
+  /** @brief Processes the frames of one or more sessions in parallel and delivers them in order
+    *
+    * Every shard owns a processing context created from the same calibration, as a processing context must not
+    * be applied concurrently. The shards take the next frame to process from a shared list, so slow frames do
+    * not stall the other shards. The results are reordered and passed to the callback and the exporter in the
+    * order of the sessions and frames, one at a time.
+    * */
+  class session_processor_t
+  {
+  public:
+    /** @brief Creates the processor
+      *
+      * @param[in] calib The calibration to create the processing contexts from
+      * @param[in] settings The settings
+      * */
+    session_processor_t(Calibration const& calib, processor_settings_t settings);
+
+    /** @brief Calls @ref cancel */
+    ~session_processor_t();
+
+    session_processor_t(session_processor_t const&) = delete;
+    session_processor_t& operator=(session_processor_t const&) = delete;
+
+    /** @brief Adds frames of a session, must be called before @ref start
+      *
+      * The frames are selected as by @ref SessionFile::frames, see @ref SessionFile::get_indices.
+      * */
+    void add_session(SessionFile const& session, SessionFile::frame_selection_t const& selection = SessionFile::frame_selection_t());
+
+    /** @brief Starts the shards */
+    void start();
+
+    /** @brief Waits until all frames are delivered, starts the shards if necessary
+      *
+      * Rethrows the first exception of the callback or the exporter, which also stops the processing.
+      * */
+    void wait();
+
+    /** @brief Stops the processing, frames which are not delivered yet are dropped */
+    void cancel();
+
+    /** @brief The aggregated progress of all shards */
+    progress_t progress() const;
+
+  private:
+    struct job_t
+    {
+      std::size_t session;
+      int_t frame;
+      cuvis_session_item_type_t type;
+    };
+
+    void run(std::size_t shard);
+
+    void deliver(std::size_t position, frame_result_t&& result);
+
+    void join();
+
+    processor_settings_t _settings;
+    std::vector<std::unique_ptr<ProcessingContext>> _contexts;
+    std::vector<SessionFile> _sessions;
+    std::vector<job_t> _jobs;
+    std::size_t _window;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _space;
+    std::condition_variable _done;
+    std::vector<std::optional<frame_result_t>> _reorder;
+    std::size_t _next_job = 0;
+    std::size_t _next_delivery = 0;
+    std::size_t _processed = 0;
+    bool _delivering = false;
+    bool _stop = false;
+    std::exception_ptr _error;
+
+    std::vector<std::thread> _threads;
+  };
+
+  /** @cond INTERNAL */
+  inline session_processor_t::session_processor_t(Calibration const& calib, processor_settings_t settings) : _settings(std::move(settings))
+  {
+    std::size_t shard_count = _settings.shard_count;
+    if (shard_count == 0)
+    {
+      shard_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    _window = _settings.reorder_window > 0 ? _settings.reorder_window : 4 * shard_count;
+
+    _contexts.reserve(shard_count);
+    for (std::size_t shard = 0; shard < shard_count; shard++)
+    {
+      auto context = std::make_unique<ProcessingContext>(calib);
+      context->set_processingArgs(_settings.processing_args);
+      if (_settings.configure)
+      {
+        _settings.configure(*context);
+      }
+      _contexts.push_back(std::move(context));
+    }
+  }
+
+  inline session_processor_t::~session_processor_t() { cancel(); }
+
+  inline void session_processor_t::add_session(SessionFile const& session, SessionFile::frame_selection_t const& selection)
+  {
+    if (!_threads.empty())
+    {
+      throw std::runtime_error("sessions must be added before the processing starts");
+    }
+    for (int_t frame : session.get_indices(selection))
+    {
+      _jobs.push_back(job_t{_sessions.size(), frame, selection.type});
+    }
+    _sessions.push_back(session);
+  }
+
+  inline void session_processor_t::start()
+  {
+    if (!_threads.empty())
+    {
+      return;
+    }
+    _reorder = std::vector<std::optional<frame_result_t>>(_window);
+    _threads.reserve(_contexts.size());
+    for (std::size_t shard = 0; shard < _contexts.size(); shard++)
+    {
+      _threads.emplace_back(&session_processor_t::run, this, shard);
+    }
+  }
+
+  inline void session_processor_t::run(std::size_t shard)
+  {
+    ProcessingContext const& context = *_contexts[shard];
+    while (true)
+    {
+      std::size_t position;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        // stay within the reorder window ahead of the delivery
+        _space.wait(lock, [this] { return _stop || _next_job >= _jobs.size() || _next_job < _next_delivery + _window; });
+        if (_stop || _next_job >= _jobs.size())
+        {
+          return;
+        }
+        position = _next_job++;
+      }
+
+      job_t const& job = _jobs[position];
+      frame_result_t result{job.session, job.frame, std::nullopt, nullptr};
+      try
+      {
+        result.mesu = _sessions[job.session].get_mesu(job.frame, job.type);
+        if (result.mesu.has_value())
+        {
+          context.apply(*result.mesu);
+        }
+      }
+      catch (...)
+      {
+        result.mesu.reset();
+        result.error = std::current_exception();
+      }
+
+      deliver(position, std::move(result));
+    }
+  }
+
+  inline void session_processor_t::deliver(std::size_t position, frame_result_t&& result)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _processed++;
+    _reorder[position % _window] = std::move(result);
+    if (_delivering)
+    {
+      // the current delivering thread picks the result up
+      return;
+    }
+
+    _delivering = true;
+    while (!_stop && _next_delivery < _jobs.size() && _reorder[_next_delivery % _window].has_value())
+    {
+      frame_result_t next = std::move(*_reorder[_next_delivery % _window]);
+      _reorder[_next_delivery % _window].reset();
+      lock.unlock();
+
+      std::exception_ptr error;
+      try
+      {
+        if (_settings.exporter != nullptr && next.mesu.has_value())
+        {
+          _settings.exporter->apply(*next.mesu);
+        }
+        if (_settings.callback)
+        {
+          _settings.callback(next);
+        }
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      if (error)
+      {
+        _error = error;
+        _stop = true;
+      }
+      _next_delivery++;
+      _space.notify_all();
+    }
+    _delivering = false;
+    _done.notify_all();
+  }
+
+  inline void session_processor_t::wait()
+  {
+    start();
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this] { return _stop || _next_delivery >= _jobs.size(); });
+    }
+    join();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_error)
+    {
+      std::rethrow_exception(_error);
+    }
+  }
+
+  inline void session_processor_t::cancel()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _space.notify_all();
+    _done.notify_all();
+    join();
+  }
+
+  inline void session_processor_t::join()
+  {
+    for (auto& thread : _threads)
+    {
+      if (thread.joinable())
+      {
+        thread.join();
+      }
+    }
+  }
+
+  inline progress_t session_processor_t::progress() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    progress_t progress;
+    progress.total = _jobs.size();
+    progress.processed = _processed;
+    progress.delivered = _next_delivery;
+    return progress;
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::session
@@ -10,10 +10,16 @@
   * */
 
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cuvis.hpp>
+#include <cuvis_interop_opencv.hpp>
+#include <cuvis_kernels.hpp>
+#include <cuvis_parallel.hpp>
+#include <limits>
 #include <numeric>
-#include <opencv2/opencv.hpp>
+#include <optional>
 #include <vector>
 
 /**
@@ -25,45 +31,7 @@
 namespace cuvis::aux::spectral
 {
 
-  template <typename data_t>
-  inline int get_mat_datatype(int channel_count)
-  {
-    if (channel_count < 1 || channel_count > 511)
-      throw std::invalid_argument("Invalid channel count");
-
-    if constexpr (!std::is_floating_point<data_t>::value)
-    {
-      if constexpr (!std::is_signed<data_t>::value)
-      {
-        switch (sizeof(data_t))
-        {
-          case 1: return CV_MAKETYPE(CV_8U, channel_count);
-          case 2: return CV_MAKETYPE(CV_16U, channel_count);
-          default: throw std::invalid_argument("Invalid bitdepth for unsigned integer data type");
-        }
-      }
-      else
-      {
-        switch (sizeof(data_t))
-        {
-          case 1: return CV_MAKETYPE(CV_8S, channel_count);
-          case 2: return CV_MAKETYPE(CV_16S, channel_count);
-          case 4: return CV_MAKETYPE(CV_32S, channel_count);
-          default: throw std::invalid_argument("Invalid bitdepth for signed integer data type");
-        }
-      }
-    }
-    else
-    {
-      switch (sizeof(data_t))
-      {
-        case 2: return CV_MAKETYPE(CV_16F, channel_count);
-        case 4: return CV_MAKETYPE(CV_32F, channel_count);
-        case 8: return CV_MAKETYPE(CV_64F, channel_count);
-        default: throw std::invalid_argument("Invalid bitdepth for floating point data type");
-      }
-    }
-  }
+  using interop::get_mat_datatype;
 
   /** @brief Couple of wavelength, respective mean value and standard deviation with default values.
    *  
@@ -120,18 +88,324 @@ namespace cuvis::aux::spectral
    * */
   using polygon_t = std::vector<point_t>;
 
-  template <typename data_t>
+  /** @brief A horizontal run of pixels within a single image row
+   *
+   * Covers the pixels [@ref x_begin, @ref x_end) of row @ref y. As the image data is BIP,
+   * the channel vectors of all pixels of a span are contiguous in memory.
+   * */
+  struct span_t
+  {
+    /** The row (y pixel position).*/
+    std::size_t y;
+
+    /** The first pixel in the row (inclusive).*/
+    std::size_t x_begin;
+
+    /** The end of the run (exclusive).*/
+    std::size_t x_end;
+  };
+
+  /** @brief A vector type for describing a rasterized area as spans, sorted by row and x position
+   * */
+  using span_list_t = std::vector<span_t>;
+
+  /** @brief Rasterizes a polygon into row spans.
+    *
+    * The relative polygon coordinates are converted to the nearest absolute pixel position.
+    * A pixel belongs to the polygon if its center lies within or on the boundary of the polygon
+    * (even-odd rule). Only the rows of the polygon's bounding box are visited and spans are clipped
+    * to the image. A single point results in a single pixel, if it is within the image.
+    *
+    * @param[in] poly Polygon in relative coordinates (can also be only 1 point)
+    * @param[in] width The width of the image
+    * @param[in] height The height of the image
+    * @returns A vector of type @ref span_list_t, sorted by row
+    * */
+  inline span_list_t rasterize_polygon(polygon_t const& poly, std::size_t width, std::size_t height)
+  {
+    span_list_t spans;
+    if (poly.empty() || width == 0 || height == 0)
+    {
+      return spans;
+    }
+
+    // conversion of polygon relative coordinates to absolute pixel coordinates
+    // vertices are rounded to pixel positions, so the row and vertex comparisons below are exact.
+    // edge crossings are computed in floating point, a crossing on a pixel center is an integer quotient
+    // without rounding error, so the ceil/floor of the runs includes boundary pixels consistently
+    std::vector<double> vx, vy;
+    vx.reserve(poly.size());
+    vy.reserve(poly.size());
+    for (auto const& pt : poly)
+    {
+      vx.push_back(std::round(pt._x * double(width - 1)));
+      vy.push_back(std::round(pt._y * double(height - 1)));
+    }
+
+    auto const y_range = std::minmax_element(vy.begin(), vy.end());
+    double const y_first = std::max(*y_range.first, 0.0);
+    double const y_last = std::min(*y_range.second, double(height - 1));
+
+    std::vector<double> crossings;
+    std::vector<std::pair<double, double>> runs;
+    for (double y = y_first; y <= y_last; y += 1.0)
+    {
+      crossings.clear();
+      runs.clear();
+
+      for (std::size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++)
+      {
+        double const x0 = vx[j], y0 = vy[j];
+        double const x1 = vx[i], y1 = vy[i];
+
+        if (y0 == y1)
+        {
+          // horizontal edges are part of the boundary
+          if (y == y0)
+          {
+            runs.emplace_back(std::min(x0, x1), std::max(x0, x1));
+          }
+        }
+        else if (y >= std::min(y0, y1) && y < std::max(y0, y1))
+        {
+          // half-open rule, so vertices shared by two edges are counted once
+          crossings.push_back(x0 + (y - y0) * (x1 - x0) / (y1 - y0));
+        }
+
+        // vertices are part of the boundary (covers the bottom vertices, which the half-open rule skips)
+        if (y == y1)
+        {
+          runs.emplace_back(x1, x1);
+        }
+      }
+
+      std::sort(crossings.begin(), crossings.end());
+      for (std::size_t k = 0; k + 1 < crossings.size(); k += 2)
+      {
+        runs.emplace_back(crossings[k], crossings[k + 1]);
+      }
+
+      // convert to pixel runs within the image and merge overlapping runs
+      std::sort(runs.begin(), runs.end());
+      std::size_t const row = static_cast<std::size_t>(y);
+      std::size_t const first_of_row = spans.size();
+      for (auto const& run : runs)
+      {
+        double const left = std::max(std::ceil(run.first), 0.0);
+        double const right = std::min(std::floor(run.second), double(width - 1));
+        if (left > right)
+        {
+          continue;
+        }
+        std::size_t const x_begin = static_cast<std::size_t>(left);
+        std::size_t const x_end = static_cast<std::size_t>(right) + 1;
+        if (spans.size() > first_of_row && x_begin <= spans.back().x_end)
+        {
+          spans.back().x_end = std::max(spans.back().x_end, x_end);
+        }
+        else
+        {
+          spans.push_back(span_t{row, x_begin, x_end});
+        }
+      }
+    }
+    return spans;
+  }
+
+  /** @cond INTERNAL */
+  namespace spectral_impl
+  {
+    /** @brief Running first and second moments of the channel vectors of a set of pixels
+     *
+     * The sums are taken relative to a per-channel shift value (the first pixel visited), which
+     * keeps the variance numerically stable when the mean is large compared to the spread.
+     * */
+    struct moments_t
+    {
+      std::uint64_t n = 0;
+      std::vector<double> shift;
+      std::vector<double> sum;
+      std::vector<double> sq_sum;
+
+      void reset(std::size_t channels)
+      {
+        n = 0;
+        shift.assign(channels, 0.0);
+        sum.assign(channels, 0.0);
+        sq_sum.assign(channels, 0.0);
+      }
+    };
+
+    template <typename data_t>
+    inline void set_shift(image_t<data_t> const& img, span_list_t const& spans, moments_t& moments)
+    {
+      if (spans.empty())
+      {
+        return;
+      }
+      data_t const* px = img._data + (spans.front().y * img._width + spans.front().x_begin) * img._channels;
+      for (std::size_t z = 0; z < img._channels; z++)
+      {
+        moments.shift[z] = double(px[z]);
+      }
+    }
+
+    /** @brief Converts (possibly weighted) shifted moments to mean and standard deviation */
+    inline void finalize(double n, double const* shift, double const* sum, double const* sq_sum, std::uint32_t const* wavelength, spectrum_t& res)
+    {
+      for (std::size_t z = 0; z < res.size(); z++)
+      {
+        res[z].wavelength = wavelength[z];
+        if (!(n > 0.0))
+        {
+          // nothing covered, keep the default value
+          continue;
+        }
+        double const mean_shifted = sum[z] / n;
+        // population variance of the shifted values: E[(x-k)^2] - E[x-k]^2
+        double const var = sq_sum[z] / n - mean_shifted * mean_shifted;
+        res[z].value = shift[z] + mean_shifted;
+        res[z].std = std::sqrt(std::max(var, 0.0));
+      }
+    }
+
+    inline void finalize(moments_t const& moments, std::uint32_t const* wavelength, spectrum_t& res)
+    {
+      finalize(double(moments.n), moments.shift.data(), moments.sum.data(), moments.sq_sum.data(), wavelength, res);
+    }
+
+    /** @brief A span tagged with the index of the region of interest it belongs to */
+    struct roi_span_t
+    {
+      span_t span;
+      std::size_t roi;
+    };
+
+    /** @brief Merges the spans of several regions into one list in memory order
+     *
+     * Overlapping regions simply contribute several spans covering the same pixels.
+     * */
+    inline std::vector<roi_span_t> merge_roi_spans(std::vector<span_list_t> const& roi_spans)
+    {
+      std::vector<roi_span_t> merged;
+      std::size_t total = 0;
+      for (auto const& spans : roi_spans)
+      {
+        total += spans.size();
+      }
+      merged.reserve(total);
+      for (std::size_t roi = 0; roi < roi_spans.size(); roi++)
+      {
+        for (auto const& span : roi_spans[roi])
+        {
+          merged.push_back(roi_span_t{span, roi});
+        }
+      }
+      std::sort(merged.begin(), merged.end(), [](roi_span_t const& a, roi_span_t const& b) {
+        if (a.span.y != b.span.y)
+        {
+          return a.span.y < b.span.y;
+        }
+        if (a.span.x_begin != b.span.x_begin)
+        {
+          return a.span.x_begin < b.span.x_begin;
+        }
+        return a.roi < b.roi;
+      });
+      return merged;
+    }
+
+    /** @brief Accumulates the spans into the moments of their regions, split into row tiles
+     *
+     * The spans are partitioned into the non-empty tiles. Each tile (deterministic) or each worker reduces
+     * into a partial sum, which are then added to the moments in order.
+     * */
+    template <typename data_t>
+    inline void accumulate_roi_spans(image_t<data_t> const& img, std::vector<roi_span_t> const& spans, std::vector<moments_t>& moments, parallel::execution_t const& exec)
+    {
+      std::size_t const channels = img._channels;
+      std::size_t const roi_count = moments.size();
+      std::size_t const tile_rows = std::max<std::size_t>(exec.tile_rows, 1);
+
+      // span ranges of the non-empty tiles, the spans are sorted by row
+      std::vector<std::pair<std::size_t, std::size_t>> tiles;
+      for (std::size_t first = 0; first < spans.size();)
+      {
+        std::size_t const tile = spans[first].span.y / tile_rows;
+        std::size_t last = first + 1;
+        while (last < spans.size() && spans[last].span.y / tile_rows == tile)
+        {
+          last++;
+        }
+        tiles.emplace_back(first, last);
+        first = last;
+      }
+
+      struct partial_t
+      {
+        std::vector<std::uint64_t> n;
+        std::vector<double> sum;
+        std::vector<double> sq_sum;
+      };
+      std::vector<partial_t> partials(exec.deterministic ? tiles.size() : parallel::worker_count(exec));
+
+      parallel::run(exec, tiles.size(), [&](std::size_t task, std::size_t worker) {
+        partial_t& partial = partials[exec.deterministic ? task : worker];
+        if (partial.n.empty())
+        {
+          partial.n.assign(roi_count, 0);
+          partial.sum.assign(roi_count * channels, 0.0);
+          partial.sq_sum.assign(roi_count * channels, 0.0);
+        }
+        for (std::size_t i = tiles[task].first; i < tiles[task].second; i++)
+        {
+          // row-major walk, the channel vectors of a span are contiguous
+          span_t const& span = spans[i].span;
+          std::size_t const roi = spans[i].roi;
+          data_t const* px = img._data + (span.y * img._width + span.x_begin) * channels;
+          std::size_t const pixel_count = span.x_end - span.x_begin;
+          kernels::accumulate_moments(
+              px, pixel_count, channels, moments[roi].shift.data(), partial.sum.data() + roi * channels, partial.sq_sum.data() + roi * channels);
+          partial.n[roi] += pixel_count;
+        }
+      });
+
+      for (auto const& partial : partials)
+      {
+        if (partial.n.empty())
+        {
+          continue;
+        }
+        for (std::size_t roi = 0; roi < roi_count; roi++)
+        {
+          moments[roi].n += partial.n[roi];
+          for (std::size_t z = 0; z < channels; z++)
+          {
+            moments[roi].sum[z] += partial.sum[roi * channels + z];
+            moments[roi].sq_sum[z] += partial.sq_sum[roi * channels + z];
+          }
+        }
+      }
+    }
+  } // namespace spectral_impl
+  /** @endcond */
 
   /** @brief Calculates a spectrum for a polygon.
     *
     * Calculates a spectrum with mean and standard deviation for all 
     * wavelengths for a given polygon, i.e. vector of points.
+    * 
+    * Only the pixels covered by the polygon are visited (see @ref rasterize_polygon), in memory order.
+    * If the polygon does not cover any pixel of the image, the default values of @ref spectral_mean_t are returned.
+    * The image is processed in row tiles as configured by @p exec, see @ref parallel::execution_t.
     *  
     * @param[in] img Cuvis Image data from @ref Measurement
     * @param[in] poly Polygon for subsetting the image (can also be only 1 point)
+    * @param[in] exec Execution settings
     * @returns A vector of type @ref spectrum_t
     * */
-  spectrum_t get_spectrum_polygon(image_t<data_t> const& img, polygon_t const& poly)
+  template <typename data_t>
+  spectrum_t get_spectrum_polygon(image_t<data_t> const& img, polygon_t const& poly, parallel::execution_t const& exec = {})
   {
     //checks if image is reasonable.
     assert(img._width > 1);
@@ -142,189 +416,963 @@ namespace cuvis::aux::spectral
     // initializing the result
     spectrum_t res(img._channels);
 
-    // conversion of polygon relative coordinates to absolute pixel coordinates
-    if (poly.size() > 1) //polygon case
+    std::vector<span_list_t> const spans = {rasterize_polygon(poly, img._width, img._height)};
+
+    std::vector<spectral_impl::moments_t> moments(1);
+    moments[0].reset(img._channels);
+    spectral_impl::set_shift(img, spans[0], moments[0]);
+    spectral_impl::accumulate_roi_spans(img, spectral_impl::merge_roi_spans(spans), moments, exec);
+    spectral_impl::finalize(moments[0], img._wavelength, res);
+
+    return res;
+  }
+
+  /** @brief Calculates the spectra for several polygons at once.
+    *
+    * Equivalent to calling @ref get_spectrum_polygon for every polygon, but the spans of all polygons
+    * are merged and the image is streamed only once, in memory order. Polygons may overlap.
+    * The results are identical to the ones of @ref get_spectrum_polygon with the same execution settings.
+    *  
+    * @param[in] img Cuvis Image data from @ref Measurement
+    * @param[in] polys Polygons for subsetting the image (each can also be only 1 point)
+    * @param[in] exec Execution settings
+    * @returns A vector of type @ref spectrum_t for each polygon, in the order of @p polys
+    * */
+  template <typename data_t>
+  std::vector<spectrum_t> get_spectra_polygons(image_t<data_t> const& img, std::vector<polygon_t> const& polys, parallel::execution_t const& exec = {})
+  {
+    //checks if image is reasonable.
+    assert(img._width > 1);
+    assert(img._height > 1);
+    assert(img._channels > 0);
+    assert(img._wavelength != nullptr);
+
+    std::vector<span_list_t> roi_spans;
+    roi_spans.reserve(polys.size());
+    std::vector<spectral_impl::moments_t> moments(polys.size());
+    for (std::size_t roi = 0; roi < polys.size(); roi++)
+    {
+      roi_spans.push_back(rasterize_polygon(polys[roi], img._width, img._height));
+      moments[roi].reset(img._channels);
+      spectral_impl::set_shift(img, roi_spans.back(), moments[roi]);
+    }
+
+    auto const merged = spectral_impl::merge_roi_spans(roi_spans);
+    spectral_impl::accumulate_roi_spans(img, merged, moments, exec);
+
+    std::vector<spectrum_t> res(polys.size(), spectrum_t(img._channels));
+    for (std::size_t roi = 0; roi < polys.size(); roi++)
+    {
+      spectral_impl::finalize(moments[roi], img._wavelength, res[roi]);
+    }
+    return res;
+  }
+
+  /** @brief Precomputed assignment of image channels to the histograms of @ref get_histogram
+   *
+   * The channels are split into groups of @ref channels_per_histogram neighbouring channels,
+   * each group forms one histogram. Remaining channels at the end of the spectrum are not used.
+   * */
+  struct histogram_layout_t
+  {
+    /** Number of count bins of each histogram.*/
+    std::size_t count_bins;
+
+    /** Number of neighbouring channels accumulated into one histogram.*/
+    std::size_t channels_per_histogram;
+
+    /** Number of histograms (wavelength bins).*/
+    std::size_t histogram_count;
+
+    /** The center wavelength (in nm) of each histogram.*/
+    std::vector<std::uint32_t> wavelength;
+  };
+
+  /** @brief Creates the layout of the histograms for a spectrum.
+    *
+    * @param[in] channels Number of image channels
+    * @param[in] wavelength The wavelengths of the channels
+    * @param[in] count_bins Number of count bins of histogram
+    * @param[in] wavelength_bins Number of wavelength bins of histogram
+    * @returns The layout of type @ref histogram_layout_t
+    * */
+  inline histogram_layout_t make_histogram_layout(std::size_t channels, std::uint32_t const* wavelength, std::size_t count_bins, std::size_t wavelength_bins)
+  {
+    if (channels == 0 || wavelength == nullptr)
+    {
+      throw std::invalid_argument("Invalid spectrum");
+    }
+    if (count_bins == 0 || wavelength_bins == 0)
+    {
+      throw std::invalid_argument("Invalid bin count");
+    }
+
+    histogram_layout_t layout;
+    layout.count_bins = count_bins;
+    layout.channels_per_histogram = std::max<std::size_t>(channels / wavelength_bins, 1);
+    layout.histogram_count = channels / layout.channels_per_histogram;
+    layout.wavelength.resize(layout.histogram_count);
+    for (std::size_t h = 0; h < layout.histogram_count; h++)
     {
+      layout.wavelength[h] = wavelength[h * layout.channels_per_histogram + layout.channels_per_histogram / 2];
+    }
+    return layout;
+  }
+
+  /** @brief The occurrences of all histograms of a @ref histogram_layout_t
+   * */
+  struct histogram_table_t
+  {
+    /** The upper limit of the count range, the count bins evenly divide [0, max_value].*/
+    double max_value;
+
+    /** The occurrences, histogram_count x count_bins, histogram-major.*/
+    std::vector<std::uint64_t> occurrence;
+  };
 
-      std::vector<cv::Point> transformed_pt; //needs to be integers
-      for (auto const& pt : poly)
+  /** @cond INTERNAL */
+  namespace histogram_impl
+  {
+    /** @brief Maps values to the count bins of [0, max_value], the max value is part of the last bin */
+    struct binning_t
+    {
+      double max_value;
+      double scale;
+      std::size_t count_bins;
+
+      binning_t(double max_value, std::size_t count_bins)
+          : max_value(max_value), scale(max_value > 0.0 ? double(count_bins) / max_value : 0.0), count_bins(count_bins)
+      {}
+
+      /** returns count_bins for values outside the range (including NaN) */
+      std::size_t operator()(double v) const
       {
-        transformed_pt.emplace_back(pt._x * (img._width - 1), pt._y * (img._height - 1));
+        if (!(v >= 0.0 && v <= max_value))
+        {
+          return count_bins;
+        }
+        return std::min(static_cast<std::size_t>(v * scale), count_bins - 1);
       }
+    };
 
-      //empty mask
-      cv::Mat mask = cv::Mat::zeros(cv::Size(img._width, img._height), CV_8UC1);
+    /** @brief True, if the raw values are counted directly and folded to the bins afterwards */
+    template <typename data_t>
+    constexpr bool use_raw_table(bool integer_binning)
+    {
+      if constexpr (std::is_same<data_t, std::uint8_t>::value)
+      {
+        return true;
+      }
+      else if constexpr (std::is_same<data_t, std::uint16_t>::value)
+      {
+        return integer_binning;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    /** @brief Pixel range [first, last) of a row tile of an image */
+    inline std::pair<std::size_t, std::size_t> tile_pixels(std::size_t width, std::size_t height, std::size_t tile, parallel::execution_t const& exec)
+    {
+      std::size_t const rows = std::max<std::size_t>(exec.tile_rows, 1);
+      return {tile * rows * width, std::min((tile + 1) * rows, height) * width};
+    }
 
-      // https://docs.opencv.org/4.2.0/db/d75/samples_2cpp_2create_mask_8cpp-example.html#a16
-      // apparently this now has to be wrapped
+    /** @brief Offset of the histogram of each used channel within a table with the given histogram stride */
+    inline void channel_offsets(histogram_layout_t const& layout, std::size_t stride, std::vector<std::size_t>& offset)
+    {
+      std::size_t const used_channels = layout.histogram_count * layout.channels_per_histogram;
+      offset.resize(used_channels);
+      for (std::size_t c = 0; c < used_channels; c++)
+      {
+        offset[c] = (c / layout.channels_per_histogram) * stride;
+      }
+    }
 
-      std::vector<std::vector<cv::Point>> vpts;
-      vpts.push_back(transformed_pt);
+    /** @brief Counts the binned values of the pixels [first, last) into table */
+    template <typename data_t>
+    inline void count_binned(
+        image_t<data_t> const& img, std::vector<std::size_t> const& offset, binning_t const& binning, std::size_t first, std::size_t last, std::uint64_t* table)
+    {
+      std::size_t const used_channels = offset.size();
+      for (std::size_t p = first; p < last; p++)
+      {
+        data_t const* px = img._data + p * img._channels;
+        for (std::size_t c = 0; c < used_channels; c++)
+        {
+          // out of range values go to the extra overflow slot at the end of each histogram
+          table[offset[c] + binning(double(px[c]))]++;
+        }
+      }
+    }
 
-      //binary mask
-      //using nearest neighbor
-      cv::fillPoly(mask, vpts, cv::Scalar(255));
+    /** @brief Counts the raw values of the pixels [first, last) into table, returns the max value of the unused channels */
+    template <typename data_t>
+    inline data_t count_raw(
+        image_t<data_t> const& img, std::vector<std::size_t> const& offset, std::size_t first, std::size_t last, std::uint32_t* table)
+    {
+      std::size_t const used_channels = offset.size();
 
-      std::uint64_t n = 0;                                     //counter variable
-      std::vector<std::double_t> sum_v(img._channels, 0.0);    //growing sum
-      std::vector<std::double_t> sq_sum_v(img._channels, 0.0); //growing square sum
+      data_t max_value = 0;
+      for (std::size_t p = first; p < last; p++)
+      {
+        data_t const* px = img._data + p * img._channels;
+        for (std::size_t c = 0; c < used_channels; c++)
+        {
+          table[offset[c] + px[c]]++;
+        }
+        // unused channels still contribute to the max value
+        for (std::size_t c = used_channels; c < img._channels; c++)
+        {
+          max_value = std::max(max_value, px[c]);
+        }
+      }
+      return max_value;
+    }
 
-      //checking all pixels in polygon mask
-      for (int x = 0; x < img._width; x++)
+    /** @brief The highest occupied raw value of a merged raw table, if above floor */
+    template <typename data_t>
+    inline double max_raw_value(histogram_layout_t const& layout, std::vector<std::uint64_t> const& merged_raw, double floor)
+    {
+      constexpr std::size_t value_count = std::size_t(std::numeric_limits<data_t>::max()) + 1;
+      std::size_t max_value = std::size_t(floor);
+      for (std::size_t h = 0; h < layout.histogram_count; h++)
       {
-        for (int y = 0; y < img._height; y++)
+        for (std::size_t v = value_count; v-- > max_value + 1;)
         {
-          if (mask.at<std::uint8_t>(y, x) > 128)
+          if (merged_raw[h * value_count + v] != 0)
           {
-            n++;
-            for (int z = 0; z < img._channels; z++)
-            {
-              //reading out value
-              auto loc_val = img._data[((y) * img._width + (x)) * img._channels + (z)];
-              //adding up values
-              sum_v[z] += loc_val;
-              sq_sum_v[z] += loc_val * loc_val;
-            }
+            max_value = v;
+            break;
           }
         }
       }
+      return double(max_value);
+    }
+  } // namespace histogram_impl
+  /** @endcond */
 
-      for (int z = 0; z < img._channels; z++)
-      {
-        // convert sum to mean
-        double mean = sum_v[z] / n;
-        spectral_mean_t loc_res;
-        loc_res.value = mean;
+  /** @brief Scratch memory of @ref compute_histogram_table
+   *
+   * Keeping a workspace for repeated calls with the same layout avoids reallocating the per-worker tables.
+   * */
+  struct histogram_workspace_t
+  {
+    /** Offset of the histogram of each channel within a table.*/
+    std::vector<std::size_t> offset;
+
+    /** Private binned tables of each worker.*/
+    std::vector<std::vector<std::uint64_t>> binned;
+
+    /** Private raw value tables of each worker.*/
+    std::vector<std::vector<std::uint32_t>> raw;
 
-        // sum(x - y)^2 = sum( x^2 - 2xy + y^2) // second binomial formula
-        // Therefore: (sum(x^2) - 2 * sum(x) * y + n*y^2 ) / n
-        // Therefore (sum(x^2) - 2 * sum(x) * y ) / n + y^2
-        loc_res.std = sqrt((sq_sum_v[z] - 2 * sum_v[z] * mean) / n + mean * mean);
+    /** Tables of the workers that took part in the current call.*/
+    std::vector<char> used;
 
-        // set wavelength
-        std::uint32_t loc_wl = img._wavelength[z];
-        loc_res.wavelength = loc_wl;
-        res[z] = loc_res;
+    /** Merged raw value table.*/
+    std::vector<std::uint64_t> merged_raw;
+
+    /** Max value of each tile.*/
+    std::vector<double> max_value;
+  };
+
+  /** @cond INTERNAL */
+  namespace histogram_impl
+  {
+    template <typename data_t>
+    inline void compute_raw(
+        image_t<data_t> const& img,
+        histogram_layout_t const& layout,
+        std::optional<double> max_value,
+        parallel::execution_t const& exec,
+        histogram_workspace_t& ws,
+        histogram_table_t& res)
+    {
+      constexpr std::size_t value_count = std::size_t(std::numeric_limits<data_t>::max()) + 1;
+      std::size_t const table_size = layout.histogram_count * value_count;
+      std::size_t const tile_count = parallel::tile_count(exec, img._height);
+      std::size_t const worker_count = parallel::worker_count(exec);
+
+      // private raw tables per worker, merged before folding to the bins
+      channel_offsets(layout, value_count, ws.offset);
+      ws.raw.resize(worker_count);
+      ws.used.assign(worker_count, 0);
+      ws.max_value.assign(tile_count, 0.0);
+      parallel::run(exec, tile_count, [&](std::size_t tile, std::size_t worker) {
+        if (!ws.used[worker])
+        {
+          ws.raw[worker].assign(table_size, 0);
+          ws.used[worker] = 1;
+        }
+        auto const pixels = tile_pixels(img._width, img._height, tile, exec);
+        ws.max_value[tile] = double(count_raw(img, ws.offset, pixels.first, pixels.second, ws.raw[worker].data()));
+      });
+
+      ws.merged_raw.assign(table_size, 0);
+      for (std::size_t worker = 0; worker < worker_count; worker++)
+      {
+        if (!ws.used[worker])
+        {
+          continue;
+        }
+        for (std::size_t i = 0; i < table_size; i++)
+        {
+          ws.merged_raw[i] += ws.raw[worker][i];
+        }
       }
 
-      return res;
+      if (max_value)
+      {
+        res.max_value = *max_value;
+      }
+      else
+      {
+        // the max value of the used channels is the highest occupied raw value of the merged table
+        double const unused_max = tile_count > 0 ? *std::max_element(ws.max_value.begin(), ws.max_value.end()) : 0.0;
+        res.max_value = max_raw_value<data_t>(layout, ws.merged_raw, unused_max);
+      }
+      res.occurrence.assign(layout.histogram_count * layout.count_bins, 0);
+
+      binning_t const binning(res.max_value, layout.count_bins);
+      for (std::size_t v = 0; v < value_count; v++)
+      {
+        std::size_t const bin = binning(double(v));
+        if (bin == layout.count_bins)
+        {
+          continue;
+        }
+        for (std::size_t h = 0; h < layout.histogram_count; h++)
+        {
+          res.occurrence[h * layout.count_bins + bin] += ws.merged_raw[h * value_count + v];
+        }
+      }
     }
-    else if (poly.size() == 1) //single point case
+
+    template <typename data_t>
+    inline void compute_binned(
+        image_t<data_t> const& img,
+        histogram_layout_t const& layout,
+        std::optional<double> max_value,
+        parallel::execution_t const& exec,
+        histogram_workspace_t& ws,
+        histogram_table_t& res)
     {
-      //check if out of range
-      if (poly.front()._x > 1.0 || poly.front()._x < 0.0 || poly.front()._y > 1.0 || poly.front()._y < 0.0)
+      std::size_t const tile_count = parallel::tile_count(exec, img._height);
+      std::size_t const worker_count = parallel::worker_count(exec);
+
+      if (max_value)
       {
-        // outside range. nothing to return
-        // TODO throw error?
-        return res;
+        res.max_value = *max_value;
       }
+      else
+      {
+        // the bins depend on the max value, so it needs a separate (vectorizable) pass over the contiguous data
+        ws.max_value.assign(tile_count, 0.0);
+        parallel::run(exec, tile_count, [&](std::size_t tile, std::size_t) {
+          auto const pixels = tile_pixels(img._width, img._height, tile, exec);
+          data_t const* first = img._data + pixels.first * img._channels;
+          data_t const* last = img._data + pixels.second * img._channels;
+          ws.max_value[tile] = first != last ? double(*std::max_element(first, last)) : 0.0;
+        });
+        res.max_value = tile_count > 0 ? *std::max_element(ws.max_value.begin(), ws.max_value.end()) : 0.0;
+      }
+
+      // each histogram has an extra slot at the end for out of range values
+      std::size_t const stride = layout.count_bins + 1;
+      std::size_t const table_size = layout.histogram_count * stride;
+      binning_t const binning(res.max_value, layout.count_bins);
+
+      channel_offsets(layout, stride, ws.offset);
+      ws.binned.resize(worker_count);
+      ws.used.assign(worker_count, 0);
+      parallel::run(exec, tile_count, [&](std::size_t tile, std::size_t worker) {
+        if (!ws.used[worker])
+        {
+          ws.binned[worker].assign(table_size, 0);
+          ws.used[worker] = 1;
+        }
+        auto const pixels = tile_pixels(img._width, img._height, tile, exec);
+        count_binned(img, ws.offset, binning, pixels.first, pixels.second, ws.binned[worker].data());
+      });
 
-      for (int z = 0; z < img._channels; z++)
+      res.occurrence.assign(layout.histogram_count * layout.count_bins, 0);
+      for (std::size_t worker = 0; worker < worker_count; worker++)
       {
-        //calculate position in memory
-        int y_shift = std::round(poly.front()._y * (img._height - 1)) * img._width;
-        int xy_shift = y_shift + std::round(poly.front()._x * (img._width - 1));
-        //read out point value
-        double loc_val = img._data[xy_shift * img._channels + z];
-        //set wavelength and value
-        std::uint32_t loc_wl = img._wavelength[z];
-        spectral_mean_t loc_res;
-        loc_res.value = loc_val;
-        loc_res.wavelength = loc_wl;
-        res[z] = (loc_res);
+        if (!ws.used[worker])
+        {
+          continue;
+        }
+        for (std::size_t h = 0; h < layout.histogram_count; h++)
+        {
+          for (std::size_t b = 0; b < layout.count_bins; b++)
+          {
+            res.occurrence[h * layout.count_bins + b] += ws.binned[worker][h * stride + b];
+          }
+        }
       }
-      return res;
     }
-    else // poly is empty should never happen
+  } // namespace histogram_impl
+  /** @endcond */
+
+  /** @brief Computes all histograms of a layout in a single streaming pass over the image.
+    *
+    * The image is split into row tiles as configured by @p exec. Each worker counts its tiles into a private table,
+    * the tables are merged at the end, so the result does not depend on the execution settings.
+    * The count bins evenly divide [0, max value], the max value itself is counted in the last bin, values outside
+    * of the range are not counted.
+    *
+    * With integer binning, the raw values are counted exactly and folded to the count bins afterwards. As the
+    * max value is then known from the raw counts, no additional pass is needed to detect it. Integer binning
+    * is always used for uint8 data and can be enabled for uint16 raw counts, at the cost of a 64k entry table
+    * per histogram and worker. For other data types, detecting the max value takes a separate pass.
+    *
+    * @param[in] img Cuvis Image data from @ref Measurement
+    * @param[in] layout Layout created with @ref make_histogram_layout for the image
+    * @param[in] max_value Upper limit of the count range, it is detected from the data if not set
+    * @param[in] integer_binning Count the raw values of uint16 data
+    * @param[in] exec Execution settings
+    * @param[in,out] workspace Scratch memory, can be reused for subsequent calls
+    * @param[out] res The occurrences and the used max value
+    * */
+  template <typename data_t>
+  void compute_histogram_table(
+      image_t<data_t> const& img,
+      histogram_layout_t const& layout,
+      std::optional<double> max_value,
+      bool integer_binning,
+      parallel::execution_t const& exec,
+      histogram_workspace_t& workspace,
+      histogram_table_t& res)
+  {
+    static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+    assert(img._data != nullptr);
+    assert(layout.histogram_count * layout.channels_per_histogram <= img._channels);
+
+    if constexpr (sizeof(data_t) <= 2 && std::is_integral<data_t>::value)
     {
-      // TODO throw error?
-      return res;
+      // the raw tables count uint32 occurrences per value
+      if (histogram_impl::use_raw_table<data_t>(integer_binning)
+          && img._width * img._height * layout.channels_per_histogram < std::numeric_limits<std::uint32_t>::max())
+      {
+        histogram_impl::compute_raw(img, layout, max_value, exec, workspace, res);
+        return;
+      }
+    }
+    histogram_impl::compute_binned(img, layout, max_value, exec, workspace, res);
+  }
+
+  /** @brief Computes all histograms of a layout in a single streaming pass over the image.
+    *
+    * See @ref compute_histogram_table(image_t<data_t> const&, histogram_layout_t const&, std::optional<double>, bool, parallel::execution_t const&, histogram_workspace_t&, histogram_table_t&).
+    *
+    * @param[in] img Cuvis Image data from @ref Measurement
+    * @param[in] layout Layout created with @ref make_histogram_layout for the image
+    * @param[in] max_value Upper limit of the count range, it is detected from the data if not set
+    * @param[in] integer_binning Count the raw values of uint16 data
+    * @param[in] exec Execution settings
+    * @returns The occurrences and the used max value
+    * */
+  template <typename data_t>
+  histogram_table_t compute_histogram_table(
+      image_t<data_t> const& img,
+      histogram_layout_t const& layout,
+      std::optional<double> max_value,
+      bool integer_binning = false,
+      parallel::execution_t const& exec = {})
+  {
+    histogram_workspace_t workspace;
+    histogram_table_t res;
+    compute_histogram_table(img, layout, max_value, integer_binning, exec, workspace, res);
+    return res;
+  }
+
+  /** @brief Converts a histogram table to the output format of @ref get_histogram.
+    *
+    * @param[in] layout The layout of the histograms
+    * @param[in] table The occurrences of the histograms
+    * @param[in] proc_mode The processing mode of the image, reflectance counts are given in percent
+    * @returns A vector of type @ref histogram_vector_t
+    * */
+  inline histogram_vector_t make_histogram_vector(histogram_layout_t const& layout, histogram_table_t const& table, cuvis_processing_mode_t proc_mode)
+  {
+    const double bin_size = table.max_value / double(layout.count_bins);
+
+    histogram_vector_t output(layout.histogram_count);
+    for (std::size_t h = 0; h < layout.histogram_count; h++)
+    {
+      histogram_t& histogram = output[h];
+      histogram.wavelength = layout.wavelength[h];
+      auto const first = table.occurrence.begin() + h * layout.count_bins;
+      histogram.occurrence.assign(first, first + layout.count_bins);
+      histogram.count.resize(layout.count_bins);
+
+      // set x-axis labels
+      for (std::size_t idx = 0; idx < layout.count_bins; idx++)
+      {
+        if (proc_mode == Cube_Reflectance)
+        {
+          histogram.count[idx] = static_cast<std::float_t>((idx * bin_size) / 100.0);
+        }
+        else
+        {
+          histogram.count[idx] = static_cast<std::float_t>(idx * bin_size);
+        }
+      }
     }
+    return output;
   }
 
   /** @brief Calculates a histogram for an image
     *
     * Calculates a histogram for all wavelengths with counts and occurence
     * for a given Cuvis @ref Measurement Image.
+    * All histograms are computed in a single pass, see @ref compute_histogram_table.
     *  
     * @param[in] img Cuvis Image data from @ref Measurement
     * @param[in] histogram_min_size Lower limit for image data points
     * @param[in] count_bins Number of count bins of histogram
     * @param[in] wavelength_bins Number of wavelength bins of histogram
+    * @param[in] detect_max_value Use the max value of the image as upper limit instead of the max of the data type
+    * @param[in] proc_mode The processing mode of the image
+    * @param[in] integer_binning Count the raw values of uint16 data
+    * @param[in] exec Execution settings
     * @returns A vector of type @ref histogram_vector_t
     * */
   template <typename data_t>
-  histogram_vector_t get_histogram(image_t<data_t> const& img, size_t histogram_min_size, size_t count_bins, size_t wavelength_bins, bool detect_max_value, cuvis_processing_mode_t proc_mode)
+  histogram_vector_t get_histogram(
+      image_t<data_t> const& img,
+      size_t histogram_min_size,
+      size_t count_bins,
+      size_t wavelength_bins,
+      bool detect_max_value,
+      cuvis_processing_mode_t proc_mode,
+      bool integer_binning = false,
+      parallel::execution_t const& exec = {})
   {
-    histogram_vector_t output;
     // Check if data is available and that the image is large enough
     assert(img._height * img._width * img._channels > histogram_min_size);
     assert(img._wavelength != nullptr);
 
-    auto mat_datatype = get_mat_datatype<data_t>(img._channels);
+    auto const layout = make_histogram_layout(img._channels, img._wavelength, count_bins, wavelength_bins);
+
+    std::optional<double> max_value;
+    if (!detect_max_value)
+    {
+      max_value = double(std::numeric_limits<data_t>::max());
+    }
+
+    auto const table = compute_histogram_table(img, layout, max_value, integer_binning, exec);
+    return make_histogram_vector(layout, table, proc_mode);
+  }
+
+  /** @brief Settings of a @ref spectral_accumulator_t
+   * */
+  struct accumulator_settings_t
+  {
+    /** Number of frames in the sliding window. Ignored, if @ref alpha is set.*/
+    std::size_t window = 1;
+
+    /** Weight of the newest frame for exponentially weighted statistics, in (0, 1]. Zero selects the sliding window.*/
+    double alpha = 0.0;
+
+    /** Number of count bins of the histograms. Zero disables the histograms.*/
+    std::size_t count_bins = 0;
+
+    /** Number of wavelength bins of the histograms.*/
+    std::size_t wavelength_bins = 1;
+
+    /** Upper limit of the histogram count range. If not set, the max value of the first frame is used.*/
+    std::optional<double> max_value;
+
+    /** Count the raw values of uint16 data, see @ref compute_histogram_table.*/
+    bool integer_binning = false;
+
+    /** Execution settings for the spectra and histograms.*/
+    parallel::execution_t execution;
+
+    /** The processing mode of the frames, reflectance histogram counts are given in percent.*/
+    cuvis_processing_mode_t processing_mode = Cube_Raw;
+  };
+
+  /** @brief Temporal spectra and histograms over consecutive frames
+    *
+    * Created once for a set of regions of interest and a histogram configuration. The polygon rasters,
+    * histogram layout and bins are precomputed, so feeding a frame only streams the image data and
+    * keeps a compact per-frame summary. No image data is kept.
+    *
+    * The statistics cover either the last @ref accumulator_settings_t::window frames or are
+    * exponentially weighted with @ref accumulator_settings_t::alpha. Spectra are the mean and standard
+    * deviation of all pixels of a region over all frames in the statistics.
+    * The histogram count range is fixed with the first frame.
+    *
+    * @tparam data_t The data type of the images
+    * */
+  template <typename data_t>
+  class spectral_accumulator_t
+  {
+  public:
+    /** @brief Creates an accumulator for frames like the reference image.
+      *
+      * @param[in] reference Image defining the size and wavelengths of all frames
+      * @param[in] polys Regions of interest (each can also be only 1 point)
+      * @param[in] settings The settings of the accumulator
+      * */
+    spectral_accumulator_t(image_t<data_t> const& reference, std::vector<polygon_t> const& polys, accumulator_settings_t const& settings);
+
+    /** @brief Adds a frame to the statistics
+      *
+      * @param[in] img The frame, must match the reference image
+      * */
+    void feed(image_t<data_t> const& img);
+
+    /** @brief Adds the image of a measurement to the statistics
+      *
+      * @param[in] mesu The measurement
+      * @param[in] key The key of the image in @ref Measurement::get_imdata
+      * */
+    void feed(Measurement const& mesu, std::string const& key = CUVIS_MESU_CUBE_KEY);
+
+    /** @brief Drops all frames, the next frame fixes the shift values and histogram range again */
+    void reset();
+
+    /** @brief Number of frames within the statistics */
+    std::size_t frame_count() const { return _frame_count; }
+
+    /** @brief Spectra of the regions of interest, in the order of the polygons */
+    std::vector<spectrum_t> get_spectra() const;
+
+    /** @brief Histograms over all frames of the statistics
+      *
+      * For exponentially weighted statistics, the occurrences are rounded weighted averages per frame.
+      * */
+    histogram_vector_t get_histogram() const;
+
+  private:
+    /** summary of a single frame */
+    struct frame_t
+    {
+      std::vector<spectral_impl::moments_t> moments;
+      histogram_table_t histogram;
+    };
+
+    bool matches(image_t<data_t> const& img) const;
+
+    void summarize(image_t<data_t> const& img, frame_t& frame);
+
+    void add_exponential(frame_t const& frame);
+
+    std::size_t _width;
+    std::size_t _height;
+    std::size_t _channels;
+    std::vector<std::uint32_t> _wavelength;
+    accumulator_settings_t _settings;
+    std::size_t _roi_count;
+
+    std::vector<span_list_t> _roi_spans;
+    std::vector<spectral_impl::roi_span_t> _merged_spans;
+    /** per roi shift values, fixed with the first frame */
+    std::vector<std::vector<double>> _shift;
+
+    std::optional<histogram_layout_t> _layout;
+    std::optional<double> _max_value;
+    histogram_workspace_t _workspace;
+
+    /** sliding window: ring of frame summaries and the running histogram total */
+    std::vector<frame_t> _frames;
+    std::size_t _next = 0;
+    std::vector<std::uint64_t> _occurrence_total;
+
+    /** exponential weighting */
+    frame_t _current;
+    std::vector<double> _weight;
+    std::vector<std::vector<double>> _sum;
+    std::vector<std::vector<double>> _sq_sum;
+    std::vector<double> _occurrence_weighted;
 
-    // Yes, the 'const' needs to be removed, OpenCV does not have a cv::ConstMat
-    // Making the Mat itself const only means that the Mat header (meta-data) is const.
-    // ! Make sure that data in this Mat is not modified in this function !
-    const cv::Mat const_img_mat(cv::Size(img._width, img._height), mat_datatype, const_cast<void*>(static_cast<const void*>(img._data)));
+    std::size_t _frame_count = 0;
+  };
+
+  /** @cond INTERNAL */
+  template <typename data_t>
+  inline spectral_accumulator_t<data_t>::spectral_accumulator_t(
+      image_t<data_t> const& reference, std::vector<polygon_t> const& polys, accumulator_settings_t const& settings)
+      : _width(reference._width),
+        _height(reference._height),
+        _channels(reference._channels),
+        _wavelength(reference._wavelength, reference._wavelength + reference._channels),
+        _settings(settings),
+        _roi_count(polys.size())
+  {
+    if (_settings.alpha < 0.0 || _settings.alpha > 1.0)
+    {
+      throw std::invalid_argument("alpha must be within [0, 1]");
+    }
+    if (_settings.alpha == 0.0 && _settings.window == 0)
+    {
+      throw std::invalid_argument("window must contain at least one frame");
+    }
 
-    // Find maximum value for all data
-    double max_val = 0;
-    if (detect_max_value)
+    _roi_spans.reserve(_roi_count);
+    for (auto const& poly : polys)
     {
-      cv::minMaxLoc(const_img_mat, nullptr, &max_val, nullptr, nullptr);
+      _roi_spans.push_back(rasterize_polygon(poly, _width, _height));
+    }
+    _merged_spans = spectral_impl::merge_roi_spans(_roi_spans);
+    _shift.assign(_roi_count, std::vector<double>(_channels, 0.0));
+
+    if (_settings.count_bins > 0)
+    {
+      _layout = make_histogram_layout(_channels, _wavelength.data(), _settings.count_bins, _settings.wavelength_bins);
+    }
+
+    auto const init_frame = [&](frame_t& frame) {
+      frame.moments.resize(_roi_count);
+      for (auto& moments : frame.moments)
+      {
+        moments.reset(_channels);
+      }
+    };
+
+    if (_settings.alpha > 0.0)
+    {
+      init_frame(_current);
+      _weight.assign(_roi_count, 0.0);
+      _sum.assign(_roi_count, std::vector<double>(_channels, 0.0));
+      _sq_sum.assign(_roi_count, std::vector<double>(_channels, 0.0));
     }
     else
     {
-      max_val = double(std::numeric_limits<data_t>::max());
+      _frames.resize(_settings.window);
+      for (auto& frame : _frames)
+      {
+        init_frame(frame);
+      }
+    }
+  }
+
+  template <typename data_t>
+  inline bool spectral_accumulator_t<data_t>::matches(image_t<data_t> const& img) const
+  {
+    return img._data != nullptr && img._width == _width && img._height == _height && img._channels == _channels;
+  }
+
+  template <typename data_t>
+  inline void spectral_accumulator_t<data_t>::summarize(image_t<data_t> const& img, frame_t& frame)
+  {
+    // all frames share the shift values, so their moments can be added
+    for (std::size_t roi = 0; roi < _roi_count; roi++)
+    {
+      auto& moments = frame.moments[roi];
+      moments.n = 0;
+      std::copy(_shift[roi].begin(), _shift[roi].end(), moments.shift.begin());
+      std::fill(moments.sum.begin(), moments.sum.end(), 0.0);
+      std::fill(moments.sq_sum.begin(), moments.sq_sum.end(), 0.0);
     }
+    spectral_impl::accumulate_roi_spans(img, _merged_spans, frame.moments, _settings.execution);
 
-    const double bin_size = max_val / double(count_bins);
-    const double wlbin_size = double(img._channels) / double(wavelength_bins);
-    const int img_channels_per_wlbin = static_cast<const int>(wlbin_size);
-    const int histogram_count = img._channels / img_channels_per_wlbin;
+    if (_layout)
+    {
+      compute_histogram_table(img, *_layout, _max_value, _settings.integer_binning, _settings.execution, _workspace, frame.histogram);
+    }
+  }
 
-    // Calculate histograms
-    for (int count = 0; count < histogram_count; count++)
+  template <typename data_t>
+  inline void spectral_accumulator_t<data_t>::add_exponential(frame_t const& frame)
+  {
+    // the first frame initializes the statistics, so they are not biased towards zero
+    double const alpha = _frame_count == 0 ? 1.0 : _settings.alpha;
+    double const keep = 1.0 - alpha;
+    for (std::size_t roi = 0; roi < _roi_count; roi++)
     {
-      int bins[] = {int(count_bins)};
-      float range[] = {0.0f, float(max_val)};
-      const float* ranges[] = {range};
-      cv::Mat hist;
+      auto const& moments = frame.moments[roi];
+      _weight[roi] = keep * _weight[roi] + alpha * double(moments.n);
+      for (std::size_t z = 0; z < _channels; z++)
+      {
+        _sum[roi][z] = keep * _sum[roi][z] + alpha * moments.sum[z];
+        _sq_sum[roi][z] = keep * _sq_sum[roi][z] + alpha * moments.sq_sum[z];
+      }
+    }
 
-      int channels[] = {0};
-      // Accumulate histograms per channel
-      for (int c = 0; c < img_channels_per_wlbin; c++)
+    if (_layout)
+    {
+      _occurrence_weighted.resize(frame.histogram.occurrence.size(), 0.0);
+      for (std::size_t i = 0; i < _occurrence_weighted.size(); i++)
       {
-        channels[0] = c + count * img_channels_per_wlbin;
-        bool accumulate = c != 0;
-        cv::calcHist(&const_img_mat, 1, channels, cv::Mat(), hist, 1, bins, ranges, true, accumulate);
+        _occurrence_weighted[i] = keep * _occurrence_weighted[i] + alpha * double(frame.histogram.occurrence[i]);
       }
+    }
+  }
 
-      // Prepare histogram data struct
-      histogram_t histogram;
-      histogram.occurrence = std::vector<std::uint64_t>(hist.total());
-      histogram.count = std::vector<std::float_t>(hist.total());
-      histogram.wavelength = img._wavelength[count * img_channels_per_wlbin + int(img_channels_per_wlbin / 2)];
+  template <typename data_t>
+  inline void spectral_accumulator_t<data_t>::feed(image_t<data_t> const& img)
+  {
+    if (!matches(img))
+    {
+      throw std::invalid_argument("Image does not match the accumulator");
+    }
 
-      // Transfer histogram counts & set x-axis labels
-      for (int idx = 0; idx < hist.total(); idx++)
+    if (_frame_count == 0)
+    {
+      // fix the per roi shift values and the histogram range with the first frame
+      for (std::size_t roi = 0; roi < _roi_count; roi++)
       {
-        // Note: calcHist always returns counts as floats
-        histogram.occurrence[idx] = static_cast<std::uint64_t>(reinterpret_cast<float*>(hist.data)[idx]);
-        if (proc_mode == Cube_Reflectance)
+        spectral_impl::moments_t moments;
+        moments.reset(_channels);
+        spectral_impl::set_shift(img, _roi_spans[roi], moments);
+        _shift[roi] = std::move(moments.shift);
+      }
+      _max_value = _settings.max_value;
+    }
+
+    if (_settings.alpha > 0.0)
+    {
+      summarize(img, _current);
+      add_exponential(_current);
+      if (_layout && !_max_value)
+      {
+        _max_value = _current.histogram.max_value;
+      }
+      _frame_count++;
+      return;
+    }
+
+    frame_t& frame = _frames[_next];
+    if (_layout && _frame_count == _frames.size())
+    {
+      // the oldest frame leaves the window
+      for (std::size_t i = 0; i < _occurrence_total.size(); i++)
+      {
+        _occurrence_total[i] -= frame.histogram.occurrence[i];
+      }
+    }
+
+    summarize(img, frame);
+
+    if (_layout)
+    {
+      if (!_max_value)
+      {
+        _max_value = frame.histogram.max_value;
+      }
+      _occurrence_total.resize(frame.histogram.occurrence.size(), 0);
+      for (std::size_t i = 0; i < _occurrence_total.size(); i++)
+      {
+        _occurrence_total[i] += frame.histogram.occurrence[i];
+      }
+    }
+
+    _next = (_next + 1) % _frames.size();
+    _frame_count = std::min(_frame_count + 1, _frames.size());
+  }
+
+  template <typename data_t>
+  inline void spectral_accumulator_t<data_t>::feed(Measurement const& mesu, std::string const& key)
+  {
+    auto const* imdata = mesu.get_imdata();
+    auto const it = imdata->find(key);
+    if (it == imdata->end())
+    {
+      throw std::invalid_argument("Measurement does not contain the image");
+    }
+    auto const* img = std::get_if<image_t<data_t>>(&it->second);
+    if (img == nullptr)
+    {
+      throw std::invalid_argument("Image has a different data type");
+    }
+    feed(*img);
+  }
+
+  template <typename data_t>
+  inline void spectral_accumulator_t<data_t>::reset()
+  {
+    _frame_count = 0;
+    _next = 0;
+    _max_value.reset();
+    _occurrence_total.clear();
+    _occurrence_weighted.clear();
+    std::fill(_weight.begin(), _weight.end(), 0.0);
+    for (std::size_t roi = 0; roi < _sum.size(); roi++)
+    {
+      std::fill(_sum[roi].begin(), _sum[roi].end(), 0.0);
+      std::fill(_sq_sum[roi].begin(), _sq_sum[roi].end(), 0.0);
+    }
+  }
+
+  template <typename data_t>
+  inline std::vector<spectrum_t> spectral_accumulator_t<data_t>::get_spectra() const
+  {
+    std::vector<spectrum_t> res(_roi_count, spectrum_t(_channels));
+    if (_frame_count == 0)
+    {
+      for (auto& spectrum : res)
+      {
+        for (std::size_t z = 0; z < _channels; z++)
         {
-          histogram.count[idx] = static_cast<std::float_t>((idx * bin_size) / 100.0);
+          spectrum[z].wavelength = _wavelength[z];
         }
-        else
+      }
+      return res;
+    }
+
+    if (_settings.alpha > 0.0)
+    {
+      for (std::size_t roi = 0; roi < _roi_count; roi++)
+      {
+        spectral_impl::finalize(_weight[roi], _shift[roi].data(), _sum[roi].data(), _sq_sum[roi].data(), _wavelength.data(), res[roi]);
+      }
+      return res;
+    }
+
+    // sum up the window from the oldest to the newest frame
+    std::size_t const first = (_next + _frames.size() - _frame_count) % _frames.size();
+    std::vector<double> sum(_channels), sq_sum(_channels);
+    for (std::size_t roi = 0; roi < _roi_count; roi++)
+    {
+      std::uint64_t n = 0;
+      std::fill(sum.begin(), sum.end(), 0.0);
+      std::fill(sq_sum.begin(), sq_sum.end(), 0.0);
+      for (std::size_t f = 0; f < _frame_count; f++)
+      {
+        auto const& moments = _frames[(first + f) % _frames.size()].moments[roi];
+        n += moments.n;
+        for (std::size_t z = 0; z < _channels; z++)
         {
-          histogram.count[idx] = static_cast<std::float_t>(idx * bin_size);
+          sum[z] += moments.sum[z];
+          sq_sum[z] += moments.sq_sum[z];
         }
       }
+      spectral_impl::finalize(double(n), _shift[roi].data(), sum.data(), sq_sum.data(), _wavelength.data(), res[roi]);
+    }
+    return res;
+  }
 
-      output.push_back(histogram);
+  template <typename data_t>
+  inline histogram_vector_t spectral_accumulator_t<data_t>::get_histogram() const
+  {
+    if (!_layout || _frame_count == 0)
+    {
+      return histogram_vector_t();
     }
-    return output;
+
+    histogram_table_t table;
+    table.max_value = *_max_value;
+    if (_settings.alpha > 0.0)
+    {
+      table.occurrence.resize(_occurrence_weighted.size());
+      for (std::size_t i = 0; i < table.occurrence.size(); i++)
+      {
+        table.occurrence[i] = static_cast<std::uint64_t>(std::llround(_occurrence_weighted[i]));
+      }
+    }
+    else
+    {
+      table.occurrence = _occurrence_total;
+    }
+    return make_histogram_vector(*_layout, table, _settings.processing_mode);
   }
+  /** @endcond */
 
-} // namespace cuvis::aux::spectral
\ No newline at end of file
+} // namespace cuvis::aux::spectral
@@ -0,0 +1,1210 @@
+#pragma once
+
+/** @file cuvis_stream.hpp
+  *
+  *
+  * @details Streaming of processed cubes and views to other processes, through shared memory or TCP.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <cuvis.hpp>
+
+#if defined(__unix__)
+  #include <arpa/inet.h>
+  #include <fcntl.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <poll.h>
+  #include <sys/mman.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/uio.h>
+  #include <unistd.h>
+#endif
+
+/**
+  * @brief Streaming of measurements to other processes.
+  *
+  * A publisher sends the processed cube of a measurement or the images of a view as frames. Every frame carries a fixed
+  * size @ref frame_header_t, followed by the wavelengths, a few strings of the meta data and the raw pixel data in
+  * BIP interleave. The frames are published through a shared memory ring on the same host, which subscribers read
+  * in place, or through TCP to other hosts. The transports are only available on POSIX systems.
+  * */
+namespace cuvis::aux::stream
+{
+  /** @brief Content of a frame */
+  enum class payload_kind_t : std::uint16_t
+  {
+    /** The processed cube of a measurement.*/
+    cube = 0,
+
+    /** An image of a view, see @ref Viewer::view_data_t.*/
+    view = 1
+  };
+
+  /** @brief Pixel data type of a frame */
+  enum class data_type_t : std::uint8_t
+  {
+    uint8 = 0,
+    uint16 = 1,
+    uint32 = 2,
+    float32 = 3
+  };
+
+  /** @brief The fixed size header of a frame, in host byte order */
+  struct frame_header_t
+  {
+    /** @ref frame_magic.*/
+    std::uint32_t magic;
+
+    /** @ref frame_version.*/
+    std::uint16_t version;
+
+    /** A @ref payload_kind_t.*/
+    std::uint16_t kind;
+
+    /** A @ref data_type_t.*/
+    std::uint8_t data_type;
+
+    /** The @ref cuvis_view_category_t of a view.*/
+    std::uint8_t view_category;
+
+    /** Whether a view is meant to be shown, see @ref view_t::_show.*/
+    std::uint8_t show;
+
+    std::uint8_t reserved;
+
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t channels;
+
+    /** Number of wavelengths following the header, either 0 or @ref channels.*/
+    std::uint32_t wavelength_count;
+
+    /** Bytes between the header and the pixel data: the wavelengths, the strings and padding to 8 bytes.*/
+    std::uint32_t section_bytes;
+
+    /** Bytes of the pixel data.*/
+    std::uint64_t payload_bytes;
+
+    /** Number of the frame assigned by the publisher, counting from 0. Frames dropped by the transport leave gaps.*/
+    std::uint64_t sequence;
+
+    /** @ref MeasurementMetaData::frame_id.*/
+    std::uint64_t frame_id;
+
+    /** @ref MeasurementMetaData::capture_time in nanoseconds since the epoch.*/
+    std::int64_t capture_time_ns;
+
+    /** @ref MeasurementMetaData::integration_time.*/
+    double integration_time;
+
+    /** @ref MeasurementMetaData::averages.*/
+    std::uint32_t averages;
+
+    /** @ref MeasurementMetaData::processing_mode.*/
+    std::int32_t processing_mode;
+  };
+
+  static_assert(sizeof(frame_header_t) == 80, "frame_header_t must not contain padding");
+  static_assert(std::is_trivially_copyable_v<frame_header_t>, "frame_header_t must be trivially copyable");
+
+  inline constexpr std::uint32_t frame_magic = 0x53565543; // "CUVS"
+  inline constexpr std::uint16_t frame_version = 1;
+
+  /** @brief A received frame
+    *
+    * The pixel data is either owned by the frame, or, within @ref shm_subscriber_t::read, located in the shared memory.
+    * */
+  struct frame_t
+  {
+    frame_header_t header;
+
+    /** The wavelengths in nano meter, empty if not available.*/
+    std::vector<std::uint32_t> wavelengths;
+
+    /** @ref MeasurementMetaData::name.*/
+    std::string name;
+
+    /** @ref MeasurementMetaData::product_name.*/
+    std::string product_name;
+
+    /** @ref MeasurementMetaData::serial_number.*/
+    std::string serial_number;
+
+    /** The image key of a cube, or the @ref view_t::_id of a view.*/
+    std::string id;
+
+    /** The pixel data, @ref frame_header_t::payload_bytes long.*/
+    void const* payload = nullptr;
+
+    /** Owner of @ref payload, empty if the data is located in the shared memory.*/
+    std::shared_ptr<void const> owner;
+
+    /** @brief The pixel data as image
+      *
+      * @tparam data_t The pixel type, must match @ref frame_header_t::data_type
+      * @throws std::runtime_error if the data type does not match
+      * */
+    template <typename data_t>
+    common_image_t<data_t> image() const;
+  };
+
+  /** @cond INTERNAL */
+  namespace stream_impl
+  {
+    template <typename data_t>
+    constexpr data_type_t data_type_of()
+    {
+      if constexpr (std::is_same_v<data_t, std::uint8_t>)
+      {
+        return data_type_t::uint8;
+      }
+      else if constexpr (std::is_same_v<data_t, std::uint16_t>)
+      {
+        return data_type_t::uint16;
+      }
+      else if constexpr (std::is_same_v<data_t, std::uint32_t>)
+      {
+        return data_type_t::uint32;
+      }
+      else
+      {
+        static_assert(std::is_same_v<data_t, float>, "unsupported data type");
+        return data_type_t::float32;
+      }
+    }
+
+    constexpr std::size_t align8(std::size_t bytes) { return (bytes + 7) & ~std::size_t(7); }
+
+    /* an encoded frame, the pixel data is referenced, not copied */
+    struct message_t
+    {
+      frame_header_t header;
+      std::vector<std::byte> section;
+      void const* payload;
+      std::shared_ptr<void const> owner;
+
+      std::size_t size() const { return sizeof(frame_header_t) + section.size() + std::size_t(header.payload_bytes); }
+    };
+
+    inline void put_string(std::vector<std::byte>& section, std::string const& value)
+    {
+      std::uint16_t const length = std::uint16_t(std::min<std::size_t>(value.size(), UINT16_MAX));
+      std::size_t const offset = section.size();
+      section.resize(offset + sizeof(length) + length);
+      std::memcpy(section.data() + offset, &length, sizeof(length));
+      std::memcpy(section.data() + offset + sizeof(length), value.data(), length);
+    }
+
+    inline std::string get_string(std::byte const*& pos, std::byte const* end)
+    {
+      std::uint16_t length;
+      if (end - pos < std::ptrdiff_t(sizeof(length)))
+      {
+        throw std::runtime_error("truncated stream frame");
+      }
+      std::memcpy(&length, pos, sizeof(length));
+      pos += sizeof(length);
+      if (end - pos < std::ptrdiff_t(length))
+      {
+        throw std::runtime_error("truncated stream frame");
+      }
+      std::string value(reinterpret_cast<char const*>(pos), length);
+      pos += length;
+      return value;
+    }
+
+    inline void set_meta(frame_header_t& header, MeasurementMetaData const* meta)
+    {
+      if (meta == nullptr)
+      {
+        return;
+      }
+      header.frame_id = std::uint64_t(meta->frame_id);
+      header.capture_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(meta->capture_time.time_since_epoch()).count();
+      header.integration_time = meta->integration_time;
+      header.averages = meta->averages;
+      header.processing_mode = std::int32_t(meta->processing_mode);
+    }
+
+    template <typename data_t>
+    void set_image(message_t& message, common_image_t<data_t> const& image)
+    {
+      message.header.data_type = std::uint8_t(data_type_of<data_t>());
+      message.header.width = std::uint32_t(image._width);
+      message.header.height = std::uint32_t(image._height);
+      message.header.channels = std::uint32_t(image._channels);
+      message.header.payload_bytes = std::uint64_t(image._width * image._height * image._channels * sizeof(data_t));
+      message.payload = image._data;
+    }
+
+    /* fills the section from the wavelengths and strings, and the sizes of the header */
+    inline void finish(message_t& message, std::uint32_t const* wavelengths, MeasurementMetaData const* meta, std::string const& id)
+    {
+      frame_header_t& header = message.header;
+      header.magic = frame_magic;
+      header.version = frame_version;
+      header.wavelength_count = wavelengths != nullptr ? header.channels : 0;
+
+      std::vector<std::byte>& section = message.section;
+      section.resize(std::size_t(header.wavelength_count) * sizeof(std::uint32_t));
+      if (header.wavelength_count > 0)
+      {
+        std::memcpy(section.data(), wavelengths, section.size());
+      }
+      put_string(section, meta != nullptr ? meta->name : std::string());
+      put_string(section, meta != nullptr ? meta->product_name : std::string());
+      put_string(section, meta != nullptr ? meta->serial_number : std::string());
+      put_string(section, id);
+      section.resize(align8(section.size()));
+      header.section_bytes = std::uint32_t(section.size());
+    }
+
+    /* parses the section following the header, the payload is set by the caller */
+    inline void decode_section(frame_t& frame, std::byte const* section)
+    {
+      frame_header_t const& header = frame.header;
+      std::byte const* pos = section;
+      std::byte const* const end = section + header.section_bytes;
+      std::size_t const wavelength_bytes = std::size_t(header.wavelength_count) * sizeof(std::uint32_t);
+      if (wavelength_bytes > header.section_bytes)
+      {
+        throw std::runtime_error("truncated stream frame");
+      }
+      frame.wavelengths.resize(header.wavelength_count);
+      if (wavelength_bytes > 0)
+      {
+        std::memcpy(frame.wavelengths.data(), pos, wavelength_bytes);
+      }
+      pos += wavelength_bytes;
+      frame.name = get_string(pos, end);
+      frame.product_name = get_string(pos, end);
+      frame.serial_number = get_string(pos, end);
+      frame.id = get_string(pos, end);
+    }
+
+    inline void check_header(frame_header_t const& header)
+    {
+      if (header.magic != frame_magic || header.version != frame_version)
+      {
+        throw std::runtime_error("invalid stream frame header");
+      }
+    }
+
+    inline std::uint64_t element_bytes(std::uint8_t data_type)
+    {
+      switch (data_type_t(data_type))
+      {
+        case data_type_t::uint8: return 1;
+        case data_type_t::uint16: return 2;
+        case data_type_t::uint32: return 4;
+        case data_type_t::float32: return 4;
+        default: throw std::runtime_error("invalid stream frame header");
+      }
+    }
+
+    /* checks the sizes of an untrusted header against the bytes available after the header and against each other */
+    inline void check_sizes(frame_header_t const& header, std::uint64_t max_bytes)
+    {
+      if (header.section_bytes > max_bytes || header.payload_bytes > max_bytes - header.section_bytes)
+      {
+        throw std::runtime_error("stream frame exceeds the maximum frame size");
+      }
+      // the payload is the pixel data of the image described by the header
+      std::uint64_t const element = element_bytes(header.data_type);
+      std::uint64_t const pixels = std::uint64_t(header.width) * std::uint64_t(header.height);
+      if (header.channels != 0 && pixels > header.payload_bytes / element / header.channels)
+      {
+        throw std::runtime_error("invalid stream frame header");
+      }
+      if (pixels * header.channels * element != header.payload_bytes)
+      {
+        throw std::runtime_error("invalid stream frame header");
+      }
+    }
+  } // namespace stream_impl
+  /** @endcond */
+
+  /** @brief Publishes cubes and views as frames, the transport is implemented by the subclasses */
+  class publisher_t
+  {
+  public:
+    virtual ~publisher_t() = default;
+
+    /** @brief Publishes the processed cube of a measurement
+      *
+      * @return false, if the measurement has no cube or the frame was dropped by the transport
+      * */
+    bool publish(Measurement const& mesu);
+
+    /** @brief Publishes every image of a view, one frame each
+      *
+      * @param[in] view The view
+      * @param[in] mesu The measurement the view was created from, for the meta data, may be nullptr
+      * @return Number of frames published
+      * */
+    std::size_t publish(Viewer::view_data_t const& view, Measurement const* mesu = nullptr);
+
+    /** @brief Number of frames published */
+    std::uint64_t published() const { return _sequence.load(); }
+
+    /** @brief Number of frames dropped by the transport */
+    std::uint64_t dropped() const { return _dropped.load(); }
+
+  protected:
+    publisher_t() = default;
+
+    /** @brief Sends an encoded frame, returns false if it was dropped */
+    virtual bool send(std::shared_ptr<stream_impl::message_t const> message) = 0;
+
+  private:
+    bool dispatch(stream_impl::message_t&& message);
+
+    std::atomic<std::uint64_t> _sequence{0};
+    std::atomic<std::uint64_t> _dropped{0};
+  };
+
+#if defined(__unix__)
+
+  /** @brief Settings of a @ref shm_publisher_t */
+  struct shm_settings_t
+  {
+    /** Name of the shared memory object, see shm_open.*/
+    std::string name = "/cuvis_stream";
+
+    /** Number of frames in the ring.*/
+    std::size_t slot_count = 8;
+
+    /** Largest frame in bytes, including the header. Larger frames are dropped.*/
+    std::size_t slot_bytes = std::size_t(64) << 20;
+  };
+
+  /** @brief Publishes frames through a ring in shared memory
+    *
+    * The publisher never waits for subscribers: the oldest frame is overwritten when the ring is full. Every slot is
+    * guarded by a sequence lock, so subscribers detect frames overwritten while reading them.
+    * The shared memory object is created by the publisher and removed when it is destroyed.
+    * */
+  class shm_publisher_t : public publisher_t
+  {
+  public:
+    shm_publisher_t(shm_settings_t settings = shm_settings_t());
+    ~shm_publisher_t() override;
+
+    shm_publisher_t(shm_publisher_t const&) = delete;
+    shm_publisher_t& operator=(shm_publisher_t const&) = delete;
+
+  protected:
+    bool send(std::shared_ptr<stream_impl::message_t const> message) override;
+
+  private:
+    shm_settings_t _settings;
+    void* _mapping = nullptr;
+    std::size_t _mapping_bytes = 0;
+    std::mutex _mutex;
+  };
+
+  /** @brief Reads frames published by a @ref shm_publisher_t
+    *
+    * Frames are read in order. If the subscriber falls behind by more than the ring size, the overwritten frames are
+    * skipped and counted by @ref lost.
+    * */
+  class shm_subscriber_t
+  {
+  public:
+    /** @brief Opens the ring, the publisher must exist already
+      *
+      * @param[in] name The name of the shared memory object
+      * @param[in] from_start Start with the oldest frame in the ring, instead of the next published frame
+      * */
+    shm_subscriber_t(std::string const& name = "/cuvis_stream", bool from_start = false);
+    ~shm_subscriber_t();
+
+    shm_subscriber_t(shm_subscriber_t const&) = delete;
+    shm_subscriber_t& operator=(shm_subscriber_t const&) = delete;
+
+    /** @brief Copies the next frame out of the ring
+      *
+      * @param[in] timeout Longest time to wait for a frame
+      * @return The frame, or an empty optional if none was published within the timeout
+      * */
+    std::optional<frame_t> receive(std::chrono::milliseconds timeout);
+
+    /** @brief Calls the function with the next frame, whose pixel data stays in the shared memory
+      *
+      * The publisher may overwrite the frame while the function runs. In that case the frame is counted by @ref lost
+      * and false is returned, and the results of the function must be discarded.
+      *
+      * @param[in] function Called with the frame as `function(frame_t const&)`
+      * @param[in] timeout Longest time to wait for a frame
+      * @return true, if the function was called with a frame which stayed intact
+      * */
+    template <typename function_t>
+    bool read(function_t&& function, std::chrono::milliseconds timeout);
+
+    /** @brief Number of frames skipped because they were overwritten */
+    std::uint64_t lost() const { return _lost; }
+
+  private:
+    /* finds the slot of the next frame, returns its sequence lock value */
+    std::optional<std::uint64_t> next_slot(std::chrono::milliseconds timeout, std::byte const*& slot);
+
+    bool validate(std::byte const* slot, std::uint64_t lock);
+
+    void const* _mapping = nullptr;
+    std::size_t _mapping_bytes = 0;
+    std::uint64_t _next = 0;
+    std::uint64_t _lost = 0;
+  };
+
+  /** @brief Settings of a @ref tcp_publisher_t */
+  struct tcp_settings_t
+  {
+    /** Local address to listen on.*/
+    std::string address = "0.0.0.0";
+
+    /** Port to listen on, 0 selects a free port, see @ref tcp_publisher_t::port.*/
+    std::uint16_t port = 0;
+
+    /** Number of frames queued per subscriber. Frames for a subscriber with a full queue are dropped.*/
+    std::size_t queue_size = 4;
+  };
+
+  /** @brief Publishes frames to every connected @ref tcp_subscriber_t
+    *
+    * Every subscriber is served by its own thread, so a slow subscriber does not delay the others or the publisher.
+    * The pixel data is sent directly from the measurement buffer, which is kept alive while it is queued.
+    * */
+  class tcp_publisher_t : public publisher_t
+  {
+  public:
+    tcp_publisher_t(tcp_settings_t settings = tcp_settings_t());
+    ~tcp_publisher_t() override;
+
+    tcp_publisher_t(tcp_publisher_t const&) = delete;
+    tcp_publisher_t& operator=(tcp_publisher_t const&) = delete;
+
+    /** @brief The port the publisher listens on */
+    std::uint16_t port() const { return _port; }
+
+    /** @brief Number of connected subscribers */
+    std::size_t subscriber_count() const;
+
+  protected:
+    bool send(std::shared_ptr<stream_impl::message_t const> message) override;
+
+  private:
+    struct client_t
+    {
+      int socket;
+      std::deque<std::shared_ptr<stream_impl::message_t const>> queue;
+      bool connected = true;
+      std::thread thread;
+    };
+
+    void accept_clients();
+
+    void serve(client_t& client);
+
+    tcp_settings_t _settings;
+    int _socket = -1;
+    std::uint16_t _port = 0;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _work;
+    std::vector<std::unique_ptr<client_t>> _clients;
+    bool _stop = false;
+
+    std::thread _accept_thread;
+  };
+
+  /** @brief Receives frames from a @ref tcp_publisher_t */
+  class tcp_subscriber_t
+  {
+  public:
+    /** @brief Connects to the publisher
+      *
+      * @param[in] host Host name or address of the publisher
+      * @param[in] port Port of the publisher
+      * @param[in] max_frame_bytes Largest accepted frame without its header, larger frames close the connection
+      * */
+    tcp_subscriber_t(std::string const& host, std::uint16_t port, std::uint64_t max_frame_bytes = default_max_frame_bytes);
+    ~tcp_subscriber_t();
+
+    tcp_subscriber_t(tcp_subscriber_t const&) = delete;
+    tcp_subscriber_t& operator=(tcp_subscriber_t const&) = delete;
+
+    /** @brief Receives the next frame
+      *
+      * @param[in] timeout Longest time to wait for the start of a frame
+      * @return The frame, or an empty optional if none arrived within the timeout
+      * @throws std::runtime_error if the connection is closed, or the frame is invalid or too large. Every failure while reading
+      * a frame closes the connection.
+      * */
+    std::optional<frame_t> receive(std::chrono::milliseconds timeout);
+
+    /** Default of the largest accepted frame, 1 GiB.*/
+    static constexpr std::uint64_t default_max_frame_bytes = std::uint64_t(1) << 30;
+
+  private:
+    void read_exact(void* data, std::size_t bytes);
+
+    int _socket = -1;
+    std::uint64_t _max_frame_bytes;
+  };
+
+#endif
+
+  /** @cond INTERNAL */
+  template <typename data_t>
+  common_image_t<data_t> frame_t::image() const
+  {
+    if (header.data_type != std::uint8_t(stream_impl::data_type_of<data_t>()))
+    {
+      throw std::runtime_error("stream frame has a different data type");
+    }
+    common_image_t<data_t> image;
+    image._width = header.width;
+    image._height = header.height;
+    image._channels = header.channels;
+    image._data = static_cast<data_t const*>(payload);
+    return image;
+  }
+
+  inline bool publisher_t::dispatch(stream_impl::message_t&& message)
+  {
+    message.header.sequence = _sequence.fetch_add(1);
+    if (send(std::make_shared<stream_impl::message_t const>(std::move(message))))
+    {
+      return true;
+    }
+    _dropped++;
+    return false;
+  }
+
+  inline bool publisher_t::publish(Measurement const& mesu)
+  {
+    auto const* cube = mesu.find_image(data_key_t(CUVIS_MESU_CUBE_KEY));
+    if (cube == nullptr)
+    {
+      return false;
+    }
+    MeasurementMetaData const* meta = mesu.get_meta();
+
+    stream_impl::message_t message{};
+    message.header.kind = std::uint16_t(payload_kind_t::cube);
+    stream_impl::set_meta(message.header, meta);
+    std::visit(
+        [&](auto const& image) {
+          stream_impl::set_image(message, image);
+          message.owner = image.get_owner();
+          stream_impl::finish(message, image._wavelength, meta, CUVIS_MESU_CUBE_KEY);
+        },
+        *cube);
+    return dispatch(std::move(message));
+  }
+
+  inline std::size_t publisher_t::publish(Viewer::view_data_t const& view, Measurement const* mesu)
+  {
+    MeasurementMetaData const* meta = mesu != nullptr ? mesu->get_meta() : nullptr;
+    std::size_t count = 0;
+    for (auto const& entry : view)
+    {
+      stream_impl::message_t message{};
+      message.header.kind = std::uint16_t(payload_kind_t::view);
+      stream_impl::set_meta(message.header, meta);
+      std::visit(
+          [&](auto const& image) {
+            stream_impl::set_image(message, image);
+            message.header.view_category = std::uint8_t(image._category);
+            message.header.show = image._show ? 1 : 0;
+            message.owner = image.get_owner();
+            stream_impl::finish(message, nullptr, meta, image._id);
+          },
+          entry.second);
+      count += dispatch(std::move(message)) ? 1 : 0;
+    }
+    return count;
+  }
+
+#if defined(__unix__)
+
+  namespace stream_impl
+  {
+    inline constexpr std::uint32_t ring_magic = 0x52565543; // "CUVR"
+
+    /* start of the shared memory object, followed by the slots */
+    struct ring_header_t
+    {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint64_t slot_count;
+      std::uint64_t slot_stride;
+      std::atomic<std::uint64_t> published;
+    };
+
+    /* start of a slot, followed by the frame; the lock is odd while the frame is written, 2 * (sequence + 1) when done */
+    struct slot_header_t
+    {
+      std::atomic<std::uint64_t> lock;
+      std::uint64_t bytes;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory ring requires lock free 64 bit atomics");
+
+    inline constexpr std::size_t ring_header_bytes = 64;
+    inline constexpr std::size_t slot_header_bytes = 64;
+
+    inline std::system_error system_error(char const* what) { return std::system_error(errno, std::generic_category(), what); }
+
+    inline void send_all(int socket, iovec* iov, int count)
+    {
+      while (count > 0)
+      {
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = std::size_t(count);
+        ssize_t sent = ::sendmsg(socket, &msg, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          throw system_error("sendmsg");
+        }
+        while (count > 0 && std::size_t(sent) >= iov->iov_len)
+        {
+          sent -= ssize_t(iov->iov_len);
+          ++iov;
+          --count;
+        }
+        if (count > 0)
+        {
+          iov->iov_base = static_cast<char*>(iov->iov_base) + sent;
+          iov->iov_len -= std::size_t(sent);
+        }
+      }
+    }
+  } // namespace stream_impl
+
+  inline shm_publisher_t::shm_publisher_t(shm_settings_t settings) : _settings(std::move(settings))
+  {
+    if (_settings.slot_count == 0 || _settings.slot_bytes < sizeof(frame_header_t))
+    {
+      throw std::invalid_argument("shared memory ring requires at least one slot for a frame header");
+    }
+    std::size_t const stride = stream_impl::slot_header_bytes + stream_impl::align8(_settings.slot_bytes);
+    _mapping_bytes = stream_impl::ring_header_bytes + stride * _settings.slot_count;
+
+    int const fd = ::shm_open(_settings.name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+      throw stream_impl::system_error("shm_open");
+    }
+    if (::ftruncate(fd, off_t(_mapping_bytes)) != 0)
+    {
+      auto error = stream_impl::system_error("ftruncate");
+      ::close(fd);
+      ::shm_unlink(_settings.name.c_str());
+      throw error;
+    }
+    _mapping = ::mmap(nullptr, _mapping_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (_mapping == MAP_FAILED)
+    {
+      _mapping = nullptr;
+      auto error = stream_impl::system_error("mmap");
+      ::shm_unlink(_settings.name.c_str());
+      throw error;
+    }
+
+    auto* ring = new (_mapping) stream_impl::ring_header_t{stream_impl::ring_magic, frame_version, _settings.slot_count, stride, {}};
+    for (std::size_t k = 0; k < _settings.slot_count; k++)
+    {
+      new (static_cast<std::byte*>(_mapping) + stream_impl::ring_header_bytes + k * stride) stream_impl::slot_header_t{{}, 0};
+    }
+    ring->published.store(0, std::memory_order_release);
+  }
+
+  inline shm_publisher_t::~shm_publisher_t()
+  {
+    ::munmap(_mapping, _mapping_bytes);
+    ::shm_unlink(_settings.name.c_str());
+  }
+
+  inline bool shm_publisher_t::send(std::shared_ptr<stream_impl::message_t const> message)
+  {
+    if (message->size() > _settings.slot_bytes)
+    {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto* ring = static_cast<stream_impl::ring_header_t*>(_mapping);
+    std::uint64_t const sequence = ring->published.load(std::memory_order_relaxed);
+    std::byte* const slot = static_cast<std::byte*>(_mapping) + stream_impl::ring_header_bytes + (sequence % ring->slot_count) * ring->slot_stride;
+    auto* slot_header = reinterpret_cast<stream_impl::slot_header_t*>(slot);
+
+    slot_header->lock.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // the frame keeps the sequence of the publisher, frames dropped before the ring do not occupy a slot
+    std::byte* data = slot + stream_impl::slot_header_bytes;
+    frame_header_t const& header = message->header;
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + sizeof(header), message->section.data(), message->section.size());
+    std::memcpy(data + sizeof(header) + message->section.size(), message->payload, std::size_t(header.payload_bytes));
+    slot_header->bytes = message->size();
+
+    slot_header->lock.store(2 * sequence + 2, std::memory_order_release);
+    ring->published.store(sequence + 1, std::memory_order_release);
+    return true;
+  }
+
+  inline shm_subscriber_t::shm_subscriber_t(std::string const& name, bool from_start)
+  {
+    int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+      throw stream_impl::system_error("shm_open");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || std::size_t(info.st_size) < stream_impl::ring_header_bytes)
+    {
+      ::close(fd);
+      throw std::runtime_error("shared memory object is not a frame ring");
+    }
+    _mapping_bytes = std::size_t(info.st_size);
+    void* mapping = ::mmap(nullptr, _mapping_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+      throw stream_impl::system_error("mmap");
+    }
+    _mapping = mapping;
+
+    auto const* ring = static_cast<stream_impl::ring_header_t const*>(_mapping);
+    // the slots, each large enough for a frame header, must fit the mapping, checked without overflow
+    if (ring->magic != stream_impl::ring_magic || ring->version != frame_version || ring->slot_count == 0 ||
+        ring->slot_stride < stream_impl::slot_header_bytes + sizeof(frame_header_t) ||
+        ring->slot_count > (_mapping_bytes - stream_impl::ring_header_bytes) / ring->slot_stride)
+    {
+      ::munmap(const_cast<void*>(_mapping), _mapping_bytes);
+      throw std::runtime_error("shared memory object is not a frame ring");
+    }
+    std::uint64_t const published = ring->published.load(std::memory_order_acquire);
+    _next = from_start && published > ring->slot_count ? published - ring->slot_count : (from_start ? 0 : published);
+  }
+
+  inline shm_subscriber_t::~shm_subscriber_t() { ::munmap(const_cast<void*>(_mapping), _mapping_bytes); }
+
+  inline std::optional<std::uint64_t> shm_subscriber_t::next_slot(std::chrono::milliseconds timeout, std::byte const*& slot)
+  {
+    auto const* ring = static_cast<stream_impl::ring_header_t const*>(_mapping);
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+      std::uint64_t const published = ring->published.load(std::memory_order_acquire);
+      if (_next < published)
+      {
+        if (published - _next > ring->slot_count)
+        {
+          _lost += published - _next - ring->slot_count;
+          _next = published - ring->slot_count;
+        }
+        slot = static_cast<std::byte const*>(_mapping) + stream_impl::ring_header_bytes + (_next % ring->slot_count) * ring->slot_stride;
+        std::uint64_t const lock = reinterpret_cast<stream_impl::slot_header_t const*>(slot)->lock.load(std::memory_order_acquire);
+        if (lock == 2 * _next + 2)
+        {
+          return lock;
+        }
+        // overwritten by a newer frame meanwhile
+        _lost++;
+        _next++;
+        continue;
+      }
+      if (std::chrono::steady_clock::now() >= deadline)
+      {
+        return std::nullopt;
+      }
+      // the publisher does not signal new frames, poll the ring
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  inline bool shm_subscriber_t::validate(std::byte const* slot, std::uint64_t lock)
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    _next++;
+    if (reinterpret_cast<stream_impl::slot_header_t const*>(slot)->lock.load(std::memory_order_relaxed) != lock)
+    {
+      _lost++;
+      return false;
+    }
+    return true;
+  }
+
+  template <typename function_t>
+  bool shm_subscriber_t::read(function_t&& function, std::chrono::milliseconds timeout)
+  {
+    std::byte const* slot = nullptr;
+    auto const lock = next_slot(timeout, slot);
+    if (!lock.has_value())
+    {
+      return false;
+    }
+
+    std::byte const* const data = slot + stream_impl::slot_header_bytes;
+    std::size_t const capacity = static_cast<stream_impl::ring_header_t const*>(_mapping)->slot_stride - stream_impl::slot_header_bytes;
+    frame_t frame;
+    try
+    {
+      std::memcpy(&frame.header, data, sizeof(frame.header));
+      stream_impl::check_header(frame.header);
+      stream_impl::check_sizes(frame.header, capacity - sizeof(frame.header));
+      stream_impl::decode_section(frame, data + sizeof(frame.header));
+    }
+    catch (std::runtime_error const&)
+    {
+      // a torn frame, unless the slot is still intact
+      if (validate(slot, *lock))
+      {
+        throw;
+      }
+      return false;
+    }
+    frame.payload = data + sizeof(frame.header) + frame.header.section_bytes;
+    function(static_cast<frame_t const&>(frame));
+    return validate(slot, *lock);
+  }
+
+  inline std::optional<frame_t> shm_subscriber_t::receive(std::chrono::milliseconds timeout)
+  {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+      std::optional<frame_t> result;
+      bool const valid = read(
+          [&result](frame_t const& frame) {
+            std::size_t const bytes = std::size_t(frame.header.payload_bytes);
+            std::shared_ptr<std::byte> copy(new std::byte[std::max<std::size_t>(bytes, 1)], std::default_delete<std::byte[]>());
+            std::memcpy(copy.get(), frame.payload, bytes);
+            result = frame;
+            result->payload = copy.get();
+            result->owner = std::move(copy);
+          },
+          std::max(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()), std::chrono::milliseconds(0)));
+      if (valid)
+      {
+        return result;
+      }
+      if (std::chrono::steady_clock::now() >= deadline)
+      {
+        return std::nullopt;
+      }
+    }
+  }
+
+  inline tcp_publisher_t::tcp_publisher_t(tcp_settings_t settings) : _settings(std::move(settings))
+  {
+    _settings.queue_size = std::max<std::size_t>(_settings.queue_size, 1);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_settings.port);
+    if (::inet_pton(AF_INET, _settings.address.c_str(), &address.sin_addr) != 1)
+    {
+      throw std::invalid_argument("invalid listen address");
+    }
+
+    _socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (_socket < 0)
+    {
+      throw stream_impl::system_error("socket");
+    }
+    int const enable = 1;
+    ::setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (::bind(_socket, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0)
+    {
+      auto error = stream_impl::system_error("bind");
+      ::close(_socket);
+      throw error;
+    }
+    if (::listen(_socket, 8) != 0)
+    {
+      auto error = stream_impl::system_error("listen");
+      ::close(_socket);
+      throw error;
+    }
+    socklen_t length = sizeof(address);
+    ::getsockname(_socket, reinterpret_cast<sockaddr*>(&address), &length);
+    _port = ntohs(address.sin_port);
+
+    _accept_thread = std::thread(&tcp_publisher_t::accept_clients, this);
+  }
+
+  inline tcp_publisher_t::~tcp_publisher_t()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+      for (auto& client : _clients)
+      {
+        ::shutdown(client->socket, SHUT_RDWR);
+      }
+    }
+    _work.notify_all();
+    _accept_thread.join();
+    for (auto& client : _clients)
+    {
+      client->thread.join();
+      ::close(client->socket);
+    }
+    ::close(_socket);
+  }
+
+  inline std::size_t tcp_publisher_t::subscriber_count() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::size_t(std::count_if(_clients.begin(), _clients.end(), [](std::unique_ptr<client_t> const& client) { return client->connected; }));
+  }
+
+  inline void tcp_publisher_t::accept_clients()
+  {
+    while (true)
+    {
+      pollfd listen_fd{_socket, POLLIN, 0};
+      int const ready = ::poll(&listen_fd, 1, 50);
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop)
+        {
+          return;
+        }
+        // release the subscribers which disconnected
+        auto const end = std::remove_if(_clients.begin(), _clients.end(), [](std::unique_ptr<client_t>& client) {
+          if (client->connected)
+          {
+            return false;
+          }
+          client->thread.join();
+          ::close(client->socket);
+          return true;
+        });
+        _clients.erase(end, _clients.end());
+      }
+      if (ready <= 0)
+      {
+        continue;
+      }
+
+      int const socket = ::accept(_socket, nullptr, nullptr);
+      if (socket < 0)
+      {
+        continue;
+      }
+      int const enable = 1;
+      ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _clients.push_back(std::make_unique<client_t>());
+      client_t& client = *_clients.back();
+      client.socket = socket;
+      client.thread = std::thread(&tcp_publisher_t::serve, this, std::ref(client));
+    }
+  }
+
+  inline void tcp_publisher_t::serve(client_t& client)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+      _work.wait(lock, [&] { return _stop || !client.queue.empty(); });
+      if (_stop)
+      {
+        break;
+      }
+      auto message = std::move(client.queue.front());
+      client.queue.pop_front();
+      lock.unlock();
+
+      iovec iov[3];
+      iov[0] = iovec{const_cast<frame_header_t*>(&message->header), sizeof(frame_header_t)};
+      iov[1] = iovec{const_cast<std::byte*>(message->section.data()), message->section.size()};
+      iov[2] = iovec{const_cast<void*>(message->payload), std::size_t(message->header.payload_bytes)};
+      bool failed = false;
+      try
+      {
+        stream_impl::send_all(client.socket, iov, 3);
+      }
+      catch (std::system_error const&)
+      {
+        failed = true;
+      }
+      message.reset();
+
+      lock.lock();
+      if (failed)
+      {
+        break;
+      }
+    }
+    client.connected = false;
+    client.queue.clear();
+  }
+
+  inline bool tcp_publisher_t::send(std::shared_ptr<stream_impl::message_t const> message)
+  {
+    bool delivered = false;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (auto& client : _clients)
+      {
+        if (client->connected && client->queue.size() < _settings.queue_size)
+        {
+          client->queue.push_back(message);
+          delivered = true;
+        }
+      }
+    }
+    _work.notify_all();
+    return delivered;
+  }
+
+  inline tcp_subscriber_t::tcp_subscriber_t(std::string const& host, std::uint16_t port, std::uint64_t max_frame_bytes) : _max_frame_bytes(max_frame_bytes)
+  {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+    {
+      throw std::runtime_error("cannot resolve host " + host);
+    }
+    for (addrinfo* address = addresses; address != nullptr; address = address->ai_next)
+    {
+      _socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+      if (_socket < 0)
+      {
+        continue;
+      }
+      if (::connect(_socket, address->ai_addr, address->ai_addrlen) == 0)
+      {
+        break;
+      }
+      ::close(_socket);
+      _socket = -1;
+    }
+    ::freeaddrinfo(addresses);
+    if (_socket < 0)
+    {
+      throw std::runtime_error("cannot connect to " + host + ":" + std::to_string(port));
+    }
+  }
+
+  inline tcp_subscriber_t::~tcp_subscriber_t()
+  {
+    if (_socket >= 0)
+    {
+      ::close(_socket);
+    }
+  }
+
+  inline void tcp_subscriber_t::read_exact(void* data, std::size_t bytes)
+  {
+    auto* pos = static_cast<char*>(data);
+    while (bytes > 0)
+    {
+      ssize_t const received = ::recv(_socket, pos, bytes, 0);
+      if (received < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (received < 0)
+      {
+        throw stream_impl::system_error("recv");
+      }
+      if (received == 0)
+      {
+        throw std::runtime_error("stream publisher closed the connection");
+      }
+      pos += received;
+      bytes -= std::size_t(received);
+    }
+  }
+
+  inline std::optional<frame_t> tcp_subscriber_t::receive(std::chrono::milliseconds timeout)
+  {
+    if (_socket < 0)
+    {
+      throw std::runtime_error("stream connection is closed");
+    }
+
+    pollfd fd{_socket, POLLIN, 0};
+    int const ready = ::poll(&fd, 1, int(timeout.count()));
+    if (ready < 0 && errno != EINTR)
+    {
+      throw stream_impl::system_error("poll");
+    }
+    if (ready <= 0)
+    {
+      return std::nullopt;
+    }
+
+    frame_t frame;
+    try
+    {
+      read_exact(&frame.header, sizeof(frame.header));
+      stream_impl::check_header(frame.header);
+      stream_impl::check_sizes(frame.header, _max_frame_bytes);
+
+      std::vector<std::byte> section(frame.header.section_bytes);
+      read_exact(section.data(), section.size());
+      stream_impl::decode_section(frame, section.data());
+
+      std::size_t const bytes = std::size_t(frame.header.payload_bytes);
+      std::shared_ptr<std::byte> payload(new std::byte[std::max<std::size_t>(bytes, 1)], std::default_delete<std::byte[]>());
+      read_exact(payload.get(), bytes);
+      frame.payload = payload.get();
+      frame.owner = std::move(payload);
+    }
+    catch (...)
+    {
+      // the stream cannot be resynchronized after a partially read frame
+      ::close(_socket);
+      _socket = -1;
+      throw;
+    }
+    return frame;
+  }
+
+#endif
+  /** @endcond */
+
+} // namespace cuvis::aux::stream
@@ -0,0 +1,371 @@
+#pragma once
+
+/** @file cuvis_worker_control.hpp
+  *
+  *
+  * @details Adaptive switching of the supplementary worker steps depending on the worker load.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <cuvis.hpp>
+
+/**
+  * @brief Control of a @ref cuvis::Worker depending on its load.
+  * */
+namespace cuvis::aux::control
+{
+  /** @brief A sample of the worker load */
+  struct worker_load_t
+  {
+    /** The worker state at the time of the sample.*/
+    Worker::worker_state_t state;
+
+    /** Fill level of the input queue in [0, 1].*/
+    double input_fill;
+
+    /** Fill level of the output queue in [0, 1].*/
+    double output_fill;
+
+    /** Number of busy worker threads.*/
+    std::int32_t threads_busy;
+
+    /** Smoothed latency reported by @ref worker_controller_t::record_latency, if any.*/
+    std::optional<std::chrono::nanoseconds> latency;
+  };
+
+  /** @brief Reason of a decision */
+  enum class decision_reason_t
+  {
+    /** A queue is filled above the high watermark.*/
+    queue_high,
+
+    /** The latency is above the target latency.*/
+    latency_high,
+
+    /** The queues and the latency are back below the low limits.*/
+    recovered,
+
+    /** The controller was stopped and re-enabled the supplementary steps.*/
+    stopped
+  };
+
+  /** @brief A change of the supplementary steps */
+  struct decision_t
+  {
+    /** Whether the supplementary steps (viewer and exporter) are enabled after the decision.*/
+    bool supplementary_enabled;
+
+    decision_reason_t reason;
+
+    /** The load which led to the decision.*/
+    worker_load_t load;
+
+    std::chrono::steady_clock::time_point time;
+  };
+
+  /** @brief Policy of the @ref worker_controller_t
+    *
+    * The supplementary steps are switched off when a queue is filled to @ref high_watermark or above,
+    * or the latency exceeds @ref target_latency. They are switched on again, when all queues are at
+    * @ref low_watermark or below and the latency is below @ref recover_latency_fraction times the target.
+    * Two decisions are at least @ref min_dwell apart.
+    * */
+  struct controller_settings_t
+  {
+    /** Queue fill level which switches the supplementary steps off.*/
+    double high_watermark = 0.75;
+
+    /** Queue fill level which switches the supplementary steps on again, must be below @ref high_watermark.*/
+    double low_watermark = 0.25;
+
+    /** Latency which switches the supplementary steps off, requires @ref worker_controller_t::record_latency.*/
+    std::optional<std::chrono::nanoseconds> target_latency;
+
+    /** Fraction of @ref target_latency below which the supplementary steps are switched on again.*/
+    double recover_latency_fraction = 0.5;
+
+    /** Smoothing factor for the recorded latencies in (0, 1].*/
+    double latency_alpha = 0.1;
+
+    /** Least number of busy worker threads required to switch off. A full queue with idle threads is not
+      * caused by the supplementary steps.*/
+    std::int32_t min_threads_busy = 1;
+
+    /** Least time between two decisions.*/
+    std::chrono::milliseconds min_dwell = std::chrono::milliseconds(1000);
+
+    /** Time between two samples of the controller thread.*/
+    std::chrono::milliseconds sample_interval = std::chrono::milliseconds(50);
+
+    /** The viewer to set while the supplementary steps are enabled, may be nullptr. Must outlive the controller.*/
+    Viewer const* viewer = nullptr;
+
+    /** The exporter to set while the supplementary steps are enabled, may be nullptr. Must outlive the controller.*/
+    Exporter const* exporter = nullptr;
+
+    /** Called for every decision, from the thread taking it.*/
+    std::function<void(decision_t const&)> decision_callback;
+  };
+
+  /** @cond INTERNAL */
+  namespace control_impl
+  {
+    inline double fill(std::size_t used, std::size_t limit) { return limit > 0 ? std::min(double(used) / double(limit), 1.0) : 0.0; }
+
+    /* returns the new state and the reason, if the state changes */
+    inline std::optional<std::pair<bool, decision_reason_t>>
+        decide(controller_settings_t const& settings, bool enabled, worker_load_t const& load, std::chrono::steady_clock::duration since_last)
+    {
+      if (since_last < settings.min_dwell)
+      {
+        return std::nullopt;
+      }
+
+      double const pressure = std::max(load.input_fill, load.output_fill);
+      bool const has_target = settings.target_latency.has_value() && load.latency.has_value();
+
+      if (enabled)
+      {
+        if (load.threads_busy < settings.min_threads_busy)
+        {
+          return std::nullopt;
+        }
+        if (pressure >= settings.high_watermark)
+        {
+          return std::make_pair(false, decision_reason_t::queue_high);
+        }
+        if (has_target && *load.latency > *settings.target_latency)
+        {
+          return std::make_pair(false, decision_reason_t::latency_high);
+        }
+        return std::nullopt;
+      }
+
+      if (pressure > settings.low_watermark)
+      {
+        return std::nullopt;
+      }
+      if (has_target && double(load.latency->count()) >= settings.recover_latency_fraction * double(settings.target_latency->count()))
+      {
+        return std::nullopt;
+      }
+      return std::make_pair(true, decision_reason_t::recovered);
+    }
+  } // namespace control_impl
+  /** @endcond */
+
+  /** @brief Switches the supplementary steps of a worker off and on depending on its load
+    *
+    * The supplementary steps are the viewer and the exporter of the worker. The controller sets them to nullptr
+    * while the worker falls behind, and back to @ref controller_settings_t::viewer and @ref controller_settings_t::exporter
+    * when it caught up.
+    * The load is sampled either by calling @ref step, or periodically by the thread started with @ref start.
+    * */
+  class worker_controller_t
+  {
+  public:
+    /** @brief Creates the controller, the supplementary steps are assumed to be enabled
+      *
+      * @param[in] worker The worker to control, must outlive the controller
+      * @param[in] settings The policy
+      * */
+    worker_controller_t(Worker& worker, controller_settings_t settings);
+
+    /** @brief Calls @ref stop */
+    ~worker_controller_t();
+
+    worker_controller_t(worker_controller_t const&) = delete;
+    worker_controller_t& operator=(worker_controller_t const&) = delete;
+
+    /** @brief Starts sampling every @ref controller_settings_t::sample_interval in a separate thread */
+    void start();
+
+    /** @brief Stops the sampling thread and enables the supplementary steps again */
+    void stop();
+
+    /** @brief Samples the load once and applies the policy
+      *
+      * @return The decision, if the state changed
+      * */
+    std::optional<decision_t> step();
+
+    /** @brief Samples the worker load without taking a decision */
+    worker_load_t sample() const;
+
+    /** @brief Records the latency of a result, e.g. from capture to the worker callback
+      *
+      * Thread-safe, may be called from worker callbacks.
+      * */
+    void record_latency(std::chrono::nanoseconds latency);
+
+    /** @brief Whether the supplementary steps are currently enabled */
+    bool supplementary_enabled() const;
+
+  private:
+    void apply(bool enabled);
+
+    Worker& _worker;
+    controller_settings_t _settings;
+
+    mutable std::mutex _mutex;
+    bool _enabled = true;
+    std::chrono::steady_clock::time_point _last_decision;
+    std::optional<double> _latency;
+
+    std::mutex _thread_mutex;
+    std::condition_variable _wake;
+    bool _run = false;
+    std::thread _thread;
+  };
+
+  /** @cond INTERNAL */
+  inline worker_controller_t::worker_controller_t(Worker& worker, controller_settings_t settings) : _worker(worker), _settings(std::move(settings))
+  {
+    if (!(_settings.low_watermark < _settings.high_watermark))
+    {
+      throw std::invalid_argument("low watermark must be below high watermark");
+    }
+    if (!(_settings.latency_alpha > 0.0 && _settings.latency_alpha <= 1.0))
+    {
+      throw std::invalid_argument("latency alpha must be within (0, 1]");
+    }
+    if (_settings.sample_interval.count() <= 0)
+    {
+      throw std::invalid_argument("sample interval must be positive");
+    }
+    _last_decision = std::chrono::steady_clock::now() - _settings.min_dwell;
+  }
+
+  inline worker_controller_t::~worker_controller_t() { stop(); }
+
+  inline void worker_controller_t::start()
+  {
+    std::lock_guard<std::mutex> lock(_thread_mutex);
+    if (_run)
+    {
+      return;
+    }
+    _run = true;
+    _thread = std::thread([this] {
+      std::unique_lock<std::mutex> thread_lock(_thread_mutex);
+      while (_run)
+      {
+        thread_lock.unlock();
+        step();
+        thread_lock.lock();
+        _wake.wait_for(thread_lock, _settings.sample_interval, [this] { return !_run; });
+      }
+    });
+  }
+
+  inline void worker_controller_t::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_thread_mutex);
+      _run = false;
+    }
+    _wake.notify_all();
+    if (_thread.joinable())
+    {
+      _thread.join();
+    }
+
+    if (supplementary_enabled())
+    {
+      return;
+    }
+    worker_load_t const load = sample();
+    decision_t const decision{true, decision_reason_t::stopped, load, std::chrono::steady_clock::now()};
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      apply(true);
+      _enabled = true;
+      _last_decision = decision.time;
+    }
+    if (_settings.decision_callback)
+    {
+      _settings.decision_callback(decision);
+    }
+  }
+
+  inline worker_load_t worker_controller_t::sample() const
+  {
+    worker_load_t load;
+    load.state = _worker.get_state();
+    load.input_fill = control_impl::fill(load.state.measurementsInQueue, _worker.get_input_queue_limit());
+    load.output_fill = control_impl::fill(load.state.resultsInQueue, _worker.get_output_queue_limit());
+    load.threads_busy = _worker.get_threads_busy();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_latency.has_value())
+      {
+        load.latency = std::chrono::nanoseconds(std::chrono::nanoseconds::rep(*_latency));
+      }
+    }
+    return load;
+  }
+
+  inline std::optional<decision_t> worker_controller_t::step()
+  {
+    worker_load_t const load = sample();
+    auto const now = std::chrono::steady_clock::now();
+
+    std::optional<decision_t> decision;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto const change = control_impl::decide(_settings, _enabled, load, now - _last_decision);
+      if (!change.has_value())
+      {
+        return std::nullopt;
+      }
+      apply(change->first);
+      _enabled = change->first;
+      _last_decision = now;
+      decision = decision_t{change->first, change->second, load, now};
+    }
+    if (_settings.decision_callback)
+    {
+      _settings.decision_callback(*decision);
+    }
+    return decision;
+  }
+
+  inline void worker_controller_t::record_latency(std::chrono::nanoseconds latency)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    double const value = double(latency.count());
+    _latency = _latency.has_value() ? *_latency + _settings.latency_alpha * (value - *_latency) : value;
+  }
+
+  inline bool worker_controller_t::supplementary_enabled() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _enabled;
+  }
+
+  inline void worker_controller_t::apply(bool enabled)
+  {
+    if (_settings.viewer != nullptr)
+    {
+      _worker.set_viewer(enabled ? _settings.viewer : nullptr);
+    }
+    if (_settings.exporter != nullptr)
+    {
+      _worker.set_exporter(enabled ? _settings.exporter : nullptr);
+    }
+  }
+  /** @endcond */
+
+} // namespace cuvis::aux::control
@@ -0,0 +1,4 @@
+#include <cuvis_calibration_registry.hpp>
+
+namespace cuvis::aux
+{}
@@ -0,0 +1,4 @@
+#include <cuvis_device.hpp>
+
+namespace cuvis::aux
+{}
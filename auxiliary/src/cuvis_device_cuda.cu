@@ -0,0 +1,4 @@
+#include <cuvis_device_cuda.cuh>
+
+namespace cuvis::aux
+{}
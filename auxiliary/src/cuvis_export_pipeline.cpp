@@ -0,0 +1,4 @@
+#include <cuvis_export_pipeline.hpp>
+
+namespace cuvis::aux
+{}
@@ -0,0 +1,4 @@
+#include <cuvis_fanout_exporter.hpp>
+
+namespace cuvis::aux
+{}
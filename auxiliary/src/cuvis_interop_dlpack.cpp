@@ -0,0 +1,4 @@
+#include <cuvis_interop_dlpack.hpp>
+
+namespace cuvis::aux
+{}
\ No newline at end of file
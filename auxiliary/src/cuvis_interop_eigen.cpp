@@ -0,0 +1,4 @@
+#include <cuvis_interop_eigen.hpp>
+
+namespace cuvis::aux
+{}
\ No newline at end of file
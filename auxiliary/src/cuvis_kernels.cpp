@@ -0,0 +1,4 @@
+#include <cuvis_kernels.hpp>
+
+namespace cuvis::aux
+{}
\ No newline at end of file
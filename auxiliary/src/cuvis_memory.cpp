@@ -0,0 +1,4 @@
+#include <cuvis_memory.hpp>
+
+namespace cuvis::aux
+{}
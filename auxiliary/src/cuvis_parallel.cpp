@@ -0,0 +1,4 @@
+#include <cuvis_parallel.hpp>
+
+namespace cuvis::aux
+{}
\ No newline at end of file
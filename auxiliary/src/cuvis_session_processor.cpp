@@ -0,0 +1,4 @@
+#include <cuvis_session_processor.hpp>
+
+namespace cuvis::aux
+{}
@@ -0,0 +1,4 @@
+#include <cuvis_stream.hpp>
+
+namespace cuvis::aux
+{}
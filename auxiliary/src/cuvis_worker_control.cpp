@@ -0,0 +1,4 @@
+#include <cuvis_worker_control.hpp>
+
+namespace cuvis::aux
+{}
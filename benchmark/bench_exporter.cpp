@@ -0,0 +1,83 @@
+#include "cuvis_benchmark.hpp"
+
+#include <functional>
+#include <system_error>
+
+namespace cuvis::bench
+{
+  /* exports the processed frame once per iteration, flushing so the write is included */
+  static void run_exporter(benchmark::State& state, std::string const& name, std::function<std::unique_ptr<Exporter>(std::filesystem::path const&)> const& create)
+  {
+    if (!require_session(state))
+    {
+      return;
+    }
+    std::filesystem::path const dir = environment().export_dir / name;
+    std::filesystem::create_directories(dir);
+
+    ProcessingContext context(*environment().session);
+    Measurement mesu(*environment().frame);
+    context.apply(mesu);
+
+    {
+      auto exporter = create(dir);
+      for (auto _ : state)
+      {
+        exporter->apply(mesu);
+        exporter->flush();
+      }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * std::int64_t(image_bytes(mesu)));
+
+    std::error_code ignored;
+    std::filesystem::remove_all(dir, ignored);
+  }
+
+  static void BM_CubeExporter(benchmark::State& state)
+  {
+    run_exporter(state, "cube", [](std::filesystem::path const& dir) {
+      SaveArgs args;
+      args.export_dir = dir;
+      args.allow_overwrite = true;
+      return std::make_unique<CubeExporter>(args);
+    });
+  }
+  BENCHMARK(BM_CubeExporter)->Unit(benchmark::kMillisecond);
+
+  static void BM_TiffExporter(benchmark::State& state)
+  {
+    run_exporter(state, "tiff", [](std::filesystem::path const& dir) {
+      TiffArgs args;
+      args.export_dir = dir;
+      return std::make_unique<TiffExporter>(args);
+    });
+  }
+  BENCHMARK(BM_TiffExporter)->Unit(benchmark::kMillisecond);
+
+  static void BM_EnviExporter(benchmark::State& state)
+  {
+    run_exporter(state, "envi", [](std::filesystem::path const& dir) {
+      EnviArgs args;
+      args.export_dir = dir;
+      return std::make_unique<EnviExporter>(args);
+    });
+  }
+  BENCHMARK(BM_EnviExporter)->Unit(benchmark::kMillisecond);
+
+  static void BM_ViewExporter(benchmark::State& state)
+  {
+    if (!require_userplugin(state))
+    {
+      return;
+    }
+    run_exporter(state, "view", [](std::filesystem::path const& dir) {
+      ViewArgs args;
+      args.export_dir = dir;
+      args.userplugin = environment().userplugin;
+      return std::make_unique<ViewExporter>(args);
+    });
+  }
+  BENCHMARK(BM_ViewExporter)->Unit(benchmark::kMillisecond);
+
+} // namespace cuvis::bench
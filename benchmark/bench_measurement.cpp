@@ -0,0 +1,61 @@
+#include "cuvis_benchmark.hpp"
+
+namespace cuvis::bench
+{
+  /* loads a frame from the session, including the measurement handle */
+  static void BM_Measurement_load(benchmark::State& state)
+  {
+    if (!require_session(state))
+    {
+      return;
+    }
+    SessionFile const& session = *environment().session;
+    int_t const frames = session.get_size();
+    int_t frame = 0;
+    for (auto _ : state)
+    {
+      auto mesu = session.get_mesu(frame);
+      benchmark::DoNotOptimize(mesu);
+      frame = (frame + 1) % frames;
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_Measurement_load);
+
+  /* deep copy of the measurement handle and its data */
+  static void BM_Measurement_copy(benchmark::State& state)
+  {
+    if (!require_session(state))
+    {
+      return;
+    }
+    Measurement const& frame = *environment().frame;
+    for (auto _ : state)
+    {
+      Measurement copy(frame);
+      benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * std::int64_t(image_bytes(frame)));
+  }
+  BENCHMARK(BM_Measurement_copy);
+
+  /* refresh and fetch of the metadata and the image table, as after processing */
+  static void BM_Measurement_refresh(benchmark::State& state)
+  {
+    if (!require_session(state))
+    {
+      return;
+    }
+    Measurement mesu(*environment().frame);
+    for (auto _ : state)
+    {
+      mesu.refresh();
+      benchmark::DoNotOptimize(mesu.get_meta());
+      benchmark::DoNotOptimize(mesu.get_image_table());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_Measurement_refresh);
+
+} // namespace cuvis::bench
@@ -0,0 +1,63 @@
+#include "cuvis_benchmark.hpp"
+
+namespace cuvis::bench
+{
+  /* processing of a frame, the argument selects the processing mode */
+  static void BM_ProcessingContext_apply(benchmark::State& state)
+  {
+    processing_mode_t const mode = processing_mode_t(state.range(0));
+    state.SetLabel(processing_mode_name(mode));
+    if (!require_session(state))
+    {
+      return;
+    }
+    ProcessingContext context(*environment().session);
+    ProcessingArgs args;
+    args.processing_mode = mode;
+    Measurement mesu(*environment().frame);
+    if (!context.is_capable(mesu, args))
+    {
+      state.SkipWithError("the session lacks the references of the processing mode");
+      return;
+    }
+    context.set_processingArgs(args);
+
+    for (auto _ : state)
+    {
+      context.apply(mesu);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * std::int64_t(image_bytes(mesu)));
+  }
+  BENCHMARK(BM_ProcessingContext_apply)
+      ->Arg(processing_mode_t::Preview)
+      ->Arg(processing_mode_t::Cube_Raw)
+      ->Arg(processing_mode_t::Cube_DarkSubtract)
+      ->Arg(processing_mode_t::Cube_Reflectance)
+      ->Arg(processing_mode_t::Cube_SpectralRadiance)
+      ->Unit(benchmark::kMillisecond);
+
+  /* the view of a processed frame, as defined by the user plugin */
+  static void BM_Viewer_apply(benchmark::State& state)
+  {
+    if (!require_userplugin(state))
+    {
+      return;
+    }
+    ProcessingContext context(*environment().session);
+    Measurement mesu(*environment().frame);
+    context.apply(mesu);
+
+    ViewArgs args;
+    args.userplugin = environment().userplugin;
+    Viewer viewer(args);
+    for (auto _ : state)
+    {
+      auto view = viewer.apply(mesu);
+      benchmark::DoNotOptimize(view);
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_Viewer_apply)->Unit(benchmark::kMillisecond);
+
+} // namespace cuvis::bench
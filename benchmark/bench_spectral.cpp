@@ -0,0 +1,132 @@
+#include "cuvis_benchmark.hpp"
+
+#include <cuvis_spectral.hpp>
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace cuvis::bench
+{
+  /* a random uint16 cube, no SDK required */
+  struct synthetic_cube_t
+  {
+    synthetic_cube_t(std::size_t width, std::size_t height, std::size_t channels) : data(width * height * channels), wavelength(channels)
+    {
+      std::mt19937 random(42);
+      std::uniform_int_distribution<unsigned> value(0, 4095);
+      for (auto& element : data)
+      {
+        element = std::uint16_t(value(random));
+      }
+      for (std::size_t channel = 0; channel < channels; channel++)
+      {
+        wavelength[channel] = std::uint32_t(450 + 4 * channel);
+      }
+      image._width = width;
+      image._height = height;
+      image._channels = channels;
+      image._data = data.data();
+      image._wavelength = wavelength.data();
+    }
+
+    std::vector<std::uint16_t> data;
+    std::vector<std::uint32_t> wavelength;
+    image_t<std::uint16_t> image{};
+  };
+
+  /* the size of an Ultris cube */
+  static synthetic_cube_t const& cube()
+  {
+    static synthetic_cube_t const cube(410, 410, 164);
+    return cube;
+  }
+
+  static std::vector<aux::spectral::polygon_t> const& polygons()
+  {
+    static std::vector<aux::spectral::polygon_t> const polys = {
+        {{0.1, 0.1}, {0.4, 0.1}, {0.4, 0.4}, {0.1, 0.4}},
+        {{0.5, 0.2}, {0.9, 0.5}, {0.5, 0.9}},
+        {{0.3, 0.3}, {0.7, 0.3}, {0.7, 0.7}, {0.3, 0.7}},
+        {{0.5, 0.5}}};
+    return polys;
+  }
+
+  static std::int64_t cube_bytes() { return std::int64_t(cube().data.size() * sizeof(std::uint16_t)); }
+
+  static void thread_args(benchmark::internal::Benchmark* bench)
+  {
+    bench->Arg(1);
+    unsigned const threads = std::thread::hardware_concurrency();
+    if (threads > 1)
+    {
+      bench->Arg(threads);
+    }
+  }
+
+  static void BM_spectral_get_spectrum_polygon(benchmark::State& state)
+  {
+    aux::parallel::thread_pool_t pool(std::size_t(state.range(0)));
+    aux::parallel::execution_t exec;
+    exec.pool = &pool;
+    image_t<std::uint16_t> const& image = cube().image;
+    for (auto _ : state)
+    {
+      auto spectrum = aux::spectral::get_spectrum_polygon(image, polygons()[0], exec);
+      benchmark::DoNotOptimize(spectrum);
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_spectral_get_spectrum_polygon)->Apply(thread_args);
+
+  static void BM_spectral_get_spectra_polygons(benchmark::State& state)
+  {
+    aux::parallel::thread_pool_t pool(std::size_t(state.range(0)));
+    aux::parallel::execution_t exec;
+    exec.pool = &pool;
+    image_t<std::uint16_t> const& image = cube().image;
+    for (auto _ : state)
+    {
+      auto spectra = aux::spectral::get_spectra_polygons(image, polygons(), exec);
+      benchmark::DoNotOptimize(spectra);
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_spectral_get_spectra_polygons)->Apply(thread_args);
+
+  static void BM_spectral_get_histogram(benchmark::State& state)
+  {
+    aux::parallel::thread_pool_t pool(std::size_t(state.range(0)));
+    aux::parallel::execution_t exec;
+    exec.pool = &pool;
+    image_t<std::uint16_t> const& image = cube().image;
+    for (auto _ : state)
+    {
+      auto histogram = aux::spectral::get_histogram(image, 0, 256, 16, false, Cube_Raw, true, exec);
+      benchmark::DoNotOptimize(histogram);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * cube_bytes());
+  }
+  BENCHMARK(BM_spectral_get_histogram)->Apply(thread_args)->Unit(benchmark::kMillisecond);
+
+  static void BM_spectral_accumulator_feed(benchmark::State& state)
+  {
+    aux::spectral::accumulator_settings_t settings;
+    settings.window = 8;
+    settings.count_bins = 256;
+    settings.wavelength_bins = 16;
+    settings.integer_binning = true;
+    image_t<std::uint16_t> const& image = cube().image;
+    aux::spectral::spectral_accumulator_t<std::uint16_t> accumulator(image, polygons(), settings);
+    for (auto _ : state)
+    {
+      accumulator.feed(image);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * cube_bytes());
+  }
+  BENCHMARK(BM_spectral_accumulator_feed)->Unit(benchmark::kMillisecond);
+
+} // namespace cuvis::bench
@@ -0,0 +1,62 @@
+#include "cuvis_benchmark.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace cuvis::bench
+{
+  /* end-to-end throughput of the worker, fed by the simulated camera replaying the session */
+  static void BM_Worker_simulated_camera(benchmark::State& state)
+  {
+    if (!require_session(state))
+    {
+      return;
+    }
+    SessionFile const& session = *environment().session;
+    AcquisitionContext acq(session, true);
+    ProcessingContext proc(session);
+
+    WorkerArgs args;
+    Worker worker(args);
+    worker.set_acq_cont(&acq);
+    worker.set_proc_cont(&proc);
+    auto instrumentation = std::make_shared<Instrumentation>();
+    worker.set_instrumentation(instrumentation);
+
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (acq.get_state() != hardware_state_t::hardware_state_online)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        state.SkipWithError("the simulated camera did not come online");
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    acq.set_operation_mode(operation_mode_t::OperationMode_Internal).get(std::chrono::milliseconds(5000));
+    acq.set_continuous(1).get(std::chrono::milliseconds(5000));
+    worker.start_processing();
+
+    std::int64_t timeouts = 0;
+    for (auto _ : state)
+    {
+      while (!worker.get_next_result(std::chrono::milliseconds(1000)).mesu.has_value())
+      {
+        timeouts++;
+      }
+    }
+
+    acq.set_continuous(0).get(std::chrono::milliseconds(5000));
+    worker.stop_processing();
+
+    auto const stats = instrumentation->snapshot();
+    auto const& latency = stats[Instrumentation::stage_t::capture_to_result];
+    state.SetItemsProcessed(state.iterations());
+    state.counters["latency_p50_ms"] = double(latency.percentile(0.5).count()) * 1e-6;
+    state.counters["latency_p99_ms"] = double(latency.percentile(0.99).count()) * 1e-6;
+    state.counters["frame_gaps"] = double(stats.counters.frame_gaps);
+    state.counters["timeouts"] = double(timeouts);
+  }
+  BENCHMARK(BM_Worker_simulated_camera)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace cuvis::bench
@@ -0,0 +1,164 @@
+#pragma once
+
+/** @file cuvis_benchmark.hpp
+  *
+  *
+  * @details Shared setup of the benchmarks: SDK initialization, the benchmark session and the export directory.
+  *
+  * The benchmarks are configured by environment variables:
+  *  - CUVIS_BENCHMARK_SETTINGS: the SDK settings directory, passed to @ref cuvis::General::init
+  *  - CUVIS_BENCHMARK_SESSION: a session file (.cu3s), replayed by the simulated camera and used as input data
+  *  - CUVIS_BENCHMARK_USERPLUGIN: a user plugin (.xml) for the viewer and view exporter benchmarks
+  *  - CUVIS_BENCHMARK_EXPORT_DIR: the directory the exporters write to, a temporary directory by default
+  *
+  * Benchmarks whose inputs are not configured are skipped with an error message.
+  * @copyright Apache V2.0
+  * */
+
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+
+#include <cuvis.hpp>
+
+namespace cuvis::bench
+{
+  /** @brief Value of an environment variable, if set and not empty */
+  inline std::optional<std::string> get_env(char const* name)
+  {
+    char const* value = std::getenv(name);
+    if (value == nullptr || *value == '\0')
+    {
+      return std::nullopt;
+    }
+    return std::string(value);
+  }
+
+  /** @brief The inputs shared by all benchmarks, loaded once */
+  struct environment_t
+  {
+    /** Whether the SDK was initialized, see CUVIS_BENCHMARK_SETTINGS.*/
+    bool initialized = false;
+
+    std::unique_ptr<SessionFile> session;
+
+    /** The first frame of @ref session.*/
+    std::unique_ptr<Measurement> frame;
+
+    /** The content of the user plugin, empty if not set.*/
+    std::string userplugin;
+
+    std::filesystem::path export_dir;
+
+    /** Why the session is not available, empty if it is.*/
+    std::string session_error;
+  };
+
+  /** @brief Initializes the SDK and loads the inputs, called once by main */
+  inline environment_t& environment()
+  {
+    static environment_t env = [] {
+      environment_t loaded;
+      loaded.export_dir = get_env("CUVIS_BENCHMARK_EXPORT_DIR").value_or((std::filesystem::temp_directory_path() / "cuvis_benchmark").string());
+
+      auto const settings = get_env("CUVIS_BENCHMARK_SETTINGS");
+      if (!settings.has_value())
+      {
+        loaded.session_error = "CUVIS_BENCHMARK_SETTINGS is not set";
+        return loaded;
+      }
+      General::init(*settings);
+      loaded.initialized = true;
+
+      if (auto const userplugin = get_env("CUVIS_BENCHMARK_USERPLUGIN"))
+      {
+        std::ifstream file(*userplugin);
+        loaded.userplugin.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      }
+
+      auto const session = get_env("CUVIS_BENCHMARK_SESSION");
+      if (!session.has_value())
+      {
+        loaded.session_error = "CUVIS_BENCHMARK_SESSION is not set";
+        return loaded;
+      }
+      loaded.session = std::make_unique<SessionFile>(*session);
+      auto frame = loaded.session->get_mesu(0);
+      if (!frame.has_value())
+      {
+        loaded.session_error = "the benchmark session contains no frames";
+        return loaded;
+      }
+      loaded.frame = std::make_unique<Measurement>(std::move(*frame));
+      return loaded;
+    }();
+    return env;
+  }
+
+  /** @brief Skips the benchmark, if the session is not available
+    *
+    * @returns true, if the benchmark can run
+    * */
+  inline bool require_session(benchmark::State& state)
+  {
+    environment_t const& env = environment();
+    if (!env.session || !env.frame)
+    {
+      state.SkipWithError(env.session_error.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief Skips the benchmark, if the session or the user plugin are not available
+    *
+    * @returns true, if the benchmark can run
+    * */
+  inline bool require_userplugin(benchmark::State& state)
+  {
+    if (!require_session(state))
+    {
+      return false;
+    }
+    if (environment().userplugin.empty())
+    {
+      state.SkipWithError("CUVIS_BENCHMARK_USERPLUGIN is not set");
+      return false;
+    }
+    return true;
+  }
+
+  /** @brief Size of all images of a measurement in bytes */
+  inline std::size_t image_bytes(Measurement const& mesu)
+  {
+    std::size_t bytes = 0;
+    for (auto const& entry : *mesu.get_image_table())
+    {
+      std::visit([&bytes](auto const& image) { bytes += image._width * image._height * image._channels * sizeof(*image._data); }, entry.image);
+    }
+    return bytes;
+  }
+
+  /** @brief Name of a processing mode, used as benchmark label */
+  inline char const* processing_mode_name(processing_mode_t mode)
+  {
+    switch (mode)
+    {
+      case processing_mode_t::Preview: return "Preview";
+      case processing_mode_t::Cube_Raw: return "Cube_Raw";
+      case processing_mode_t::Cube_DarkSubtract: return "Cube_DarkSubtract";
+      case processing_mode_t::Cube_Reflectance: return "Cube_Reflectance";
+      case processing_mode_t::Cube_SpectralRadiance: return "Cube_SpectralRadiance";
+      default: return "unknown";
+    }
+  }
+
+} // namespace cuvis::bench
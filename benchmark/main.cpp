@@ -0,0 +1,57 @@
+#include "cuvis_benchmark.hpp"
+
+#include <exception>
+#include <iostream>
+
+namespace
+{
+  char const* architecture()
+  {
+#if defined(__x86_64__) || defined(_M_X64)
+    return "x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return "aarch64";
+#elif defined(__arm__) || defined(_M_ARM)
+    return "arm";
+#else
+    return "unknown";
+#endif
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+  {
+    return 1;
+  }
+
+  try
+  {
+    cuvis::bench::environment_t const& env = cuvis::bench::environment();
+    if (env.initialized)
+    {
+      benchmark::AddCustomContext("cuvis_sdk_version", cuvis::General::version());
+    }
+    if (!env.session_error.empty())
+    {
+      std::cerr << "session benchmarks are skipped: " << env.session_error << std::endl;
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << "benchmark setup failed: " << e.what() << std::endl;
+    return 1;
+  }
+  benchmark::AddCustomContext("architecture", architecture());
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  if (cuvis::bench::environment().initialized)
+  {
+    cuvis::General::shutdown();
+  }
+  return 0;
+}
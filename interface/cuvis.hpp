@@ -10,15 +10,20 @@
 #include "cuvis.h"
 #pragma warning(disable : 26812)
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstring>
 #include <deque>
 #include <exception>
 #include <filesystem>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -27,6 +32,17 @@
 #include <thread>
 #include <type_traits>
 #include <variant>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+  #include <coroutine>
+  #define CUVIS_CPP_HAS_COROUTINES 1
+#endif
+
+#if defined(__unix__)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 namespace cuvis
 {
@@ -39,6 +55,7 @@ namespace cuvis
   class Exporter;
   class Async;
   class AsyncMesu;
+  class AsyncBatch;
   class General;
   class Worker;
 
@@ -163,6 +180,141 @@ namespace cuvis
   /** @endcond */
 
 
+  /** @brief Random access iterator over equally spaced elements
+    *
+    * @tparam value_t The element type, const for read-only access
+    * */
+  template <typename value_t>
+  class strided_iterator_t
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<value_t>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = value_t*;
+    using reference = value_t&;
+
+    strided_iterator_t() = default;
+
+    /** @brief Iterator to element index of the range starting at base */
+    strided_iterator_t(value_t* base, difference_type index, difference_type stride) : _base(base), _index(index), _stride(stride) {}
+
+    reference operator*() const { return _base[_index * _stride]; }
+    pointer operator->() const { return _base + _index * _stride; }
+    reference operator[](difference_type n) const { return _base[(_index + n) * _stride]; }
+
+    strided_iterator_t& operator++()
+    {
+      ++_index;
+      return *this;
+    }
+    strided_iterator_t operator++(int)
+    {
+      strided_iterator_t res = *this;
+      ++_index;
+      return res;
+    }
+    strided_iterator_t& operator--()
+    {
+      --_index;
+      return *this;
+    }
+    strided_iterator_t operator--(int)
+    {
+      strided_iterator_t res = *this;
+      --_index;
+      return res;
+    }
+    strided_iterator_t& operator+=(difference_type n)
+    {
+      _index += n;
+      return *this;
+    }
+    strided_iterator_t& operator-=(difference_type n)
+    {
+      _index -= n;
+      return *this;
+    }
+
+    friend strided_iterator_t operator+(strided_iterator_t it, difference_type n) { return it += n; }
+    friend strided_iterator_t operator+(difference_type n, strided_iterator_t it) { return it += n; }
+    friend strided_iterator_t operator-(strided_iterator_t it, difference_type n) { return it -= n; }
+    friend difference_type operator-(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index - b._index; }
+
+    friend bool operator==(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index == b._index; }
+    friend bool operator!=(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index != b._index; }
+    friend bool operator<(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index < b._index; }
+    friend bool operator>(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index > b._index; }
+    friend bool operator<=(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index <= b._index; }
+    friend bool operator>=(strided_iterator_t const& a, strided_iterator_t const& b) { return a._index >= b._index; }
+
+  private:
+    /* the position is kept as index, so the end iterator does not point past the underlying buffer */
+    value_t* _base = nullptr;
+    difference_type _index = 0;
+    difference_type _stride = 1;
+  };
+
+  /** @brief Non-owning view of contiguous elements
+    *
+    * The iterators are plain pointers, so loops over the view can be vectorized.
+    *
+    * @tparam value_t The element type, const for read-only access
+    * */
+  template <typename value_t>
+  class contiguous_range_t
+  {
+  public:
+    using value_type = std::remove_cv_t<value_t>;
+    using iterator = value_t*;
+
+    contiguous_range_t() = default;
+
+    /** @brief View of the elements [first, first + size) */
+    contiguous_range_t(value_t* first, std::size_t size) : _first(first), _size(size) {}
+
+    iterator begin() const { return _first; }
+    iterator end() const { return _first + _size; }
+    value_t* data() const { return _first; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    value_t& operator[](std::size_t i) const { return _first[i]; }
+
+  private:
+    value_t* _first = nullptr;
+    std::size_t _size = 0;
+  };
+
+  /** @brief Non-owning view of equally spaced elements
+    *
+    * @tparam value_t The element type, const for read-only access
+    * */
+  template <typename value_t>
+  class strided_range_t
+  {
+  public:
+    using value_type = std::remove_cv_t<value_t>;
+    using iterator = strided_iterator_t<value_t>;
+
+    strided_range_t() = default;
+
+    /** @brief View of size elements, starting at first, stride elements apart */
+    strided_range_t(value_t* first, std::size_t size, std::size_t stride) : _first(first), _size(size), _stride(stride) {}
+
+    iterator begin() const { return iterator(_first, 0, std::ptrdiff_t(_stride)); }
+    iterator end() const { return iterator(_first, std::ptrdiff_t(_size), std::ptrdiff_t(_stride)); }
+    value_t* data() const { return _first; }
+    std::size_t size() const { return _size; }
+    std::size_t stride() const { return _stride; }
+    bool empty() const { return _size == 0; }
+    value_t& operator[](std::size_t i) const { return _first[i * _stride]; }
+
+  private:
+    value_t* _first = nullptr;
+    std::size_t _size = 0;
+    std::size_t _stride = 1;
+  };
+
   /** @brief Metaclass for handling image data (2d or 3d)
     *
     * Holds an X/Y/Z- dimensional image cube, without wavelength informaiton. 
@@ -203,6 +355,36 @@ namespace cuvis
       * @returns the pixel value of the image / cube at position (x,y,z)
       * */
     data_t const& get(std::size_t x, std::size_t y, std::size_t z = std::size_t(0)) const;
+
+    /** View of the channel vector of a pixel
+      *
+      * @param x x pixel position (0 - @ref _width - 1)
+      * @param y y pixel position (0 - @ref _height - 1)
+      * @returns the @ref _channels contiguous values of pixel (x,y)
+      * */
+    contiguous_range_t<data_t const> pixel(std::size_t x, std::size_t y) const;
+
+    /** View of an image row
+      *
+      * @param y y pixel position (0 - @ref _height - 1)
+      * @returns the @ref _width * @ref _channels contiguous values of row y, in BIP interleave
+      * */
+    contiguous_range_t<data_t const> row(std::size_t y) const;
+
+    /** View of a single band (channel) of the image
+      *
+      * @param z z pixel position (0 - @ref _channels - 1)
+      * @returns the @ref _width * @ref _height values of band z, row by row, @ref _channels elements apart
+      * */
+    strided_range_t<data_t const> band(std::size_t z) const;
+
+    /** View of a single band (channel) of an image row
+      *
+      * @param y y pixel position (0 - @ref _height - 1)
+      * @param z z pixel position (0 - @ref _channels - 1)
+      * @returns the @ref _width values of band z in row y, @ref _channels elements apart
+      * */
+    strided_range_t<data_t const> band_row(std::size_t y, std::size_t z) const;
   };
 
   /** @brief Image data from a measurement
@@ -222,8 +404,15 @@ namespace cuvis
     /** wavelength vector. nullptr, an array of size @ref _channels contianing the wavelengths in nano meter. */
     uint32_t const* _wavelength;
 
+    /** @brief The owner of the image data
+      *
+      * Holding the owner keeps @ref _data and @ref _wavelength valid, e.g. while another library uses the data without copying it.
+      * */
+    std::shared_ptr<void const> get_owner() const { return _ref; }
+
   private:
-    std::shared_ptr<CUVIS_MESU> _ref;
+    /** The measurement, or the buffer of a reduced cube */
+    std::shared_ptr<void const> _ref;
   };
 
   /** @brief Image data created from @ref ViewExporter
@@ -251,6 +440,12 @@ namespace cuvis
     /**  The name of the image */
     std::string _id;
 
+    /** @brief The owner of the image data
+      *
+      * Holding the owner keeps the data valid, e.g. while another library uses the data without copying it.
+      * */
+    std::shared_ptr<void const> get_owner() const { return _ref; }
+
   private:
     std::shared_ptr<CUVIS_VIEW> _ref;
   };
@@ -467,6 +662,23 @@ namespace cuvis
       */
     bool complete;
   };
+
+  /** @brief A rectangular region of a cube, in pixels */
+  struct cube_region_t
+  {
+    /** First column of the region */
+    std::size_t x = 0;
+
+    /** First row of the region */
+    std::size_t y = 0;
+
+    /** Number of columns */
+    std::size_t width = 0;
+
+    /** Number of rows */
+    std::size_t height = 0;
+  };
+
   /** @brief processing arguments */
   struct ProcessingArgs
   {
@@ -487,6 +699,27 @@ namespace cuvis
       * @copydoc cuvis_proc_args_t.allow_recalib
       */
     bool allow_recalib;
+
+    /** @brief Indices of the channels to keep of the processed cube (default: empty, all channels)
+      *
+      * Applied by @ref ProcessingContext::apply after processing, see @ref Measurement::reduce_cube.
+      * Results of a @ref Worker are processed by the SDK and are not reduced.
+      * */
+    std::vector<std::size_t> channel_subset;
+
+    /** @brief Region to keep of the processed cube (default: the whole cube)
+      *
+      * Applied by @ref ProcessingContext::apply after processing, see @ref Measurement::reduce_cube.
+      * Results of a @ref Worker are processed by the SDK and are not reduced.
+      * */
+    std::optional<cube_region_t> region;
+
+    /** @brief Release the full cube within the SDK, once it is reduced to @ref channel_subset and @ref region (default: false)
+      *
+      * The SDK exporters and viewers use the full cube, so a measurement whose cube was released cannot be exported
+      * or viewed with them any more. Only set it, if the reduced cube is all that is used.
+      * */
+    bool discard_full_cube;
   };
 
   /** settings for the worker*/
@@ -775,6 +1008,34 @@ namespace cuvis
   };
 
 
+  /** @brief Interned key of a measurement data entry
+    *
+    * Each distinct name is registered once per process and mapped to a small integer id,
+    * so comparing keys does not compare strings.
+    */
+  class data_key_t
+  {
+  public:
+    /** @brief Interns the name, e.g. @ref CUVIS_MESU_CUBE_KEY */
+    data_key_t(char const* name);
+
+    /** @brief Interns the name */
+    data_key_t(std::string const& name);
+
+    /** @brief The process-wide unique id of the name */
+    std::uint32_t id() const { return _id; }
+
+    /** @brief The name of the key */
+    std::string const& name() const;
+
+    bool operator==(data_key_t const& other) const { return _id == other._id; }
+
+    bool operator!=(data_key_t const& other) const { return _id != other._id; }
+
+  private:
+    std::uint32_t _id;
+  };
+
   /** @brief central measurement class
     */
   class Measurement
@@ -797,6 +1058,16 @@ namespace cuvis
     using image_data_t = std::map<std::string, image_variant_t>;
     using sensor_info_data_t = std::map<std::string, SensorInfoData>;
 
+    /** @brief An image of the measurement with its interned key */
+    struct image_entry_t
+    {
+      data_key_t key;
+      image_variant_t image;
+    };
+
+    /** @brief Flat table of all images of the measurement, in SDK order */
+    using image_table_t = std::vector<image_entry_t>;
+
   public:
     /* shallow copy(move assignment) */
     Measurement& operator=(Measurement const& measurement) = default;
@@ -835,17 +1106,59 @@ namespace cuvis
 
     /** @brief Get GPS data from measurement
       */
-    gps_data_t const* get_gps() const { return _gps_data.get(); }
+    gps_data_t const* get_gps() const;
 
     /**  @brief Get image data from measurement
     *
     * Return image data from measurement.
     */
-    image_data_t const* get_imdata() const { return _image_data.get(); }
+    image_data_t const* get_imdata() const;
+
+    /** @brief Get all images as flat table
+    *
+    * Like @ref get_imdata, but without building the map. The keys are interned, see @ref data_key_t.
+    */
+    image_table_t const* get_image_table() const;
+
+    /** @brief Find an image in the image table
+    *
+    * @param key The key of the image
+    * @returns The image or nullptr, if the measurement has no image with that key
+    */
+    image_variant_t const* find_image(data_key_t const& key) const;
+
+    /** @brief Get a single image directly from the SDK
+    *
+    * Only queries the image with the given key, without building the image table or map.
+    *
+    * @tparam data_t The pixel bit depth of the image
+    * @param key The key of the image, e.g. @ref CUVIS_MESU_CUBE_KEY
+    * @returns The image or an empty optional, if the measurement has no image with that key
+    * @throws std::runtime_error if the image has a different bit depth or the SDK call fails
+    */
+    template <typename data_t>
+    std::optional<image_t<data_t>> get_image(char const* key) const;
+
+    /** @brief Get the processed cube directly from the SDK
+    *
+    * Same as @ref get_image with @ref CUVIS_MESU_CUBE_KEY.
+    *
+    * @tparam data_t The pixel bit depth of the cube, depends on the processing mode
+    * @returns The cube or an empty optional, if the measurement is not processed
+    */
+    template <typename data_t>
+    std::optional<image_t<data_t>> cube() const;
+
+    /** @brief Get the preview image directly from the SDK
+    *
+    * Same image as @ref get_thumbnail, without building the image table.
+    * @returns The preview or the pan image, an empty optional if neither is available
+    */
+    std::optional<image_t<std::uint8_t>> preview() const;
 
     /** @brief Get string data from measurement
       */
-    string_data_t const* get_strdata() const { return _string_data.get(); }
+    string_data_t const* get_strdata() const;
 
     /** @brief Get thumbnail / preview image of measurement
     * 
@@ -881,6 +1194,20 @@ namespace cuvis
     */
     void clear_cube();
 
+    /** @brief Reduces the cube to a subset of its channels and a region
+      *
+      * The reduced cube is copied into a buffer owned by the measurement and replaces the cube in @ref get_image_table,
+      * @ref get_image and @ref cube. The SDK still processes the full cube, the memory held per frame only shrinks if the full cube is discarded.
+      * Other SDK functions, e.g. the exporters, the viewers and a @ref Worker, use the full cube, and find no cube
+      * if it is discarded.
+      *
+      * @param channels Indices of the channels to keep, in the order given. Empty keeps all channels.
+      * @param region The region to keep, an empty optional keeps the whole cube
+      * @param discard_full_cube Release the full cube within the SDK, see @ref clear_cube
+      * @throws std::runtime_error if the measurement has no cube, or a channel or the region is out of range
+      * */
+    void reduce_cube(std::vector<std::size_t> const& channels, std::optional<cube_region_t> const& region, bool discard_full_cube = false);
+
     /**@brief Clear the implicit reference measurement
     * 
     * Implict measurements are created, when a measurement is processed with a processing context, where 
@@ -895,24 +1222,77 @@ namespace cuvis
     /**@brief Resynchronize the Measurement with the SDK data
     * 
 	* usally this does not have to be called manually, but is rather called internally by any operation that may result in invalidated (meta-)data
+    * 
+    * The data is not queried right away, but when it is accessed the next time. The pointers returned by the getters
+    * stay valid, their content is updated when the respective getter is called again.
     * */
     void refresh();
 
   private:
     Measurement(CUVIS_MESU handle);
 
+    /** @brief Categories of the data cached from the SDK */
+    enum cache_category_t : unsigned
+    {
+      cache_meta = 1u << 0,
+      cache_gps = 1u << 1,
+      cache_sensor_info = 1u << 2,
+      cache_string = 1u << 3,
+      cache_image = 1u << 4,
+      cache_image_map = 1u << 5,
+      cache_all = cache_meta | cache_gps | cache_sensor_info | cache_string | cache_image | cache_image_map
+    };
+
+    /** @brief Data cached from the SDK, shared by shallow copies */
+    struct cache_t
+    {
+      std::mutex mutex;
+      unsigned dirty = cache_all;
+
+      std::shared_ptr<MeasurementMetaData> meta;
+      sensor_info_data_t sensor_info;
+      gps_data_t gps_data;
+      string_data_t string_data;
+      image_table_t image_table;
+      image_data_t image_data;
+      std::shared_ptr<image_t<std::uint8_t>> preview_image;
+
+      /** the cube after @ref reduce_cube, replaces the SDK cube; not cleared by @ref clear */
+      std::shared_ptr<image_variant_t const> reduced_cube;
+
+      /** reused buffer for reading strings */
+      std::string buffer;
+
+      /** drops the data of the categories */
+      void clear(unsigned categories);
+    };
+
+    /** @brief Marks the categories to be queried again on the next access */
+    void invalidate(unsigned categories);
+
+    /** @brief Queries the dirty data of the categories from the SDK */
+    cache_t& fetch(unsigned categories) const;
+
+    /** @brief Wraps an SDK image buffer, keeping the measurement alive */
+    template <typename data_t>
+    image_t<data_t> make_image(cuvis_imbuffer_t const& im) const;
 
+    /** @brief Copies a channel subset and region of an image into a new buffer, see @ref reduce_cube */
+    template <typename data_t>
+    static image_t<data_t> reduce_image(image_t<data_t> const& image, std::vector<std::size_t> const& channels, cube_region_t const& region);
+
+    /** @brief The reduced cube, if @ref reduce_cube was called */
+    std::shared_ptr<image_variant_t const> reduced_cube() const;
+
+    /** @brief The SDK image format of an image data type */
+    template <typename data_t>
+    static constexpr cuvis_imbuffer_format_t image_format();
 
   private:
     std::shared_ptr<CUVIS_MESU> _mesu;
 
   private:
-    std::shared_ptr<MeasurementMetaData> _meta;
-    std::shared_ptr<sensor_info_data_t> _sensor_info;
-    std::shared_ptr<gps_data_t> _gps_data;
-    std::shared_ptr<string_data_t> _string_data;
-    std::shared_ptr<image_data_t> _image_data;
-    std::shared_ptr<image_t<std::uint8_t>> _preview_image;
+    std::shared_ptr<cache_t> _cache;
   };
 
   /**
@@ -976,6 +1356,13 @@ namespace cuvis
     std::shared_ptr<CUVIS_CALIB> _calib;
   };
 
+  /** @cond INTERNAL */
+  namespace session_impl
+  {
+    class frame_reader_state_t;
+  } // namespace session_impl
+  /** @endcond */
+
   class SessionFile
   {
     friend class Calibration;
@@ -983,9 +1370,163 @@ namespace cuvis
     friend class AcquisitionContext;
     friend class Worker;
 
+  public:
+    /** @brief Frames to read, see @ref frames */
+    struct frame_selection_t
+    {
+      /** First frame.*/
+      int_t first = 0;
+
+      /** Last frame (inclusive), std::nullopt selects the last frame of the session. Clamped to the last frame of the session.*/
+      std::optional<int_t> last;
+
+      /** Distance between two read frames.*/
+      int_t stride = 1;
+
+      cuvis_session_item_type_t type = cuvis_session_item_type_t::session_item_type_frames;
+    };
+
+    /** @brief A frame read by the @ref frame_reader_t */
+    struct frame_t
+    {
+      /** Index of the frame in the session.*/
+      int_t index;
+
+      /** The measurement, empty if the session has no measurement for the frame.*/
+      std::optional<Measurement> mesu;
+    };
+
+    /** @brief Input range over frames of a session, which are loaded ahead by background threads
+      *
+      * The background threads keep up to the prefetch count of frames in a ring ahead of the reader.
+      * The range can be iterated once. Exceptions of loading a frame are rethrown when the frame is reached.
+      */
+    class frame_reader_t
+    {
+    public:
+      class iterator
+      {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = frame_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = frame_t*;
+        using reference = frame_t&;
+
+        iterator() = default;
+
+        reference operator*() { return _frame; }
+        pointer operator->() { return &_frame; }
+
+        iterator& operator++();
+
+        bool operator==(iterator const& other) const { return _state == other._state; }
+        bool operator!=(iterator const& other) const { return _state != other._state; }
+
+      private:
+        friend class frame_reader_t;
+
+        explicit iterator(session_impl::frame_reader_state_t* state) : _state(state) { ++*this; }
+
+        session_impl::frame_reader_state_t* _state = nullptr;
+        frame_t _frame;
+      };
+
+      /** @brief Waits for the first frame, may be called once */
+      iterator begin() { return iterator(_state.get()); }
+
+      iterator end() { return iterator(); }
+
+      /** @brief Number of selected frames */
+      std::size_t size() const;
+
+    private:
+      friend class SessionFile;
+
+      explicit frame_reader_t(std::shared_ptr<session_impl::frame_reader_state_t> state) : _state(std::move(state)) {}
+
+      std::shared_ptr<session_impl::frame_reader_state_t> _state;
+    };
+
   public:
     SessionFile(std::filesystem::path const& path);
 
+    /** @brief Reads all frames of the session ahead of the caller
+      *
+      * @param prefetch Number of frames loaded ahead
+      */
+    frame_reader_t frames(std::size_t prefetch = 8) const;
+
+    /** @brief Reads the selected frames of the session ahead of the caller
+      *
+      * @param prefetch Number of frames loaded ahead
+      * @param selection The frames to read
+      * @param threads Number of background threads loading frames, the frames are returned in order regardless
+      */
+    frame_reader_t frames(std::size_t prefetch, frame_selection_t const& selection, std::size_t threads = 1) const;
+
+    /** @brief Indices of the selected frames, in ascending order
+      *
+      * @param selection The frames, @ref frame_selection_t::last is clamped to the last frame of the session
+      * @throws std::runtime_error if the stride is not positive
+      */
+    std::vector<int_t> get_indices(frame_selection_t const& selection) const;
+
+    /** @brief Reads a single image of a frame
+      *
+      * Only the requested image is read from the measurement, the other data of the measurement is not converted.
+      * The image points directly into the SDK buffer and keeps the measurement alive until the last copy of the image is released.
+      *
+      * @param frameNo The frame
+      * @param key The image, e.g. @ref CUVIS_MESU_CUBE_KEY
+      * @param type The item type of the frame
+      * @return The image, empty if the frame or the image does not exist
+      */
+    template <typename data_t>
+    std::optional<image_t<data_t>> get_image(int_t frameNo, char const* key = CUVIS_MESU_CUBE_KEY,
+        cuvis_session_item_type_t type = cuvis_session_item_type_t::session_item_type_frames) const;
+
+    /** @brief Expected access to the session file, see @ref advise */
+    enum class access_advice_t
+    {
+      /** The file will be read soon, start reading it into the page cache.*/
+      willneed,
+
+      /** The file is not needed any more, drop it from the page cache.*/
+      dontneed
+    };
+
+    /** @brief Passes a hint about the expected access to a byte range of the session file to the page cache
+      *
+      * Only applies to the page cache, as the SDK reads the file through its own descriptor, so the read ahead of the SDK
+      * itself is not changed. Only the range is read ahead or dropped. Keep the range to the frames read next, so the
+      * working set stays small. Use @ref access_advice_t::dontneed after reading a range, so the page cache of other files is kept.
+      *
+      * @param advice The expected access of the range
+      * @param offset First byte of the range
+      * @param length Number of bytes of the range, 0 for up to the end of the file
+      * @return true, if the operating system supports the hint
+      */
+    bool advise(access_advice_t advice, std::uint64_t offset, std::uint64_t length) const;
+
+    /** @brief Passes a hint about the expected access to a range of frames, see @ref advise
+      *
+      * The SDK does not expose the position of a frame in the file, so the byte range is estimated from the file size.
+      * The estimate assumes that all frames of the session have the same size, copes with a small header by extending
+      * the range by one frame on each side, and is only approximate for sessions with frames of different sizes.
+      *
+      * @param advice The expected access of the frames
+      * @param first First frame of the range
+      * @param count Number of frames of the range
+      * @param type The item type of the frames
+      * @return true, if the operating system supports the hint
+      */
+    bool advise_frames(access_advice_t advice, int_t first, int_t count,
+        cuvis_session_item_type_t type = cuvis_session_item_type_t::session_item_type_frames) const;
+
+    /** @brief The path the session was loaded from */
+    std::filesystem::path const& get_path() const { return _path; }
+
     std::optional<Measurement> get_mesu(int_t frameNo, cuvis_session_item_type_t type = cuvis_session_item_type_t::session_item_type_frames) const;
 
     std::optional<Measurement> get_ref(int_t refNo, cuvis_reference_type_t type) const;
@@ -1012,64 +1553,243 @@ namespace cuvis
 
   private:
     std::shared_ptr<CUVIS_SESSION_FILE> _session;
+    std::filesystem::path _path;
   };
 
-  class ProcessingContext
+  /** @brief Histogram of latencies with logarithmic buckets, each split into linear sub-buckets
+    *
+    * Values are recorded without locking. A percentile is exact up to 1 / @ref sub_buckets of its value.
+    * */
+  class LatencyHistogram
   {
-    friend class Worker;
-
   public:
-    //Builders
-    ProcessingContext(Calibration const& calib);
-    ProcessingContext(Measurement const& mesu);
-    ProcessingContext(SessionFile const& session);
-    //Apply
-    Measurement& apply(Measurement& mesu) const;
-    bool calc_distance(double distMM);
+    /** Number of linear sub-buckets per power of two */
+    static constexpr std::size_t sub_buckets = 8;
 
-  public:
-    //setters
+    /** Number of buckets, covering all values up to 2^64 nanoseconds */
+    static constexpr std::size_t bucket_count = (64 - 2) * sub_buckets;
 
-    /**
-    * @brief Set the reference for processing context
-    *  
-    * @param mesu measurement The measurement to be used as explicit reference
-    * @param type Type of reference to set
-    */
-    void set_reference(Measurement const& mesu, reference_type_t type);
+    /** @brief A copy of the histogram at a point in time */
+    struct snapshot_t
+    {
+      /** Number of recorded values.*/
+      std::uint64_t count = 0;
 
-    /**
-    * @brief Clear a reference measurement
-    * 
-    * @param type Type of reference to clear
-    */
-    void clear_reference(reference_type_t type);
-    /**
-    * @brief set the processing arguments for the processing context
-    * 
-    * @param procArgs arguments to set
-    */
-    void set_processingArgs(ProcessingArgs const& procArgs);
+      /** Sum of the recorded values.*/
+      std::chrono::nanoseconds sum = std::chrono::nanoseconds(0);
 
-    //getters
-    /**
-    * @brief get a specific reference from the processing context
-    *
-    * The processing context can hold explicit references (e.g. a dark),
-    * see @ref ProcessingArgs.set_reference . These reference can be obtained
-    * by this functions
-    */
-    std::optional<Measurement> get_reference(reference_type_t type) const;
+      std::chrono::nanoseconds min = std::chrono::nanoseconds(0);
+      std::chrono::nanoseconds max = std::chrono::nanoseconds(0);
 
-    /**
-    * @brief get the arguments of the processing context
-    */
-    ProcessingArgs const& get_processingArgs() const;
+      /** Number of values per bucket, see @ref bucket_lower_bound.*/
+      std::array<std::uint64_t, bucket_count> buckets = {};
 
-    //checkers
-    /**
-    @brief Check if a processing mode is possible for a measurement
-    *
+      std::chrono::nanoseconds mean() const;
+
+      /** @brief The value below which the given fraction of the values lies
+        *
+        * @param fraction The fraction in [0, 1], e.g. 0.99 for the 99th percentile
+        * */
+      std::chrono::nanoseconds percentile(double fraction) const;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(LatencyHistogram const&) = delete;
+    LatencyHistogram& operator=(LatencyHistogram const&) = delete;
+
+    void record(std::chrono::nanoseconds latency);
+
+    /** @brief Copies the histogram, optionally clearing it */
+    snapshot_t snapshot(bool reset = false);
+
+    /** @brief Smallest value counted by a bucket, in nanoseconds */
+    static std::uint64_t bucket_lower_bound(std::size_t bucket);
+
+    /** @brief The bucket counting a value in nanoseconds */
+    static std::size_t bucket_of(std::uint64_t value);
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> _buckets = {};
+    std::atomic<std::uint64_t> _count{0};
+    std::atomic<std::uint64_t> _sum{0};
+    std::atomic<std::uint64_t> _min{UINT64_MAX};
+    std::atomic<std::uint64_t> _max{0};
+  };
+
+  /** @brief Opt-in latency and throughput statistics of the processing pipeline
+    *
+    * Attach an instance with @ref Worker::set_instrumentation, @ref ProcessingContext::set_instrumentation,
+    * @ref Viewer::set_instrumentation or @ref Exporter::set_instrumentation. Every attached object records the
+    * durations of its stages into a @ref LatencyHistogram. The statistics are read with @ref snapshot, or passed
+    * periodically to a callback, see @ref set_snapshot_callback.
+    *
+    * The stages within the SDK worker (acquisition, queues, processing, viewer and exporter of the worker) are not
+    * visible individually; they are covered together by @ref stage_t::capture_to_result.
+    * */
+  class Instrumentation
+  {
+  public:
+    /** @brief The measured stages */
+    enum class stage_t : std::size_t
+    {
+      /** From the capture time of a measurement to the worker result, see @ref MeasurementMetaData::capture_time.*/
+      capture_to_result = 0,
+
+      /** From the worker result to the start of the worker callback.*/
+      callback_queue,
+
+      /** Duration of the worker callback.*/
+      callback,
+
+      /** Duration of @ref ProcessingContext::apply.*/
+      processing,
+
+      /** Duration of @ref Viewer::apply.*/
+      viewer,
+
+      /** Duration of @ref Exporter::apply.*/
+      exporter
+    };
+
+    static constexpr std::size_t stage_count = 6;
+
+    /** @brief Counters of the worker results */
+    struct counters_t
+    {
+      /** Number of results received from the worker.*/
+      std::uint64_t results = 0;
+
+      /** Number of results carrying an exception along with the measurement.*/
+      std::uint64_t errors = 0;
+
+      /** Number of frame ids missing between consecutive results, i.e. frames dropped or skipped.*/
+      std::uint64_t frame_gaps = 0;
+    };
+
+    /** @brief The statistics at a point in time */
+    struct snapshot_t
+    {
+      std::chrono::steady_clock::time_point time;
+
+      /** Time since the statistics were created or last reset.*/
+      std::chrono::nanoseconds period = std::chrono::nanoseconds(0);
+
+      std::array<LatencyHistogram::snapshot_t, stage_count> stages;
+
+      counters_t counters;
+
+      LatencyHistogram::snapshot_t const& operator[](stage_t stage) const { return stages[std::size_t(stage)]; }
+
+      /** Results per second over @ref period.*/
+      double results_per_second() const;
+    };
+
+    Instrumentation() = default;
+
+    /** @brief Stops the snapshot callback */
+    ~Instrumentation();
+
+    Instrumentation(Instrumentation const&) = delete;
+    Instrumentation& operator=(Instrumentation const&) = delete;
+
+    /** @brief Records the duration of a stage */
+    void record(stage_t stage, std::chrono::nanoseconds latency);
+
+    /** @brief Counts a worker result
+      *
+      * @param frame_id The frame id of the result, if known
+      * @param error Whether the result carries an exception
+      * */
+    void record_result(std::optional<std::uint64_t> frame_id, bool error);
+
+    /** @brief Copies the statistics, optionally resetting them */
+    snapshot_t snapshot(bool reset = false);
+
+    void reset();
+
+    /** @brief Calls the callback with a snapshot every interval, from a separate thread
+      *
+      * @param callback The callback, e.g. forwarding the snapshot to a metrics system
+      * @param interval Time between two snapshots
+      * @param reset Reset the statistics with every snapshot, so every snapshot covers one interval
+      * */
+    void set_snapshot_callback(std::function<void(snapshot_t const&)> callback, std::chrono::milliseconds interval, bool reset = true);
+
+    /** @brief Stops the snapshot callback */
+    void reset_snapshot_callback();
+
+  private:
+    std::array<LatencyHistogram, stage_count> _stages;
+    std::atomic<std::uint64_t> _results{0};
+    std::atomic<std::uint64_t> _errors{0};
+    std::atomic<std::uint64_t> _frame_gaps{0};
+    std::atomic<std::uint64_t> _last_frame_id{UINT64_MAX};
+
+    std::mutex _period_mutex;
+    std::chrono::steady_clock::time_point _period_start = std::chrono::steady_clock::now();
+
+    std::mutex _snapshot_mutex;
+    std::condition_variable _snapshot_wake;
+    bool _snapshot_run = false;
+    std::thread _snapshot_thread;
+  };
+
+  class ProcessingContext
+  {
+    friend class Worker;
+
+  public:
+    //Builders
+    ProcessingContext(Calibration const& calib);
+    ProcessingContext(Measurement const& mesu);
+    ProcessingContext(SessionFile const& session);
+    //Apply
+    Measurement& apply(Measurement& mesu) const;
+    bool calc_distance(double distMM);
+
+  public:
+    //setters
+
+    /**
+    * @brief Set the reference for processing context
+    *  
+    * @param mesu measurement The measurement to be used as explicit reference
+    * @param type Type of reference to set
+    */
+    void set_reference(Measurement const& mesu, reference_type_t type);
+
+    /**
+    * @brief Clear a reference measurement
+    * 
+    * @param type Type of reference to clear
+    */
+    void clear_reference(reference_type_t type);
+    /**
+    * @brief set the processing arguments for the processing context
+    * 
+    * @param procArgs arguments to set
+    */
+    void set_processingArgs(ProcessingArgs const& procArgs);
+
+    //getters
+    /**
+    * @brief get a specific reference from the processing context
+    *
+    * The processing context can hold explicit references (e.g. a dark),
+    * see @ref ProcessingArgs.set_reference . These reference can be obtained
+    * by this functions
+    */
+    std::optional<Measurement> get_reference(reference_type_t type) const;
+
+    /**
+    * @brief get the arguments of the processing context
+    */
+    ProcessingArgs const& get_processingArgs() const;
+
+    //checkers
+    /**
+    @brief Check if a processing mode is possible for a measurement
+    *
     * Depending on the measurement, it's intrinsic references, the processing
     * context's explicit references and the internal camera calibration itself
     * the availability of a mode varies.
@@ -1090,9 +1810,105 @@ namespace cuvis
     */
     std::string get_calib_id() const;
 
+  public:
+    //reference profiles
+
+    /** @brief References of a reference profile, see @ref add_reference_profile */
+    using reference_set_t = std::vector<std::pair<reference_type_t, Measurement const*>>;
+
+    /**
+    * @brief Add a named set of references, which can be activated later without setting the references again
+    *
+    * Every profile is prepared once in its own SDK processing context, created from the calibration of this
+    * processing context and set up with the current processing arguments and the given references. The reference
+    * measurements may be released afterwards. The active profile is profile 0, named "default", until another
+    * profile is activated.
+    *
+    * Only a processing context created from a @ref Calibration keeps its source. A processing context created from a
+    * measurement or a session file does not keep it in memory, so its profiles are added with the overloads taking
+    * the source.
+    *
+    * @param name Name of the profile, must be unique
+    * @param references The references of the profile
+    * @returns The index of the profile, see @ref activate_reference_profile
+    * @throws std::runtime_error if the processing context was not created from a calibration
+    */
+    std::size_t add_reference_profile(std::string const& name, reference_set_t const& references);
+
+    /**
+    * @brief Add a reference profile, prepared in an SDK processing context created from the measurement, see @ref add_reference_profile
+    *
+    * @param source The measurement this processing context was created from, or another one with the same calibration
+    */
+    std::size_t add_reference_profile(std::string const& name, reference_set_t const& references, Measurement const& source);
+
+    /**
+    * @brief Add a reference profile, prepared in an SDK processing context created from the session file, see @ref add_reference_profile
+    *
+    * @param source The session file this processing context was created from, or another one with the same calibration
+    */
+    std::size_t add_reference_profile(std::string const& name, reference_set_t const& references, SessionFile const& source);
+
+    /**
+    * @brief Activate a reference profile in constant time
+    *
+    * The references, @ref apply, @ref calc_distance and the other functions use the active profile afterwards.
+    * The processing arguments are shared by all profiles. Must not be called concurrently with @ref apply.
+    * A @ref Worker keeps the profile which was active when @ref Worker::set_proc_cont was called.
+    *
+    * @param index The index returned by @ref add_reference_profile, 0 for the default profile
+    */
+    void activate_reference_profile(std::size_t index);
+
+    /**
+    * @brief Activate a reference profile by name, see @ref activate_reference_profile
+    */
+    void activate_reference_profile(std::string const& name);
+
+    /**
+    * @brief get the index of the active reference profile
+    */
+    std::size_t get_active_reference_profile() const;
+
+    /**
+    * @brief get the names of all reference profiles, by index
+    */
+    std::vector<std::string> get_reference_profiles() const;
+
+    /**
+    * @brief Record the duration of @ref apply, see @ref Instrumentation::stage_t::processing
+    *
+    * @param instrumentation The statistics, nullptr to stop recording
+    */
+    void set_instrumentation(std::shared_ptr<Instrumentation> instrumentation);
+
   private:
+    /** @brief Creates an SDK processing context from a source */
+    using factory_t = std::function<CUVIS_PROC_CONT()>;
+
+    static factory_t make_factory(Calibration const& calib);
+    static factory_t make_factory(Measurement const& mesu);
+    static factory_t make_factory(SessionFile const& session);
+
+    struct reference_profile_t
+    {
+      std::string name;
+      std::shared_ptr<CUVIS_PROC_CONT> procCont;
+    };
+
+    void init(CUVIS_PROC_CONT procCont, factory_t factory);
+
+    std::size_t add_profile(std::string const& name, reference_set_t const& references, factory_t const& factory);
+
     std::shared_ptr<CUVIS_PROC_CONT> _procCont;
     ProcessingArgs _procArgs;
+
+    /* creates the contexts of further profiles, empty unless created from a calibration */
+    factory_t _factory;
+    std::vector<reference_profile_t> _profiles;
+    std::size_t _activeProfile = 0;
+
+    std::shared_ptr<Instrumentation> _instrumentation;
   };
 
   enum class async_result_t
@@ -1103,6 +1919,65 @@ namespace cuvis
     deferred
   };
 
+#ifdef CUVIS_CPP_HAS_COROUTINES
+  /** @cond INTERNAL */
+  namespace async_impl
+  {
+    template <typename result_t>
+    struct awaiter_t
+    {
+      std::function<std::optional<result_t>(std::chrono::milliseconds)> poll;
+      std::optional<result_t> result;
+      std::exception_ptr error;
+
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle);
+      result_t await_resume();
+    };
+  } // namespace async_impl
+  /** @endcond */
+#endif
+
+  /** @brief An operation whose completion is detected by a shared completion thread
+    *
+    * The SDK offers no completion callbacks, so a single thread polls all pending operations. The poll interval starts
+    * at 1 ms and doubles up to 16 ms while nothing completes, new operations are polled at once. The thread sleeps
+    * while no operation is pending.
+    * Continuations and resumed coroutines run on this thread and should hand longer work over to an executor of their own.
+    *
+    * Use only one of @ref get_future, @ref then or co_await per operation.
+    */
+  template <typename result_t>
+  class AsyncOperation
+  {
+    friend class Async;
+    friend class AsyncMesu;
+    friend class AsyncBatch;
+    friend class AcquisitionContext;
+
+  public:
+    using result_type = result_t;
+
+    /** @brief Returns a future, which becomes ready with the result of the operation */
+    std::future<result_t> get_future() const;
+
+    /** @brief Calls the continuation with a ready future when the operation completed */
+    void then(std::function<void(std::future<result_t>)> continuation) const;
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+    /** @brief Awaits the operation, the coroutine is resumed on the completion thread */
+    async_impl::awaiter_t<result_t> operator co_await() const;
+#endif
+
+  private:
+    /* polls the operation with the given wait time, returns the result if it completed */
+    using poll_t = std::function<std::optional<result_t>(std::chrono::milliseconds)>;
+
+    explicit AsyncOperation(poll_t poll) : _poll(std::move(poll)) {}
+
+    poll_t _poll;
+  };
+
   class Async
   {
     friend class AcquisitionContext;
@@ -1110,6 +1985,19 @@ namespace cuvis
   public:
     async_result_t get(std::chrono::milliseconds waittime = std::chrono::milliseconds(0));
 
+    /** @brief Future of the result of the call, see @ref AsyncOperation */
+    std::future<async_result_t> get_future() const;
+
+    /** @brief Calls the continuation when the call completed, see @ref AsyncOperation */
+    void then(std::function<void(std::future<async_result_t>)> continuation) const;
+
+    /** @brief The call as an @ref AsyncOperation, which can be awaited */
+    AsyncOperation<async_result_t> operation() const;
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+    async_impl::awaiter_t<async_result_t> operator co_await() const { return operation().operator co_await(); }
+#endif
+
   private:
     std::shared_ptr<CUVIS_ASYNC_CALL_RESULT> _async;
   };
@@ -1119,13 +2007,61 @@ namespace cuvis
     friend class AcquisitionContext;
 
   public:
-    std::pair<async_result_t, std::optional<Measurement>> get(std::chrono::milliseconds waittime = std::chrono::milliseconds(0));
+    using result_t = std::pair<async_result_t, std::optional<Measurement>>;
+
+    result_t get(std::chrono::milliseconds waittime = std::chrono::milliseconds(0));
+
+    /** @brief Future of the result of the capture, see @ref AsyncOperation */
+    std::future<result_t> get_future() const;
 
+    /** @brief Calls the continuation when the capture completed, see @ref AsyncOperation */
+    void then(std::function<void(std::future<result_t>)> continuation) const;
+
+    /** @brief The capture as an @ref AsyncOperation, which can be awaited */
+    AsyncOperation<result_t> operation() const;
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+    async_impl::awaiter_t<result_t> operator co_await() const { return operation().operator co_await(); }
+#endif
 
   private:
     std::shared_ptr<CUVIS_ASYNC_CAPTURE_RESULT> _async;
   }; // namespace cuvis
 
+  /** @brief Combined completion of a batch of settings, see @ref AcquisitionContext::apply
+    *
+    * The result is the least favourable result of all calls of the batch: overwritten before deferred before done.
+    */
+  class AsyncBatch
+  {
+    friend class AcquisitionContext;
+
+  public:
+    /** @brief Waits at most waittime for the batch to complete
+      *
+      * Rethrows the first exception of the batch once all calls of the batch have finished.
+      */
+    async_result_t get(std::chrono::milliseconds waittime = std::chrono::milliseconds(0));
+
+    /** @brief Future of the result of the batch, see @ref AsyncOperation */
+    std::future<async_result_t> get_future() const;
+
+    /** @brief Calls the continuation when the batch completed, see @ref AsyncOperation */
+    void then(std::function<void(std::future<async_result_t>)> continuation) const;
+
+    /** @brief The batch as an @ref AsyncOperation, which can be awaited */
+    AsyncOperation<async_result_t> operation() const;
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+    async_impl::awaiter_t<async_result_t> operator co_await() const { return operation().operator co_await(); }
+#endif
+
+  private:
+    struct state_t;
+
+    std::shared_ptr<state_t> _state;
+  };
+
 
 
   class AcquisitionContext
@@ -1144,6 +2080,51 @@ namespace cuvis
     using component_state_t = std::pair<std::string, bool>;
     using state_callback_t = std::function<void(hardware_state_t, std::map<int_t, component_state_info_t>)>;
 
+    /** @brief Settings of the state monitor, see @ref register_state_change_callback */
+    struct state_monitor_args_t
+    {
+      /** Time between two checks of the state, if no wake-up occurs.*/
+      std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500);
+
+      /** SDK event types (see @ref General::register_event_callback) which trigger an immediate check of the state.*/
+      std::vector<int_t> wake_events;
+
+      /** Call the callback with the initial state.*/
+      bool output_initial_state = true;
+    };
+
+    /** @brief Collects settings to apply them as one batch, see @ref apply
+      *
+      * Setting the same value twice keeps the last value at the position of the first.
+      */
+    class settings_batch_t
+    {
+      friend class AcquisitionContext;
+
+    public:
+      settings_batch_t& set_fps(double value);
+      settings_batch_t& set_integration_time(double value);
+      settings_batch_t& set_auto_exp(bool value);
+      settings_batch_t& set_auto_exp_comp(double value);
+      settings_batch_t& set_binning(bool value);
+      settings_batch_t& set_operation_mode(operation_mode_t value);
+      settings_batch_t& set_average(int value);
+      settings_batch_t& set_component_gain(size_t id, double value);
+      settings_batch_t& set_component_integration_time_factor(size_t id, double value);
+
+      /** @brief Number of settings in the batch */
+      size_t size() const { return _steps.size(); }
+
+      bool empty() const { return _steps.empty(); }
+
+    private:
+      using step_t = std::function<Async(AcquisitionContext const&)>;
+
+      settings_batch_t& add(std::string key, step_t step);
+
+      std::vector<std::pair<std::string, step_t>> _steps;
+    };
+
 
   public:
     AcquisitionContext(Calibration const& calib);
@@ -1158,6 +2139,13 @@ namespace cuvis
     Async set_component_pixel_format(int id, std::string format);
     std::vector<std::string> get_component_available_pixel_formats(int_t id) const;
     std::optional<Measurement> get_next_measurement(std::chrono::milliseconds timeout_ms = std::chrono::milliseconds(0)) const;
+
+    /** @brief Waits for the next measurement without blocking a thread, see @ref AsyncOperation
+      *
+      * @param timeout_ms Time to wait for a measurement, std::nullopt waits until one is available
+      * @return The operation, its result is empty if no measurement arrived within the timeout
+      */
+    AsyncOperation<std::optional<Measurement>> get_next_measurement_async(std::optional<std::chrono::milliseconds> timeout_ms = std::nullopt) const;
     SessionInfo get_session_info() const;
     int_t get_component_count() const;
     CUVIS_COMPONENT_INFO get_component_info(int_t id) const;
@@ -1167,9 +2155,39 @@ namespace cuvis
 
     bool has_next_measurement() const;
 
+    /** @brief Applies a batch of settings
+      *
+      * All settings are sent to the SDK at once, without waiting for each call in between.
+      * With pause_continuous set, continuous mode is switched off before the settings and on again after
+      * all of them completed, so no frame is captured with partially applied settings.
+      * Continuous mode is switched on again even if a setting failed.
+      * Later stages are issued by the completion thread of @ref AsyncOperation, also if the returned handle is dropped.
+      * The acquisition context must outlive the completion of the batch.
+      *
+      * @param batch The settings
+      * @param pause_continuous Pause continuous mode while the settings are applied, use only while continuous mode is on
+      * @return The combined completion of all calls
+      */
+    AsyncBatch apply(settings_batch_t const& batch, bool pause_continuous = false) const;
+
     void register_state_change_callback(state_callback_t callback, bool output_initial_state = true);
+
+    /** @brief Calls the callback whenever the hardware state or the online state of a component changes
+      *
+      * The state is checked every @ref state_monitor_args_t::poll_interval, and immediately on the SDK events
+      * listed in @ref state_monitor_args_t::wake_events or a call of @ref notify_state_change.
+      *
+      * @param callback The callback, called from the monitor thread
+      * @param args The settings of the monitor
+      */
+    void register_state_change_callback(state_callback_t callback, state_monitor_args_t const& args);
+
+    /** @brief Stops the state monitor, returns without waiting for the poll interval */
     void reset_state_change_callback();
 
+    /** @brief Makes the state monitor check the state immediately */
+    void notify_state_change();
+
 
 #define ACQ_STUB_0a(funname, sdkname, type_ifcae, type_wrapped) \
   type_wrapped get_##funname() const                            \
@@ -1266,6 +2284,11 @@ namespace cuvis
     std::atomic_bool _state_poll_thread_run;
 
     std::thread _state_poll_thread;
+
+    std::mutex _state_wake_mutex;
+    std::condition_variable _state_wake;
+    bool _state_wake_pending = false;
+    std::vector<int_t> _state_event_handlers;
   };
 
   class Viewer
@@ -1277,14 +2300,66 @@ namespace cuvis
     using view_variant_t = std::variant<view_t<std::uint8_t>, view_t<float>>;
     using view_data_t = std::map<std::string, view_variant_t>;
 
+    /** @brief A caller-owned buffer a view is copied into, see @ref apply(Measurement const&, std::vector<view_target_t>&)
+      *
+      * The buffer may be swapped between two calls, e.g. for double buffering, the cached view index stays valid.
+      * */
+    struct view_target_t
+    {
+      /** The id of the view, as the key of @ref view_data_t.*/
+      std::string id;
+
+      /** The destination of the view data, in BIP interleave.*/
+      void* data = nullptr;
+
+      /** Size of @ref data in bytes.*/
+      std::size_t capacity = 0;
+
+      /** Distance between the starts of two rows in @ref data in bytes, 0 for rows without padding.*/
+      std::size_t row_stride = 0;
+
+      /** Whether the view was found and copied by the last call, the fields below are valid then.*/
+      bool written = false;
+
+      std::size_t width = 0;
+      std::size_t height = 0;
+      std::size_t channels = 0;
+
+      /** Either @ref cuvis_imbuffer_format_t::imbuffer_format_uint8 or @ref cuvis_imbuffer_format_t::imbuffer_format_float.*/
+      cuvis_imbuffer_format_t format = cuvis_imbuffer_format_t::imbuffer_format_uint8;
+
+      cuvis_view_category_t category = cuvis_view_category_t::category_image;
+      bool show = false;
+
+      /** Position of the view within the viewer result, resolved by the first call. Set to -1 for resolving it again.*/
+      int_t index = -1;
+    };
 
   public:
     Viewer(ViewArgs const& args);
     view_data_t apply(Measurement const& mesu);
 
+    /** @brief Renders the views into caller-owned buffers
+      *
+      * Copies every view with the id of a target into the buffer of the target. Unlike @ref apply(Measurement const&),
+      * no memory is allocated: the position of every id is resolved with the first call and cached in the target,
+      * the view handle of the SDK is freed before returning.
+      *
+      * @param[in] mesu The measurement
+      * @param[in,out] targets The buffers, @ref view_target_t::written tells which views were found
+      * @returns The number of written targets
+      * @throws std::runtime_error if a buffer is too small or the view data type is not supported
+      * */
+    std::size_t apply(Measurement const& mesu, std::vector<view_target_t>& targets);
+
+    /** @brief Record the duration of @ref apply, see @ref Instrumentation::stage_t::viewer */
+    void set_instrumentation(std::shared_ptr<Instrumentation> instrumentation);
+
   private:
     std::shared_ptr<CUVIS_VIEWER> _viewer;
+    std::shared_ptr<Instrumentation> _instrumentation;
     static view_data_t create_view_data(CUVIS_VIEW);
+    static void copy_view(cuvis_view_data_t const& view_data, view_target_t& target);
   };
 
   class Exporter
@@ -1299,12 +2374,16 @@ namespace cuvis
     size_t get_queue_used() const;
     void flush();
 
+    /** @brief Record the duration of @ref apply, see @ref Instrumentation::stage_t::exporter */
+    void set_instrumentation(std::shared_ptr<Instrumentation> instrumentation);
+
   protected:
     Exporter() = default;
     void setHandle(CUVIS_EXPORTER exporter);
 
   private:
     std::shared_ptr<CUVIS_EXPORTER> _exporter;
+    std::shared_ptr<Instrumentation> _instrumentation;
   };
 
   class CubeExporter : public Exporter
@@ -1340,7 +2419,14 @@ namespace cuvis
     ViewExporter(ViewArgs const& args);
   };
 
-  class Worker
+  /** @cond INTERNAL */
+  namespace worker_impl
+  {
+    class callback_pool_t;
+  } // namespace worker_impl
+  /** @endcond */
+
+  class Worker
   {
   public:
     struct worker_return_t
@@ -1348,6 +2434,12 @@ namespace cuvis
       std::optional<Measurement> mesu;
       std::optional<Viewer::view_data_t> view;
       std::exception_ptr exception;
+
+      /** When the result was taken from the worker.*/
+      std::chrono::steady_clock::time_point received_time;
+
+      /** When the result was passed to the worker callback, see @ref register_worker_callback.*/
+      std::chrono::steady_clock::time_point delivered_time;
     };
 
     struct worker_state_t
@@ -1363,9 +2455,48 @@ namespace cuvis
 
     using worker_callback_t = std::function<void(worker_return_t)>;
 
+    /** @brief Delivery order of the worker callback */
+    enum class callback_order_t
+    {
+      /** Callbacks start in result order. A new result is only accepted if it is within
+        * the queue size of the oldest result whose callback is still running. */
+      in_order,
+
+      /** Callbacks start in result order, but each result is accepted as soon as the queue has room,
+        * so a slow callback does not hold back the following results. */
+      out_of_order
+    };
+
+    /** @brief Settings of the worker callback */
+    struct callback_args_t
+    {
+      /** Number of threads calling the callback.*/
+      unsigned concurrency = 1;
+
+      /** Number of waiting (out_of_order) or unfinished (in_order) results, 0 selects @ref concurrency.*/
+      std::size_t queue_size = 0;
+
+      /** The delivery order.*/
+      callback_order_t order = callback_order_t::in_order;
+
+      /** Called with exceptions thrown by the callback. If not set, the exceptions are dropped.*/
+      std::function<void(std::exception_ptr)> error_callback;
+
+      /** Call the callback directly from the thread receiving the results, which saves the hand-over to the callback threads.
+        * @ref concurrency, @ref queue_size and @ref order are ignored, the next result is received after the callback returned.*/
+      bool deliver_inline = false;
+
+      /** Longest time to wait for a result within the SDK. A result is returned as soon as it is available,
+        * so this only limits how long @ref reset_worker_callback waits for the receiving thread.*/
+      std::chrono::milliseconds poll_interval = std::chrono::milliseconds(10);
+    };
+
   public:
     Worker(WorkerArgs const& args);
 
+    /** @brief Stops the worker callback, see @ref reset_worker_callback */
+    ~Worker();
+
     void set_acq_cont(AcquisitionContext const* acqCont);
     void set_proc_cont(ProcessingContext const* procCont);
     void set_exporter(Exporter const* exporter);
@@ -1399,17 +2530,56 @@ namespace cuvis
 
     worker_state_t get_state() const;
 
+    /** @brief Calls the callback for every result, see @ref callback_order_t::in_order
+      *
+      * @param callback The callback
+      * @param concurrency Number of threads calling the callback
+      */
     void register_worker_callback(worker_callback_t callback, unsigned concurrency = 1);
 
+    /** @brief Calls the callback for every result
+      *
+      * The results are handed to a fixed set of threads through a bounded queue. While the queue is full, no further results
+      * are taken from the worker.
+      *
+      * @param callback The callback
+      * @param args The settings of the callback
+      */
+    void register_worker_callback(worker_callback_t callback, callback_args_t const& args);
+
+    /** @brief Stops the worker callback
+      *
+      * Waits for the running callbacks, results which are queued but not yet delivered are dropped.
+      * Must not be called from within the callback.
+      */
     void reset_worker_callback();
 
+    /** @brief Record latencies and counters of the results, see @ref Instrumentation
+      *
+      * Records @ref Instrumentation::stage_t::capture_to_result and the frame gaps for every result,
+      * and @ref Instrumentation::stage_t::callback_queue and @ref Instrumentation::stage_t::callback for the worker callback.
+      * May be called at any time, also while a worker callback is registered. A result is recorded by the instrumentation
+      * set when it was received, also if its callback runs later.
+      *
+      * @param instrumentation The statistics, nullptr to stop recording
+      */
+    void set_instrumentation(std::shared_ptr<Instrumentation> instrumentation);
+
   private:
+    std::shared_ptr<Instrumentation> get_instrumentation() const;
+
     std::shared_ptr<CUVIS_WORKER> _worker;
 
+    /* read by the poll thread and by get_next_result, guarded by the mutex */
+    std::shared_ptr<Instrumentation> _instrumentation;
+    mutable std::mutex _instrumentation_mutex;
+
 
     std::atomic_bool _worker_poll_thread_run;
 
     std::thread _worker_poll_thread;
+
+    std::unique_ptr<worker_impl::callback_pool_t> _callback_pool;
   };
 
   /** \cond INTERNAL */
@@ -1425,28 +2595,21 @@ namespace cuvis
     }
   }
 
-  inline Measurement::Measurement(Measurement const& source)
-      : _gps_data(std::make_shared<gps_data_t>()),
-        _string_data(std::make_shared<string_data_t>()),
-        _image_data(std::make_shared<image_data_t>()),
-        _sensor_info(std::make_shared<sensor_info_data_t>())
+  inline Measurement::Measurement(Measurement const& source) : _cache(std::make_shared<cache_t>())
   {
     CUVIS_MESU copy_handle;
     chk(cuvis_measurement_deep_copy(*source._mesu, &copy_handle));
+    // the reduced cube is immutable and can be shared
+    _cache->reduced_cube = source.reduced_cube();
 
     _mesu = std::shared_ptr<CUVIS_MESU>(new CUVIS_MESU{copy_handle}, [](CUVIS_MESU* handle) {
       cuvis_measurement_free(handle);
       delete handle;
     });
-    refresh();
   }
 
 
-  inline Measurement::Measurement(std::filesystem::path const& path)
-      : _gps_data(std::make_shared<gps_data_t>()),
-        _string_data(std::make_shared<string_data_t>()),
-        _image_data(std::make_shared<image_data_t>()),
-        _sensor_info(std::make_shared<sensor_info_data_t>())
+  inline Measurement::Measurement(std::filesystem::path const& path) : _cache(std::make_shared<cache_t>())
   {
     CUVIS_MESU mesu;
     chk(cuvis_measurement_load(path.string().c_str(), &mesu));
@@ -1455,26 +2618,19 @@ namespace cuvis
       cuvis_measurement_free(handle);
       delete handle;
     });
-
-    refresh();
   }
   inline Measurement::Measurement(CUVIS_MESU handle)
-      : _gps_data(std::make_shared<gps_data_t>()),
-        _string_data(std::make_shared<string_data_t>()),
-        _image_data(std::make_shared<image_data_t>()),
-        _sensor_info(std::make_shared<sensor_info_data_t>()),
-        _mesu(std::shared_ptr<CUVIS_MESU>(new CUVIS_MESU{handle}, [](CUVIS_MESU* handle) {
+      : _mesu(std::shared_ptr<CUVIS_MESU>(new CUVIS_MESU{handle}, [](CUVIS_MESU* handle) {
           cuvis_measurement_free(handle);
           delete handle;
-        }))
-  {
-    refresh();
-  }
+        })),
+        _cache(std::make_shared<cache_t>())
+  {}
 
   inline void Measurement::save(SaveArgs const& args)
   {
     chk(cuvis_measurement_save(*_mesu, args.export_dir.string().c_str(), args));
-    refresh();
+    invalidate(cache_meta);
   }
 
 
@@ -1482,175 +2638,427 @@ namespace cuvis
   inline void Measurement::set_name(std::string const& name)
   {
     chk(cuvis_measurement_set_name(*_mesu, name.c_str()));
-    refresh();
+    invalidate(cache_meta);
   }
 
   inline void Measurement::set_comment(std::string const& comment)
   {
     chk(cuvis_measurement_set_comment(*_mesu, comment.c_str()));
-    refresh();
+    invalidate(cache_meta);
   }
 
   inline void Measurement::clear_cube()
   {
     chk(cuvis_measurement_clear_cube(*_mesu));
-    refresh();
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      _cache->reduced_cube.reset();
+    }
+    invalidate(cache_meta | cache_image);
   }
 
-
-  inline void Measurement::clear_implicit_reference(reference_type_t type)
+  inline std::shared_ptr<Measurement::image_variant_t const> Measurement::reduced_cube() const
   {
-    chk(cuvis_measurement_clear_implicit_reference(*_mesu, type));
-    refresh();
+    std::lock_guard<std::mutex> lock(_cache->mutex);
+    return _cache->reduced_cube;
   }
 
-  inline void Measurement::refresh()
+  template <typename data_t>
+  inline image_t<data_t> Measurement::reduce_image(image_t<data_t> const& image, std::vector<std::size_t> const& channels, cube_region_t const& region)
   {
-    mesu_metadata_t meta;
-    chk(cuvis_measurement_get_metadata(*_mesu, &meta));
-    _meta = std::make_shared<cuvis::MeasurementMetaData>(meta);
+    if (region.width == 0 || region.height == 0 || region.x + region.width > image._width || region.y + region.height > image._height)
+    {
+      throw std::runtime_error("cube region out of range");
+    }
+    for (auto channel : channels)
+    {
+      if (channel >= image._channels)
+      {
+        throw std::runtime_error("cube channel out of range");
+      }
+    }
+    std::size_t const channel_count = channels.empty() ? image._channels : channels.size();
+
+    struct buffer_t
+    {
+      std::vector<data_t> data;
+      std::vector<std::uint32_t> wavelength;
+    };
+    auto buffer = std::make_shared<buffer_t>();
+    buffer->data.resize(region.width * region.height * channel_count);
+
+    data_t* out = buffer->data.data();
+    for (std::size_t y = region.y; y < region.y + region.height; y++)
+    {
+      data_t const* in = image._data + (y * image._width + region.x) * image._channels;
+      if (channels.empty())
+      {
+        // whole pixels, the row of the region is contiguous
+        out = std::copy(in, in + region.width * image._channels, out);
+        continue;
+      }
+      for (std::size_t x = 0; x < region.width; x++, in += image._channels)
+      {
+        for (auto channel : channels)
+        {
+          *out++ = in[channel];
+        }
+      }
+    }
 
-    auto get_flag = [&](CUVIS_FLAGS flag, std::string const& key) -> void {
-      if (meta.measurement_flags & flag)
+    if (image._wavelength != nullptr)
+    {
+      if (channels.empty())
+      {
+        buffer->wavelength.assign(image._wavelength, image._wavelength + image._channels);
+      }
+      else
       {
-        CUVIS_SIZE buffer_length;
-        chk(cuvis_measurement_get_data_string_length(*_mesu, key.c_str(), &buffer_length));
+        for (auto channel : channels)
+        {
+          buffer->wavelength.push_back(image._wavelength[channel]);
+        }
+      }
+    }
+
+    image_t<data_t> reduced({});
+    reduced._width = region.width;
+    reduced._height = region.height;
+    reduced._channels = channel_count;
+    reduced._data = buffer->data.data();
+    reduced._wavelength = image._wavelength != nullptr ? buffer->wavelength.data() : nullptr;
+    reduced._ref = std::move(buffer);
+    return reduced;
+  }
 
-        CUVIS_CHAR* value = new CUVIS_CHAR[buffer_length];
-        chk(cuvis_measurement_get_data_string(*_mesu, key.c_str(), buffer_length, value));
-        //_string_data->emplace(std::string(key), std::string(value));
+  inline void Measurement::reduce_cube(std::vector<std::size_t> const& channels, std::optional<cube_region_t> const& region, bool discard_full_cube)
+  {
+    image_variant_t const* cube = find_image(data_key_t(CUVIS_MESU_CUBE_KEY));
+    if (cube == nullptr)
+    {
+      throw std::runtime_error("measurement has no cube");
+    }
+    auto reduced = std::visit(
+        [&](auto const& image) {
+          cube_region_t const whole{0, 0, image._width, image._height};
+          return std::make_shared<image_variant_t const>(reduce_image(image, channels, region.value_or(whole)));
+        },
+        *cube);
+
+    if (discard_full_cube)
+    {
+      // the SDK cube is released, once the reduced copy exists
+      chk(cuvis_measurement_clear_cube(*_mesu));
+    }
+    {
+      std::lock_guard<std::mutex> lock(_cache->mutex);
+      _cache->reduced_cube = std::move(reduced);
+    }
+    invalidate(cache_meta | cache_image);
+  }
 
 
+  inline void Measurement::clear_implicit_reference(reference_type_t type)
+  {
+    chk(cuvis_measurement_clear_implicit_reference(*_mesu, type));
+    invalidate(cache_meta);
+  }
 
+  inline void Measurement::refresh() { invalidate(cache_all); }
 
-        //CUVIS_CHAR value[CUVIS_MAXBUF];
-        //chk(cuvis_measurement_get_data_string(*_mesu, key.c_str(), CUVIS_MAXBUF, value));
-        _meta->measurement_flags.emplace(key, value);
-        
-        delete[] value;
-      }
+  inline void Measurement::cache_t::clear(unsigned categories)
+  {
+    if (categories & cache_gps)
+    {
+      gps_data.clear();
+    }
+    if (categories & cache_sensor_info)
+    {
+      sensor_info.clear();
+    }
+    if (categories & cache_string)
+    {
+      string_data.clear();
+    }
+    if (categories & cache_image)
+    {
+      // keeps the capacity of the table for the next fetch
+      image_table.clear();
+      preview_image.reset();
+    }
+    if (categories & cache_image_map)
+    {
+      image_data.clear();
+    }
+  }
+
+  inline void Measurement::invalidate(unsigned categories)
+  {
+    if (categories & cache_image)
+    {
+      // the map is built from the table
+      categories |= cache_image_map;
+    }
+    std::lock_guard<std::mutex> lock(_cache->mutex);
+    _cache->dirty |= categories;
+    // the image data points to SDK memory, which may already be released
+    _cache->clear(categories);
+  }
+
+  inline Measurement::cache_t& Measurement::fetch(unsigned categories) const
+  {
+    cache_t& cache = *_cache;
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    unsigned const pending = cache.dirty & categories;
+    if (pending == 0)
+    {
+      return cache;
+    }
+
+    auto read_string = [&](char const* key) -> char const* {
+      CUVIS_SIZE buffer_length;
+      chk(cuvis_measurement_get_data_string_length(*_mesu, key, &buffer_length));
+      cache.buffer.resize(std::max<CUVIS_SIZE>(buffer_length, 1));
+      chk(cuvis_measurement_get_data_string(*_mesu, key, buffer_length, cache.buffer.data()));
+      return cache.buffer.c_str();
     };
 
-    get_flag(CUVIS_MESU_FLAG_OVERILLUMINATED, CUVIS_MESU_FLAG_OVERILLUMINATED_KEY);
-    get_flag(CUVIS_MESU_FLAG_POOR_REFERENCE, CUVIS_MESU_FLAG_POOR_REFERENCE_KEY);
-    get_flag(CUVIS_MESU_FLAG_POOR_WHITE_BALANCING, CUVIS_MESU_FLAG_POOR_WHITE_BALANCING_KEY);
-    get_flag(CUVIS_MESU_FLAG_DARK_INTTIME, CUVIS_MESU_FLAG_DARK_INTTIME_KEY);
-    get_flag(CUVIS_MESU_FLAG_DARK_TEMP, CUVIS_MESU_FLAG_DARK_TEMP_KEY);
-    get_flag(CUVIS_MESU_FLAG_WHITE_INTTIME, CUVIS_MESU_FLAG_WHITE_INTTIME_KEY);
-    get_flag(CUVIS_MESU_FLAG_WHITE_TEMP, CUVIS_MESU_FLAG_WHITE_TEMP_KEY);
-    get_flag(CUVIS_MESU_FLAG_WHITEDARK_INTTIME, CUVIS_MESU_FLAG_WHITEDARK_INTTIME_KEY);
-    get_flag(CUVIS_MESU_FLAG_WHITEDARK_TEMP, CUVIS_MESU_FLAG_WHITEDARK_TEMP_KEY);
+    // a failed query leaves the categories dirty, so start over with empty data
+    cache.clear(pending);
 
-    int_t numel;
-    chk(cuvis_measurement_get_data_count(*_mesu, &numel));
+    if (pending & cache_meta)
+    {
+      mesu_metadata_t meta;
+      chk(cuvis_measurement_get_metadata(*_mesu, &meta));
+      // updated in place, so pointers returned by get_meta stay valid
+      if (cache.meta)
+      {
+        *cache.meta = MeasurementMetaData(meta);
+      }
+      else
+      {
+        cache.meta = std::make_shared<cuvis::MeasurementMetaData>(meta);
+      }
 
-    _gps_data->clear();
-    _string_data->clear();
-    _image_data->clear();
-    _preview_image.reset();
-    _sensor_info->clear();
+      auto get_flag = [&](CUVIS_FLAGS flag, char const* key) -> void {
+        if (meta.measurement_flags & flag)
+        {
+          cache.meta->measurement_flags.emplace(key, read_string(key));
+        }
+      };
+
+      get_flag(CUVIS_MESU_FLAG_OVERILLUMINATED, CUVIS_MESU_FLAG_OVERILLUMINATED_KEY);
+      get_flag(CUVIS_MESU_FLAG_POOR_REFERENCE, CUVIS_MESU_FLAG_POOR_REFERENCE_KEY);
+      get_flag(CUVIS_MESU_FLAG_POOR_WHITE_BALANCING, CUVIS_MESU_FLAG_POOR_WHITE_BALANCING_KEY);
+      get_flag(CUVIS_MESU_FLAG_DARK_INTTIME, CUVIS_MESU_FLAG_DARK_INTTIME_KEY);
+      get_flag(CUVIS_MESU_FLAG_DARK_TEMP, CUVIS_MESU_FLAG_DARK_TEMP_KEY);
+      get_flag(CUVIS_MESU_FLAG_WHITE_INTTIME, CUVIS_MESU_FLAG_WHITE_INTTIME_KEY);
+      get_flag(CUVIS_MESU_FLAG_WHITE_TEMP, CUVIS_MESU_FLAG_WHITE_TEMP_KEY);
+      get_flag(CUVIS_MESU_FLAG_WHITEDARK_INTTIME, CUVIS_MESU_FLAG_WHITEDARK_INTTIME_KEY);
+      get_flag(CUVIS_MESU_FLAG_WHITEDARK_TEMP, CUVIS_MESU_FLAG_WHITEDARK_TEMP_KEY);
+    }
 
-    for (decltype(numel) k = decltype(numel){0}; k < numel; k++)
+    if (pending & ~unsigned(cache_meta))
     {
-      CUVIS_CHAR key[CUVIS_MAXBUF];
-      cuvis_data_type_t type;
-      chk(cuvis_measurement_get_data_info(*_mesu, key, &type, k));
+      int_t numel;
+      chk(cuvis_measurement_get_data_count(*_mesu, &numel));
 
-      switch (type)
+      for (decltype(numel) k = decltype(numel){0}; k < numel; k++)
       {
-        case cuvis_data_type_t::data_type_gps: {
-          cuvis_gps_t gps;
-          chk(cuvis_measurement_get_data_gps(*_mesu, key, &gps));
-          _gps_data->emplace(std::string(key), gps);
-        }
-        break;
-        case cuvis_data_type_t::data_type_sensor_info: {
-          sensor_info_t info;
-          chk(cuvis_measurement_get_data_sensor_info(*_mesu, key, &info));
-          _sensor_info->emplace(std::string(key), SensorInfoData(info));
-        }
-        break;
-        case cuvis_data_type_t::data_type_image: {
-          cuvis_imbuffer_t im;
-          chk(cuvis_measurement_get_data_image(*_mesu, key, &im));
-          switch (im.format)
-          {
-            case cuvis_imbuffer_format_t::imbuffer_format_uint8: {
-              image_t<std::uint8_t> image({});
-              image._width = im.width;
-              image._height = im.height;
-              image._channels = im.channels;
-              image._data = reinterpret_cast<std::uint8_t const*>(im.raw);
-              image._wavelength = im.wavelength;
-              image._ref = _mesu;
-
-              _image_data->emplace(std::string(key), image);
-              if (std::string(key) == CUVIS_MESU_PREVIEW_KEY)
-              {
-                _preview_image = std::make_shared<image_t<std::uint8_t>>(image);
-              }
-              else if (std::string(key) == CUVIS_MESU_PAN_KEY && !_preview_image)
-              {
-                _preview_image = std::make_shared<image_t<std::uint8_t>>(image);
-              }
+        CUVIS_CHAR key[CUVIS_MAXBUF];
+        cuvis_data_type_t type;
+        chk(cuvis_measurement_get_data_info(*_mesu, key, &type, k));
+
+        switch (type)
+        {
+          case cuvis_data_type_t::data_type_gps: {
+            if (!(pending & cache_gps))
+            {
+              break;
             }
-            break;
-            case cuvis_imbuffer_format_t::imbuffer_format_uint16: {
-              image_t<std::uint16_t> image({});
-              image._width = im.width;
-              image._height = im.height;
-              image._channels = im.channels;
-              image._data = reinterpret_cast<std::uint16_t const*>(im.raw);
-              image._wavelength = im.wavelength;
-              image._ref = _mesu;
-
-              _image_data->emplace(std::string(key), image);
+            cuvis_gps_t gps;
+            chk(cuvis_measurement_get_data_gps(*_mesu, key, &gps));
+            cache.gps_data.emplace(std::string(key), gps);
+          }
+          break;
+          case cuvis_data_type_t::data_type_sensor_info: {
+            if (!(pending & cache_sensor_info))
+            {
+              break;
             }
-            break;
-            case cuvis_imbuffer_format_t::imbuffer_format_uint32: {
-              image_t<std::uint32_t> image({});
-              image._width = im.width;
-              image._height = im.height;
-              image._channels = im.channels;
-              image._data = reinterpret_cast<std::uint32_t const*>(im.raw);
-              image._wavelength = im.wavelength;
-              image._ref = _mesu;
-
-              _image_data->emplace(std::string(key), image);
+            sensor_info_t info;
+            chk(cuvis_measurement_get_data_sensor_info(*_mesu, key, &info));
+            cache.sensor_info.emplace(std::string(key), SensorInfoData(info));
+          }
+          break;
+          case cuvis_data_type_t::data_type_image: {
+            if (!(pending & cache_image))
+            {
+              break;
             }
-            break;
-            case cuvis_imbuffer_format_t::imbuffer_format_float: {
-              image_t<float> image({});
-              image._width = im.width;
-              image._height = im.height;
-              image._channels = im.channels;
-              image._data = reinterpret_cast<float const*>(im.raw);
-              image._wavelength = im.wavelength;
-              image._ref = _mesu;
-
-              _image_data->emplace(std::string(key), image);
+            cuvis_imbuffer_t im;
+            chk(cuvis_measurement_get_data_image(*_mesu, key, &im));
+            switch (im.format)
+            {
+              case cuvis_imbuffer_format_t::imbuffer_format_uint8: {
+                auto const image = make_image<std::uint8_t>(im);
+                cache.image_table.push_back(image_entry_t{data_key_t(key), image});
+                if (std::strcmp(key, CUVIS_MESU_PREVIEW_KEY) == 0)
+                {
+                  cache.preview_image = std::make_shared<image_t<std::uint8_t>>(image);
+                }
+                else if (std::strcmp(key, CUVIS_MESU_PAN_KEY) == 0 && !cache.preview_image)
+                {
+                  cache.preview_image = std::make_shared<image_t<std::uint8_t>>(image);
+                }
+              }
+              break;
+              case cuvis_imbuffer_format_t::imbuffer_format_uint16:
+                cache.image_table.push_back(image_entry_t{data_key_t(key), make_image<std::uint16_t>(im)});
+                break;
+              case cuvis_imbuffer_format_t::imbuffer_format_uint32:
+                cache.image_table.push_back(image_entry_t{data_key_t(key), make_image<std::uint32_t>(im)});
+                break;
+              case cuvis_imbuffer_format_t::imbuffer_format_float:
+                cache.image_table.push_back(image_entry_t{data_key_t(key), make_image<float>(im)});
+                break;
+              default: //unknown or unsupported
+                throw std::runtime_error("unsupported measurement data bit depth");
+                break;
             }
-            break;
-            default: //unknown or unsupported
-              throw std::runtime_error("unsupported measurement data bit depth");
+          }
+          break;
+          case cuvis_data_type_t::data_type_string: {
+            if (!(pending & cache_string))
+            {
               break;
+            }
+            cache.string_data.emplace(std::string(key), read_string(key));
           }
+          break;
+          default: // unknown or unsupported
+            break;
         }
-        break;
-        case cuvis_data_type_t::data_type_string: {
-          CUVIS_SIZE buffer_length;
-          chk(cuvis_measurement_get_data_string_length(*_mesu, key, &buffer_length));
-
-          CUVIS_CHAR* value = new CUVIS_CHAR[buffer_length];
-          chk(cuvis_measurement_get_data_string(*_mesu, key, buffer_length, value));
-          _string_data->emplace(std::string(key), std::string(value));
-          delete[] value;
+      }
+    }
+
+    if ((pending & cache_image) && cache.reduced_cube)
+    {
+      data_key_t const cube_key(CUVIS_MESU_CUBE_KEY);
+      auto cube = std::find_if(cache.image_table.begin(), cache.image_table.end(), [&](image_entry_t const& entry) { return entry.key == cube_key; });
+      if (cube != cache.image_table.end())
+      {
+        cube->image = *cache.reduced_cube;
+      }
+      else
+      {
+        cache.image_table.push_back(image_entry_t{cube_key, *cache.reduced_cube});
+      }
+    }
+
+    if (pending & cache_image_map)
+    {
+      for (auto const& entry : cache.image_table)
+      {
+        cache.image_data.emplace(entry.key.name(), entry.image);
+      }
+    }
+
+    cache.dirty &= ~pending;
+    return cache;
+  }
+
+  template <typename data_t>
+  inline image_t<data_t> Measurement::make_image(cuvis_imbuffer_t const& im) const
+  {
+    image_t<data_t> image({});
+    image._width = im.width;
+    image._height = im.height;
+    image._channels = im.channels;
+    image._data = reinterpret_cast<data_t const*>(im.raw);
+    image._wavelength = im.wavelength;
+    image._ref = _mesu;
+    return image;
+  }
+
+  template <typename data_t>
+  inline constexpr cuvis_imbuffer_format_t Measurement::image_format()
+  {
+    static_assert(is_supported_image_data_t<data_t>::value, "data_t must be std::uint8_t, std::uint16_t, std::uint32_t or float");
+    if constexpr (std::is_same<data_t, std::uint8_t>::value)
+    {
+      return cuvis_imbuffer_format_t::imbuffer_format_uint8;
+    }
+    else if constexpr (std::is_same<data_t, std::uint16_t>::value)
+    {
+      return cuvis_imbuffer_format_t::imbuffer_format_uint16;
+    }
+    else if constexpr (std::is_same<data_t, std::uint32_t>::value)
+    {
+      return cuvis_imbuffer_format_t::imbuffer_format_uint32;
+    }
+    else
+    {
+      return cuvis_imbuffer_format_t::imbuffer_format_float;
+    }
+  }
+
+  template <typename data_t>
+  inline std::optional<image_t<data_t>> Measurement::get_image(char const* key) const
+  {
+    if (std::strcmp(key, CUVIS_MESU_CUBE_KEY) == 0)
+    {
+      if (auto reduced = reduced_cube())
+      {
+        if (!std::holds_alternative<image_t<data_t>>(*reduced))
+        {
+          throw std::runtime_error("measurement image has a different bit depth");
         }
-        break;
-        default: // unknown or unsupported
-          break;
+        return std::get<image_t<data_t>>(*reduced);
+      }
+    }
+    cuvis_imbuffer_t im;
+    CUVIS_STATUS const status = cuvis_measurement_get_data_image(*_mesu, key, &im);
+    if (status == status_not_available)
+    {
+      return std::nullopt;
+    }
+    chk(status);
+    if (im.format != image_format<data_t>())
+    {
+      throw std::runtime_error("measurement image has a different bit depth");
+    }
+    return make_image<data_t>(im);
+  }
+
+  template <typename data_t>
+  inline std::optional<image_t<data_t>> Measurement::cube() const
+  {
+    return get_image<data_t>(CUVIS_MESU_CUBE_KEY);
+  }
+
+  inline std::optional<image_t<std::uint8_t>> Measurement::preview() const
+  {
+    auto image = get_image<std::uint8_t>(CUVIS_MESU_PREVIEW_KEY);
+    if (!image)
+    {
+      image = get_image<std::uint8_t>(CUVIS_MESU_PAN_KEY);
+    }
+    return image;
+  }
+
+  inline Measurement::image_table_t const* Measurement::get_image_table() const { return &fetch(cache_image).image_table; }
+
+  inline Measurement::image_variant_t const* Measurement::find_image(data_key_t const& key) const
+  {
+    for (auto const& entry : fetch(cache_image).image_table)
+    {
+      if (entry.key == key)
+      {
+        return &entry.image;
       }
     }
+    return nullptr;
   }
 
   inline std::vector<capabilities_t> Measurement::get_capabilities() const
@@ -1714,11 +3122,17 @@ namespace cuvis
     return CalibrationInfo(info);
   }
 
-  inline image_t<std::uint8_t> const* Measurement::get_thumbnail() const { return _preview_image.get(); }
+  inline image_t<std::uint8_t> const* Measurement::get_thumbnail() const { return fetch(cache_image).preview_image.get(); }
+
+  inline MeasurementMetaData const* Measurement::get_meta() const { return fetch(cache_meta).meta.get(); }
+
+  inline cuvis::Measurement::sensor_info_data_t const* Measurement::get_sensor_info() const { return &fetch(cache_sensor_info).sensor_info; }
+
+  inline cuvis::Measurement::gps_data_t const* Measurement::get_gps() const { return &fetch(cache_gps).gps_data; }
 
-  inline MeasurementMetaData const* Measurement::get_meta() const { return _meta.get(); }
+  inline cuvis::Measurement::image_data_t const* Measurement::get_imdata() const { return &fetch(cache_image | cache_image_map).image_data; }
 
-  inline cuvis::Measurement::sensor_info_data_t const* Measurement::get_sensor_info() const { return _sensor_info.get(); }
+  inline cuvis::Measurement::string_data_t const* Measurement::get_strdata() const { return &fetch(cache_string).string_data; }
 
   inline Calibration::Calibration(std::filesystem::path const& path)
   {
@@ -1741,52 +3155,386 @@ namespace cuvis
       delete handle;
     });
   }
-  inline ProcessingContext::ProcessingContext(Calibration const& calib)
+  inline std::size_t LatencyHistogram::bucket_of(std::uint64_t value)
   {
-    CUVIS_PROC_CONT procCont;
-    chk(cuvis_proc_cont_create_from_calib(*calib._calib, &procCont));
-    _procCont = std::shared_ptr<CUVIS_PROC_CONT>(new CUVIS_PROC_CONT{procCont}, [](CUVIS_PROC_CONT* handle) {
-      cuvis_proc_cont_free(handle);
-      delete handle;
-    });
+    if (value < sub_buckets)
+    {
+      return std::size_t(value);
+    }
+    // position of the highest set bit, at least 3
+    std::size_t exponent = 0;
+    for (std::uint64_t v = value; v > 1; v >>= 1)
+    {
+      exponent++;
+    }
+    std::size_t const shift = exponent - 3;
+    return (shift + 1) * sub_buckets + std::size_t((value >> shift) - sub_buckets);
   }
 
-  inline ProcessingContext::ProcessingContext(Measurement const& mesu)
+  inline std::uint64_t LatencyHistogram::bucket_lower_bound(std::size_t bucket)
   {
-    CUVIS_PROC_CONT procCont;
-    chk(cuvis_proc_cont_create_from_mesu(*mesu._mesu, &procCont));
-    _procCont = std::shared_ptr<CUVIS_PROC_CONT>(new CUVIS_PROC_CONT{procCont}, [](CUVIS_PROC_CONT* handle) {
-      cuvis_proc_cont_free(handle);
-      delete handle;
-    });
+    if (bucket < sub_buckets)
+    {
+      return bucket;
+    }
+    std::size_t const shift = bucket / sub_buckets - 1;
+    return (sub_buckets + bucket % sub_buckets) << shift;
   }
 
-  inline ProcessingContext::ProcessingContext(SessionFile const& session)
+  inline void LatencyHistogram::record(std::chrono::nanoseconds latency)
   {
-    CUVIS_PROC_CONT procCont;
-    chk(cuvis_proc_cont_create_from_session_file(*session._session, &procCont));
-    _procCont = std::shared_ptr<CUVIS_PROC_CONT>(new CUVIS_PROC_CONT{procCont}, [](CUVIS_PROC_CONT* handle) {
-      cuvis_proc_cont_free(handle);
-      delete handle;
-    });
-  }
+    std::uint64_t const value = std::uint64_t(std::max<std::chrono::nanoseconds::rep>(latency.count(), 0));
+    _buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
 
-  inline Measurement& ProcessingContext::apply(Measurement& mesu) const
-  {
-    chk(cuvis_proc_cont_apply(*_procCont, *mesu._mesu));
-    mesu.refresh();
-    return mesu;
+    std::uint64_t current = _min.load(std::memory_order_relaxed);
+    while (value < current && !_min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {}
+    current = _max.load(std::memory_order_relaxed);
+    while (value > current && !_max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {}
   }
 
-  inline void ProcessingContext::set_reference(Measurement const& mesu, reference_type_t type)
+  inline LatencyHistogram::snapshot_t LatencyHistogram::snapshot(bool reset)
   {
-    chk(cuvis_proc_cont_set_reference(*_procCont, *mesu._mesu, type));
-    return;
+    // values recorded meanwhile may be counted partially, the snapshot is not atomic as a whole
+    snapshot_t snapshot;
+    for (std::size_t bucket = 0; bucket < bucket_count; bucket++)
+    {
+      snapshot.buckets[bucket] = reset ? _buckets[bucket].exchange(0, std::memory_order_relaxed) : _buckets[bucket].load(std::memory_order_relaxed);
+    }
+    snapshot.count = reset ? _count.exchange(0, std::memory_order_relaxed) : _count.load(std::memory_order_relaxed);
+    snapshot.sum = std::chrono::nanoseconds(reset ? _sum.exchange(0, std::memory_order_relaxed) : _sum.load(std::memory_order_relaxed));
+    std::uint64_t const min = reset ? _min.exchange(UINT64_MAX, std::memory_order_relaxed) : _min.load(std::memory_order_relaxed);
+    std::uint64_t const max = reset ? _max.exchange(0, std::memory_order_relaxed) : _max.load(std::memory_order_relaxed);
+    if (snapshot.count > 0)
+    {
+      snapshot.min = std::chrono::nanoseconds(min);
+      snapshot.max = std::chrono::nanoseconds(max);
+    }
+    return snapshot;
   }
-  inline void ProcessingContext::clear_reference(reference_type_t type)
+
+  inline std::chrono::nanoseconds LatencyHistogram::snapshot_t::mean() const
   {
-    chk(cuvis_proc_cont_clear_reference(*_procCont, type));
-    return;
+    return count > 0 ? std::chrono::nanoseconds(sum.count() / std::chrono::nanoseconds::rep(count)) : std::chrono::nanoseconds(0);
+  }
+
+  inline std::chrono::nanoseconds LatencyHistogram::snapshot_t::percentile(double fraction) const
+  {
+    std::uint64_t total = 0;
+    for (auto bucketCount : buckets)
+    {
+      total += bucketCount;
+    }
+    if (total == 0)
+    {
+      return std::chrono::nanoseconds(0);
+    }
+    fraction = std::min(std::max(fraction, 0.0), 1.0);
+    std::uint64_t const rank = std::max<std::uint64_t>(std::uint64_t(fraction * double(total) + 0.5), 1);
+
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < bucket_count; bucket++)
+    {
+      seen += buckets[bucket];
+      if (seen >= rank)
+      {
+        // the largest value of the bucket, limited to the recorded range
+        std::uint64_t const upper = bucket + 1 < bucket_count ? bucket_lower_bound(bucket + 1) - 1 : UINT64_MAX;
+        return std::min(std::max(std::chrono::nanoseconds(std::chrono::nanoseconds::rep(std::min<std::uint64_t>(upper, INT64_MAX))), min), max);
+      }
+    }
+    return max;
+  }
+
+  inline double Instrumentation::snapshot_t::results_per_second() const
+  {
+    return period.count() > 0 ? double(counters.results) * 1e9 / double(period.count()) : 0.0;
+  }
+
+  inline Instrumentation::~Instrumentation() { reset_snapshot_callback(); }
+
+  inline void Instrumentation::record(stage_t stage, std::chrono::nanoseconds latency) { _stages[std::size_t(stage)].record(latency); }
+
+  inline void Instrumentation::record_result(std::optional<std::uint64_t> frame_id, bool error)
+  {
+    _results.fetch_add(1, std::memory_order_relaxed);
+    if (error)
+    {
+      _errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (frame_id.has_value())
+    {
+      std::uint64_t const last = _last_frame_id.exchange(*frame_id, std::memory_order_relaxed);
+      // a restarted acquisition counts from the beginning, this is not a gap
+      if (last != UINT64_MAX && *frame_id > last + 1)
+      {
+        _frame_gaps.fetch_add(*frame_id - last - 1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  inline Instrumentation::snapshot_t Instrumentation::snapshot(bool reset)
+  {
+    snapshot_t snapshot;
+    snapshot.time = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(_period_mutex);
+      snapshot.period = std::chrono::duration_cast<std::chrono::nanoseconds>(snapshot.time - _period_start);
+      if (reset)
+      {
+        _period_start = snapshot.time;
+      }
+    }
+    for (std::size_t stage = 0; stage < stage_count; stage++)
+    {
+      snapshot.stages[stage] = _stages[stage].snapshot(reset);
+    }
+    snapshot.counters.results = reset ? _results.exchange(0, std::memory_order_relaxed) : _results.load(std::memory_order_relaxed);
+    snapshot.counters.errors = reset ? _errors.exchange(0, std::memory_order_relaxed) : _errors.load(std::memory_order_relaxed);
+    snapshot.counters.frame_gaps = reset ? _frame_gaps.exchange(0, std::memory_order_relaxed) : _frame_gaps.load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+  inline void Instrumentation::reset()
+  {
+    snapshot(true);
+    _last_frame_id = UINT64_MAX;
+  }
+
+  inline void Instrumentation::set_snapshot_callback(std::function<void(snapshot_t const&)> callback, std::chrono::milliseconds interval, bool reset)
+  {
+    reset_snapshot_callback();
+
+    if (interval.count() <= 0)
+    {
+      throw std::runtime_error("snapshot interval must be positive");
+    }
+
+    _snapshot_run = true;
+    _snapshot_thread = std::thread([this, callback = std::move(callback), interval, reset] {
+      auto next = std::chrono::steady_clock::now() + interval;
+      while (true)
+      {
+        {
+          std::unique_lock<std::mutex> lock(_snapshot_mutex);
+          if (_snapshot_wake.wait_until(lock, next, [this] { return !_snapshot_run; }))
+          {
+            return;
+          }
+        }
+        next += interval;
+        try
+        {
+          callback(snapshot(reset));
+        }
+        catch (...)
+        {}
+      }
+    });
+  }
+
+  inline void Instrumentation::reset_snapshot_callback()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_snapshot_mutex);
+      _snapshot_run = false;
+    }
+    _snapshot_wake.notify_all();
+    if (_snapshot_thread.joinable())
+    {
+      _snapshot_thread.join();
+    }
+  }
+
+  /** @cond INTERNAL */
+  namespace instrumentation_impl
+  {
+    /* records the lifetime of the timer as a stage, if instrumented */
+    class stage_timer_t
+    {
+    public:
+      stage_timer_t(Instrumentation* instrumentation, Instrumentation::stage_t stage)
+          : _instrumentation(instrumentation), _stage(stage), _begin(instrumentation ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+      {}
+
+      ~stage_timer_t()
+      {
+        if (_instrumentation)
+        {
+          _instrumentation->record(_stage, std::chrono::steady_clock::now() - _begin);
+        }
+      }
+
+      stage_timer_t(stage_timer_t const&) = delete;
+      stage_timer_t& operator=(stage_timer_t const&) = delete;
+
+    private:
+      Instrumentation* _instrumentation;
+      Instrumentation::stage_t _stage;
+      std::chrono::steady_clock::time_point _begin;
+    };
+  } // namespace instrumentation_impl
+  /** @endcond */
+
+  inline ProcessingContext::factory_t ProcessingContext::make_factory(Calibration const& calib)
+  {
+    return [calib = calib._calib]() {
+      CUVIS_PROC_CONT procCont;
+      chk(cuvis_proc_cont_create_from_calib(*calib, &procCont));
+      return procCont;
+    };
+  }
+
+  inline ProcessingContext::factory_t ProcessingContext::make_factory(Measurement const& mesu)
+  {
+    return [mesu = mesu._mesu]() {
+      CUVIS_PROC_CONT procCont;
+      chk(cuvis_proc_cont_create_from_mesu(*mesu, &procCont));
+      return procCont;
+    };
+  }
+
+  inline ProcessingContext::factory_t ProcessingContext::make_factory(SessionFile const& session)
+  {
+    return [session = session._session]() {
+      CUVIS_PROC_CONT procCont;
+      chk(cuvis_proc_cont_create_from_session_file(*session, &procCont));
+      return procCont;
+    };
+  }
+
+  inline ProcessingContext::ProcessingContext(Calibration const& calib)
+  {
+    factory_t factory = make_factory(calib);
+    CUVIS_PROC_CONT const procCont = factory();
+    init(procCont, std::move(factory));
+  }
+
+  // the measurement and the session file are not kept, their cubes would stay in memory
+  inline ProcessingContext::ProcessingContext(Measurement const& mesu) { init(make_factory(mesu)(), nullptr); }
+
+  inline ProcessingContext::ProcessingContext(SessionFile const& session) { init(make_factory(session)(), nullptr); }
+
+  inline void ProcessingContext::init(CUVIS_PROC_CONT procCont, factory_t factory)
+  {
+    _factory = std::move(factory);
+    _procCont = std::shared_ptr<CUVIS_PROC_CONT>(new CUVIS_PROC_CONT{procCont}, [](CUVIS_PROC_CONT* handle) {
+      cuvis_proc_cont_free(handle);
+      delete handle;
+    });
+    _profiles.push_back(reference_profile_t{"default", _procCont});
+  }
+
+  inline std::size_t ProcessingContext::add_reference_profile(std::string const& name, reference_set_t const& references)
+  {
+    if (!_factory)
+    {
+      throw std::runtime_error("reference profile requires the source of the processing context");
+    }
+    return add_profile(name, references, _factory);
+  }
+
+  inline std::size_t ProcessingContext::add_reference_profile(std::string const& name, reference_set_t const& references, Measurement const& source)
+  {
+    return add_profile(name, references, make_factory(source));
+  }
+
+  inline std::size_t ProcessingContext::add_reference_profile(std::string const& name, reference_set_t const& references, SessionFile const& source)
+  {
+    return add_profile(name, references, make_factory(source));
+  }
+
+  inline std::size_t ProcessingContext::add_profile(std::string const& name, reference_set_t const& references, factory_t const& factory)
+  {
+    for (auto const& profile : _profiles)
+    {
+      if (profile.name == name)
+      {
+        throw std::runtime_error("reference profile already exists");
+      }
+    }
+
+    auto procCont = std::shared_ptr<CUVIS_PROC_CONT>(new CUVIS_PROC_CONT{factory()}, [](CUVIS_PROC_CONT* handle) {
+      cuvis_proc_cont_free(handle);
+      delete handle;
+    });
+    chk(cuvis_proc_cont_set_args(*procCont, _procArgs));
+    for (auto const& reference : references)
+    {
+      chk(cuvis_proc_cont_set_reference(*procCont, *reference.second->_mesu, reference.first));
+    }
+
+    _profiles.push_back(reference_profile_t{name, std::move(procCont)});
+    return _profiles.size() - 1;
+  }
+
+  inline void ProcessingContext::activate_reference_profile(std::size_t index)
+  {
+    if (index >= _profiles.size())
+    {
+      throw std::runtime_error("unknown reference profile");
+    }
+    _procCont = _profiles[index].procCont;
+    _activeProfile = index;
+  }
+
+  inline void ProcessingContext::activate_reference_profile(std::string const& name)
+  {
+    for (std::size_t index = 0; index < _profiles.size(); index++)
+    {
+      if (_profiles[index].name == name)
+      {
+        activate_reference_profile(index);
+        return;
+      }
+    }
+    throw std::runtime_error("unknown reference profile");
+  }
+
+  inline std::size_t ProcessingContext::get_active_reference_profile() const { return _activeProfile; }
+
+  inline std::vector<std::string> ProcessingContext::get_reference_profiles() const
+  {
+    std::vector<std::string> names;
+    names.reserve(_profiles.size());
+    for (auto const& profile : _profiles)
+    {
+      names.push_back(profile.name);
+    }
+    return names;
+  }
+
+  inline void ProcessingContext::set_instrumentation(std::shared_ptr<Instrumentation> instrumentation) { _instrumentation = std::move(instrumentation); }
+
+  inline Measurement& ProcessingContext::apply(Measurement& mesu) const
+  {
+    instrumentation_impl::stage_timer_t timer(_instrumentation.get(), Instrumentation::stage_t::processing);
+    chk(cuvis_proc_cont_apply(*_procCont, *mesu._mesu));
+    {
+      // a new cube replaces the previous reduction
+      std::lock_guard<std::mutex> lock(mesu._cache->mutex);
+      mesu._cache->reduced_cube.reset();
+    }
+    mesu.refresh();
+    if (!_procArgs.channel_subset.empty() || _procArgs.region.has_value())
+    {
+      mesu.reduce_cube(_procArgs.channel_subset, _procArgs.region, _procArgs.discard_full_cube);
+    }
+    return mesu;
+  }
+
+  inline void ProcessingContext::set_reference(Measurement const& mesu, reference_type_t type)
+  {
+    chk(cuvis_proc_cont_set_reference(*_procCont, *mesu._mesu, type));
+    return;
+  }
+  inline void ProcessingContext::clear_reference(reference_type_t type)
+  {
+    chk(cuvis_proc_cont_clear_reference(*_procCont, type));
+    return;
   }
 
   inline std::optional<Measurement> ProcessingContext::get_reference(reference_type_t type) const
@@ -1834,7 +3582,10 @@ namespace cuvis
   inline void ProcessingContext::set_processingArgs(ProcessingArgs const& procArgs)
   {
     _procArgs = procArgs;
-    chk(cuvis_proc_cont_set_args(*_procCont, _procArgs));
+    for (auto const& profile : _profiles)
+    {
+      chk(cuvis_proc_cont_set_args(*profile.procCont, _procArgs));
+    }
   }
 
   inline ProcessingArgs const& ProcessingContext::get_processingArgs() const { return _procArgs; }
@@ -2003,7 +3754,25 @@ namespace cuvis
       except = std::current_exception();
     }
 
-    return {std::move(mesu), view, except};
+    worker_return_t result{std::move(mesu), view, except, std::chrono::steady_clock::now(), {}};
+    // a timeout returns no measurement and is not counted
+    std::shared_ptr<Instrumentation> const instrumentation = result.mesu.has_value() ? get_instrumentation() : nullptr;
+    if (instrumentation)
+    {
+      std::optional<std::uint64_t> frame_id;
+      try
+      {
+        MeasurementMetaData const* meta = result.mesu->get_meta();
+        frame_id = meta->frame_id;
+        instrumentation->record(Instrumentation::stage_t::capture_to_result, std::chrono::system_clock::now() - meta->capture_time);
+      }
+      catch (...)
+      {
+        // the statistics must not fail the result
+      }
+      instrumentation->record_result(frame_id, result.exception != nullptr);
+    }
+    return result;
   }
 
   inline void Worker::ingest_measurement(Measurement const* measurement) { chk(cuvis_worker_ingest_mesu(*_worker, *measurement->_mesu)); }
@@ -2053,80 +3822,361 @@ namespace cuvis
   }
 
 
-  inline void Worker::register_worker_callback(worker_callback_t callback, unsigned concurrency)
+  namespace worker_impl
   {
-    reset_worker_callback();
+    inline void invoke(Worker::worker_callback_t const& callback,
+                       std::function<void(std::exception_ptr)> const& error_callback,
+                       Instrumentation* instrumentation,
+                       Worker::worker_return_t&& result)
+    {
+      result.delivered_time = std::chrono::steady_clock::now();
+      if (instrumentation)
+      {
+        instrumentation->record(Instrumentation::stage_t::callback_queue, result.delivered_time - result.received_time);
+      }
+      instrumentation_impl::stage_timer_t timer(instrumentation, Instrumentation::stage_t::callback);
+      try
+      {
+        callback(std::move(result));
+      }
+      catch (...)
+      {
+        if (error_callback)
+        {
+          try
+          {
+            error_callback(std::current_exception());
+          }
+          catch (...)
+          {}
+        }
+      }
+    }
+
+    class callback_pool_t
+    {
+    public:
+      callback_pool_t(Worker::worker_callback_t callback, Worker::callback_args_t const& args)
+          : _callback(std::move(callback)),
+            _error_callback(args.error_callback),
+            _order(args.order),
+            _capacity(std::max<std::size_t>(args.queue_size > 0 ? args.queue_size : args.concurrency, 1)),
+            _done(_capacity, 0)
+      {
+        unsigned const thread_count = std::max(args.concurrency, 1u);
+        _threads.reserve(thread_count);
+        for (unsigned k = 0; k < thread_count; k++)
+        {
+          _threads.emplace_back(&callback_pool_t::run, this);
+        }
+      }
 
-    static const std::chrono::milliseconds poll_time = std::chrono::milliseconds(1);
+      ~callback_pool_t()
+      {
+        stop();
+        for (auto& thread : _threads)
+        {
+          thread.join();
+        }
+      }
 
-    _worker_poll_thread_run = true;
+      callback_pool_t(callback_pool_t const&) = delete;
+      callback_pool_t& operator=(callback_pool_t const&) = delete;
 
-    _worker_poll_thread = std::thread([this, callback, concurrency] {
-      std::deque<std::future<void>> async_tasks;
-      while (_worker_poll_thread_run.load())
+      /* blocks while the queue is full, returns false if the pool was stopped
+         the result is recorded by the given instrumentation */
+      bool push(Worker::worker_return_t&& result, std::shared_ptr<Instrumentation> instrumentation)
       {
-        auto ret = get_next_result(std::chrono::milliseconds(1000));
+        std::unique_lock<std::mutex> lock(_mutex);
+        _not_full.wait(lock, [this] { return _stop || has_room(); });
+        if (_stop)
+        {
+          return false;
+        }
+        _queue.push_back(task_t{_next_seq++, std::move(result), std::move(instrumentation)});
+        _not_empty.notify_one();
+        return true;
+      }
 
-        if (ret.mesu.has_value())
+      /* wakes all waiting threads, queued results are dropped */
+      void stop()
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _stop = true;
+          _queue.clear();
+        }
+        _not_empty.notify_all();
+        _not_full.notify_all();
+      }
+
+    private:
+      struct task_t
+      {
+        std::uint64_t seq;
+        Worker::worker_return_t result;
+        std::shared_ptr<Instrumentation> instrumentation;
+      };
+
+      bool has_room() const
+      {
+        if (_order == Worker::callback_order_t::in_order)
         {
-          async_tasks.push_back(std::async(std::launch::async, callback, std::move(ret)));
+          return _next_seq - _retired < _capacity;
+        }
+        return _queue.size() < _capacity;
+      }
 
-          if (async_tasks.size() >= concurrency)
+      void run()
+      {
+        while (true)
+        {
+          task_t task;
           {
-            auto& res = async_tasks.front();
-            while (true)
+            std::unique_lock<std::mutex> lock(_mutex);
+            _not_empty.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_stop)
             {
-              if (res.wait_for(poll_time) == std::future_status::ready)
-              {
-                break;
-              }
-
-              if (!_worker_poll_thread_run.load())
-              {
-                return;
-              }
+              return;
             }
-            try
+            task = std::move(_queue.front());
+            _queue.pop_front();
+            if (_order == Worker::callback_order_t::out_of_order)
             {
-              res.get();
+              _not_full.notify_one();
             }
-            catch (...)
-            {}
+          }
 
-            async_tasks.pop_front();
+          invoke(_callback, _error_callback, task.instrumentation.get(), std::move(task.result));
+          task.instrumentation.reset();
+
+          if (_order == Worker::callback_order_t::in_order)
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // retire all finished results in order, the window never exceeds the capacity
+            _done[task.seq % _capacity] = 1;
+            while (_retired < _next_seq && _done[_retired % _capacity])
+            {
+              _done[_retired % _capacity] = 0;
+              _retired++;
+            }
+            _not_full.notify_one();
           }
         }
       }
-    });
-  }
 
-  inline void Worker::reset_worker_callback()
-  {
-    _worker_poll_thread_run = false;
-    if (_worker_poll_thread.joinable())
-    {
-      _worker_poll_thread.join();
-    }
-  }
+      Worker::worker_callback_t _callback;
+      std::function<void(std::exception_ptr)> _error_callback;
+      Worker::callback_order_t _order;
+      std::size_t _capacity;
 
-  inline Viewer::Viewer(ViewArgs const& args)
+      std::mutex _mutex;
+      std::condition_variable _not_empty;
+      std::condition_variable _not_full;
+      std::deque<task_t> _queue;
+      bool _stop = false;
+
+      std::uint64_t _next_seq = 0;
+      std::uint64_t _retired = 0;
+      std::vector<char> _done;
+
+      std::vector<std::thread> _threads;
+    };
+  } // namespace worker_impl
+
+  inline Worker::~Worker() { reset_worker_callback(); }
+
+  inline void Worker::register_worker_callback(worker_callback_t callback, unsigned concurrency)
   {
-    CUVIS_VIEWER viewer;
-    chk(cuvis_viewer_create(&viewer, args));
-    _viewer = std::shared_ptr<CUVIS_VIEWER>(new CUVIS_VIEWER{viewer}, [](CUVIS_VIEWER* handle) {
-      cuvis_viewer_free(handle);
-      delete handle;
-    });
+    callback_args_t args;
+    args.concurrency = concurrency;
+    register_worker_callback(std::move(callback), args);
   }
 
-  inline Viewer::view_data_t Viewer::apply(Measurement const& mesu)
+  inline void Worker::register_worker_callback(worker_callback_t callback, callback_args_t const& args)
   {
-    CUVIS_VIEW current_view;
-    chk(cuvis_viewer_apply(*_viewer, *mesu._mesu, &current_view));
-
+    reset_worker_callback();
+
+    if (args.poll_interval.count() <= 0)
+    {
+      throw std::runtime_error("poll interval must be positive");
+    }
+
+    _worker_poll_thread_run = true;
+    if (args.deliver_inline)
+    {
+      _worker_poll_thread = std::thread([this, callback = std::move(callback), error_callback = args.error_callback, interval = args.poll_interval] {
+        while (_worker_poll_thread_run.load())
+        {
+          auto ret = get_next_result(interval);
+
+          if (ret.mesu.has_value())
+          {
+            worker_impl::invoke(callback, error_callback, get_instrumentation().get(), std::move(ret));
+          }
+        }
+      });
+      return;
+    }
+
+    _callback_pool = std::make_unique<worker_impl::callback_pool_t>(std::move(callback), args);
+    _worker_poll_thread = std::thread([this, interval = args.poll_interval] {
+      while (_worker_poll_thread_run.load())
+      {
+        auto ret = get_next_result(interval);
+
+        if (ret.mesu.has_value())
+        {
+          if (!_callback_pool->push(std::move(ret), get_instrumentation()))
+          {
+            return;
+          }
+        }
+      }
+    });
+  }
+
+  inline void Worker::reset_worker_callback()
+  {
+    _worker_poll_thread_run = false;
+    if (_callback_pool)
+    {
+      // wakes the poll thread, if it waits for room in the queue
+      _callback_pool->stop();
+    }
+    if (_worker_poll_thread.joinable())
+    {
+      _worker_poll_thread.join();
+    }
+    // joins the callback threads
+    _callback_pool.reset();
+  }
+
+  inline void Worker::set_instrumentation(std::shared_ptr<Instrumentation> instrumentation)
+  {
+    std::lock_guard<std::mutex> lock(_instrumentation_mutex);
+    _instrumentation = std::move(instrumentation);
+  }
+
+  inline std::shared_ptr<Instrumentation> Worker::get_instrumentation() const
+  {
+    std::lock_guard<std::mutex> lock(_instrumentation_mutex);
+    return _instrumentation;
+  }
+
+  inline Viewer::Viewer(ViewArgs const& args)
+  {
+    CUVIS_VIEWER viewer;
+    chk(cuvis_viewer_create(&viewer, args));
+    _viewer = std::shared_ptr<CUVIS_VIEWER>(new CUVIS_VIEWER{viewer}, [](CUVIS_VIEWER* handle) {
+      cuvis_viewer_free(handle);
+      delete handle;
+    });
+  }
+
+  inline void Viewer::set_instrumentation(std::shared_ptr<Instrumentation> instrumentation) { _instrumentation = std::move(instrumentation); }
+
+  inline Viewer::view_data_t Viewer::apply(Measurement const& mesu)
+  {
+    instrumentation_impl::stage_timer_t timer(_instrumentation.get(), Instrumentation::stage_t::viewer);
+    CUVIS_VIEW current_view;
+    chk(cuvis_viewer_apply(*_viewer, *mesu._mesu, &current_view));
+
 
     return create_view_data(current_view);
   }
+
+  inline std::size_t Viewer::apply(Measurement const& mesu, std::vector<view_target_t>& targets)
+  {
+    instrumentation_impl::stage_timer_t timer(_instrumentation.get(), Instrumentation::stage_t::viewer);
+    CUVIS_VIEW current_view;
+    chk(cuvis_viewer_apply(*_viewer, *mesu._mesu, &current_view));
+
+    // the view is freed on return, also when a copy throws
+    std::unique_ptr<CUVIS_VIEW, void (*)(CUVIS_VIEW*)> view_handle(&current_view, [](CUVIS_VIEW* handle) { cuvis_view_free(handle); });
+
+    int_t numel;
+    chk(cuvis_view_get_data_count(current_view, &numel));
+
+    std::size_t written = 0;
+    for (auto& target : targets)
+    {
+      target.written = false;
+      cuvis_view_data_t view_data;
+
+      // check the cached position first, the views of a user plugin keep their order
+      bool found = false;
+      if (target.index >= 0 && target.index < numel)
+      {
+        chk(cuvis_view_get_data(current_view, target.index, &view_data));
+        found = target.id == view_data.id;
+      }
+      for (int_t k = 0; !found && k < numel; k++)
+      {
+        chk(cuvis_view_get_data(current_view, k, &view_data));
+        if (target.id == view_data.id)
+        {
+          target.index = k;
+          found = true;
+        }
+      }
+      if (!found)
+      {
+        target.index = -1;
+        continue;
+      }
+
+      copy_view(view_data, target);
+      written++;
+    }
+    return written;
+  }
+
+  inline void Viewer::copy_view(cuvis_view_data_t const& view_data, view_target_t& target)
+  {
+    cuvis_imbuffer_t const& im = view_data.data;
+
+    std::size_t element_size;
+    switch (im.format)
+    {
+      case cuvis_imbuffer_format_t::imbuffer_format_uint8: element_size = sizeof(std::uint8_t); break;
+      case cuvis_imbuffer_format_t::imbuffer_format_float: element_size = sizeof(float); break;
+      default: //unknown or unsupported
+        throw std::runtime_error("unsupported view bit depth");
+    }
+
+    std::size_t const width = std::size_t(im.width);
+    std::size_t const height = std::size_t(im.height);
+    std::size_t const channels = std::size_t(im.channels);
+    std::size_t const row_bytes = width * channels * element_size;
+    std::size_t const stride = target.row_stride != 0 ? target.row_stride : row_bytes;
+    if (stride < row_bytes || (height > 0 && (height - 1) * stride + row_bytes > target.capacity) || (height > 0 && target.data == nullptr))
+    {
+      throw std::runtime_error("view target buffer is too small");
+    }
+
+    auto const* source = static_cast<std::uint8_t const*>(static_cast<void const*>(im.raw));
+    auto* destination = static_cast<std::uint8_t*>(target.data);
+    if (stride == row_bytes)
+    {
+      std::memcpy(destination, source, height * row_bytes);
+    }
+    else
+    {
+      for (std::size_t y = 0; y < height; y++)
+      {
+        std::memcpy(destination + y * stride, source + y * row_bytes, row_bytes);
+      }
+    }
+
+    target.width = width;
+    target.height = height;
+    target.channels = channels;
+    target.format = im.format;
+    target.category = view_data.category;
+    target.show = view_data.show != 0;
+    target.written = true;
+  }
   inline Viewer::view_data_t Viewer::create_view_data(CUVIS_VIEW current_view)
   {
     Viewer::view_data_t view_array;
@@ -2217,12 +4267,28 @@ namespace cuvis
 
 
   inline void AcquisitionContext::register_state_change_callback(state_callback_t callback, bool output_initial_state)
+  {
+    state_monitor_args_t args;
+    args.output_initial_state = output_initial_state;
+    register_state_change_callback(std::move(callback), args);
+  }
+
+  inline void AcquisitionContext::register_state_change_callback(state_callback_t callback, state_monitor_args_t const& args)
   {
     reset_state_change_callback();
 
     _state_poll_thread_run = true;
+    {
+      std::lock_guard<std::mutex> lock(_state_wake_mutex);
+      _state_wake_pending = false;
+    }
+
+    for (int_t event : args.wake_events)
+    {
+      _state_event_handlers.push_back(General::register_event_callback([this](event_t) { notify_state_change(); }, event));
+    }
 
-    _state_poll_thread = std::thread([this, callback, output_initial_state] {
+    _state_poll_thread = std::thread([this, callback, output_initial_state = args.output_initial_state, poll_interval = args.poll_interval] {
       hardware_state_t last_state = hardware_state_offline;
       std::map<int_t, component_state_info_t> last_component_states;
       for (int k = 0; k < get_component_count(); k++)
@@ -2249,113 +4315,603 @@ namespace cuvis
           auto comp_state = get_component_online(k) != 0;
           auto last_comp_state = last_component_states[k].is_online;
 
-          if (comp_state != last_comp_state)
+          if (comp_state != last_comp_state)
+          {
+            state_changed = true;
+            last_component_states[k].is_online = comp_state;
+          }
+        }
+        if (state_changed)
+          callback(last_state, last_component_states);
+        else
+        {
+          std::unique_lock<std::mutex> lock(_state_wake_mutex);
+          _state_wake.wait_for(lock, poll_interval, [this] { return _state_wake_pending || !_state_poll_thread_run.load(); });
+          _state_wake_pending = false;
+        }
+      }
+    });
+  }
+
+  inline void AcquisitionContext::notify_state_change()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_state_wake_mutex);
+      _state_wake_pending = true;
+    }
+    _state_wake.notify_all();
+  }
+
+  inline void AcquisitionContext::reset_state_change_callback()
+  {
+    for (int_t handler : _state_event_handlers)
+    {
+      General::unregister_event_callback(handler);
+    }
+    _state_event_handlers.clear();
+
+    {
+      std::lock_guard<std::mutex> lock(_state_wake_mutex);
+      _state_poll_thread_run = false;
+    }
+    _state_wake.notify_all();
+
+    if (_state_poll_thread.joinable())
+    {
+      _state_poll_thread.join();
+    }
+  }
+
+
+  inline Measurement const& Exporter::apply(Measurement const& mesu) const
+  {
+    instrumentation_impl::stage_timer_t timer(_instrumentation.get(), Instrumentation::stage_t::exporter);
+    chk(cuvis_exporter_apply(*_exporter, *mesu._mesu));
+    return mesu;
+  }
+
+  inline size_t Exporter::get_queue_used() const
+  {
+    int_t size;
+    chk(cuvis_exporter_get_queue_used(*_exporter, &size));
+    return size;
+  }
+
+  inline void Exporter::flush()
+  {
+    chk(cuvis_exporter_flush(*_exporter));
+  }
+
+  inline void Exporter::set_instrumentation(std::shared_ptr<Instrumentation> instrumentation) { _instrumentation = std::move(instrumentation); }
+
+  inline void Exporter::setHandle(CUVIS_EXPORTER exporter)
+  {
+    _exporter = std::shared_ptr<CUVIS_EXPORTER>(new CUVIS_EXPORTER{exporter}, [](CUVIS_EXPORTER* handle) {
+      cuvis_exporter_free(handle);
+      delete handle;
+    });
+  }
+
+  inline CubeExporter::CubeExporter(SaveArgs const& args)
+  {
+    CUVIS_EXPORTER exporter;
+    chk(cuvis_exporter_create_cube(&exporter, args, args));
+    setHandle(exporter);
+  }
+
+  inline TiffExporter::TiffExporter(TiffArgs const& args)
+  {
+    CUVIS_EXPORTER exporter;
+    chk(cuvis_exporter_create_tiff(&exporter, args, args));
+    setHandle(exporter);
+  }
+
+  inline EnviExporter::EnviExporter(EnviArgs const& args)
+  {
+    CUVIS_EXPORTER exporter;
+    chk(cuvis_exporter_create_envi(&exporter, args));
+    setHandle(exporter);
+  }
+
+  inline ViewExporter::ViewExporter(ViewArgs const& args)
+  {
+    CUVIS_EXPORTER exporter;
+    chk(cuvis_exporter_create_view(&exporter, args, args));
+    setHandle(exporter);
+  }
+
+  inline async_result_t Async::get(std::chrono::milliseconds waittime)
+  {
+    auto result = cuvis_async_call_get(_async.get(), int_t(waittime.count()));
+    switch (result)
+    {
+      case cuvis_status_t::status_ok: return async_result_t::done;
+      case cuvis_status_t::status_deferred: return async_result_t::deferred;
+      case cuvis_status_t::status_overwritten: return async_result_t::overwritten;
+      case cuvis_status_t::status_timeout: return async_result_t::timeout;
+      default: throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
+    }
+  }
+
+  inline AsyncMesu::result_t AsyncMesu::get(std::chrono::milliseconds waittime)
+  {
+    CUVIS_MESU mesu;
+    auto result = cuvis_async_capture_get(_async.get(), int_t(waittime.count()), &mesu);
+    switch (result)
+    {
+      case cuvis_status_t::status_ok: return {async_result_t::done, Measurement(mesu)};
+      case cuvis_status_t::status_deferred: return {async_result_t::deferred, {}};
+      case cuvis_status_t::status_overwritten: return {async_result_t::overwritten, {}};
+      case cuvis_status_t::status_timeout: return {async_result_t::timeout, {}};
+      default: throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
+    }
+  }
+
+  namespace async_impl
+  {
+    /* polls all pending operations from a single thread */
+    class completion_poller
+    {
+    public:
+      /* polls the operation with the given wait time, returns true if it completed */
+      using operation_t = std::function<bool(std::chrono::milliseconds)>;
+
+      static completion_poller& get_completion_poller()
+      {
+        static completion_poller poller;
+        return poller;
+      }
+
+      completion_poller(completion_poller const&) = delete;
+      completion_poller(completion_poller&&) = delete;
+      completion_poller& operator=(completion_poller&&) = delete;
+      completion_poller& operator=(completion_poller const&) = delete;
+
+      void submit(operation_t operation)
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _incoming.push_back(std::move(operation));
+          if (!_thread.joinable())
+          {
+            _thread = std::thread(&completion_poller::run, this);
+          }
+        }
+        _wake.notify_one();
+      }
+
+    private:
+      completion_poller() = default;
+
+      ~completion_poller()
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _stop = true;
+        }
+        _wake.notify_one();
+        if (_thread.joinable())
+        {
+          _thread.join();
+        }
+      }
+
+      void run()
+      {
+        std::vector<operation_t> active;
+        auto interval = min_interval;
+        while (true)
+        {
+          {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (active.empty())
+            {
+              _wake.wait(lock, [&] { return _stop || !_incoming.empty(); });
+            }
+            else
+            {
+              // wakes early for new operations
+              _wake.wait_for(lock, interval, [&] { return _stop || !_incoming.empty(); });
+            }
+            if (_stop)
+            {
+              return;
+            }
+            if (!_incoming.empty())
+            {
+              interval = min_interval;
+            }
+            std::move(_incoming.begin(), _incoming.end(), std::back_inserter(active));
+            _incoming.clear();
+          }
+
+          // poll everything without waiting, back off while nothing completes
+          auto const pending = std::remove_if(active.begin(), active.end(), [](operation_t const& operation) { return operation(std::chrono::milliseconds(0)); });
+          if (pending == active.end())
+          {
+            interval = std::min(interval * 2, max_interval);
+          }
+          else
+          {
+            active.erase(pending, active.end());
+            interval = min_interval;
+          }
+        }
+      }
+
+      static constexpr std::chrono::milliseconds min_interval{1};
+      static constexpr std::chrono::milliseconds max_interval{16};
+
+      std::mutex _mutex;
+      std::condition_variable _wake;
+      std::vector<operation_t> _incoming;
+      bool _stop = false;
+      std::thread _thread;
+    };
+
+    /* polls once, forwards the result or the exception to complete, returns true if completed */
+    template <typename result_t, typename poll_t, typename complete_t>
+    bool poll_once(poll_t const& poll, std::chrono::milliseconds wait, complete_t&& complete)
+    {
+      std::optional<result_t> result;
+      try
+      {
+        result = poll(wait);
+      }
+      catch (...)
+      {
+        complete(std::optional<result_t>(), std::current_exception());
+        return true;
+      }
+      if (!result.has_value())
+      {
+        return false;
+      }
+      complete(std::move(result), nullptr);
+      return true;
+    }
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+    template <typename result_t>
+    inline void awaiter_t<result_t>::await_suspend(std::coroutine_handle<> handle)
+    {
+      completion_poller::get_completion_poller().submit([this, handle](std::chrono::milliseconds wait) {
+        return poll_once<result_t>(poll, wait, [this, handle](std::optional<result_t>&& value, std::exception_ptr except) {
+          result = std::move(value);
+          error = except;
+          handle.resume();
+        });
+      });
+    }
+
+    template <typename result_t>
+    inline result_t awaiter_t<result_t>::await_resume()
+    {
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+      return std::move(*result);
+    }
+#endif
+  } // namespace async_impl
+
+  template <typename result_t>
+  inline std::future<result_t> AsyncOperation<result_t>::get_future() const
+  {
+    auto promise = std::make_shared<std::promise<result_t>>();
+    auto future = promise->get_future();
+    async_impl::completion_poller::get_completion_poller().submit([poll = _poll, promise](std::chrono::milliseconds wait) {
+      return async_impl::poll_once<result_t>(poll, wait, [&promise](std::optional<result_t>&& value, std::exception_ptr except) {
+        if (except)
+        {
+          promise->set_exception(except);
+        }
+        else
+        {
+          promise->set_value(std::move(*value));
+        }
+      });
+    });
+    return future;
+  }
+
+  template <typename result_t>
+  inline void AsyncOperation<result_t>::then(std::function<void(std::future<result_t>)> continuation) const
+  {
+    async_impl::completion_poller::get_completion_poller().submit([poll = _poll, continuation = std::move(continuation)](std::chrono::milliseconds wait) {
+      return async_impl::poll_once<result_t>(poll, wait, [&continuation](std::optional<result_t>&& value, std::exception_ptr except) {
+        std::promise<result_t> promise;
+        if (except)
+        {
+          promise.set_exception(except);
+        }
+        else
+        {
+          promise.set_value(std::move(*value));
+        }
+        try
+        {
+          continuation(promise.get_future());
+        }
+        catch (...)
+        {
+          // exceptions of the continuation must not stop the completion thread
+        }
+      });
+    });
+  }
+
+#ifdef CUVIS_CPP_HAS_COROUTINES
+  template <typename result_t>
+  inline async_impl::awaiter_t<result_t> AsyncOperation<result_t>::operator co_await() const
+  {
+    return async_impl::awaiter_t<result_t>{_poll, std::nullopt, nullptr};
+  }
+#endif
+
+  inline AsyncOperation<async_result_t> Async::operation() const
+  {
+    return AsyncOperation<async_result_t>([async = *this](std::chrono::milliseconds wait) mutable -> std::optional<async_result_t> {
+      auto const result = async.get(wait);
+      if (result == async_result_t::timeout)
+      {
+        return std::nullopt;
+      }
+      return result;
+    });
+  }
+
+  inline std::future<async_result_t> Async::get_future() const { return operation().get_future(); }
+
+  inline void Async::then(std::function<void(std::future<async_result_t>)> continuation) const { operation().then(std::move(continuation)); }
+
+  inline AsyncOperation<AsyncMesu::result_t> AsyncMesu::operation() const
+  {
+    return AsyncOperation<result_t>([async = *this](std::chrono::milliseconds wait) mutable -> std::optional<result_t> {
+      auto result = async.get(wait);
+      if (result.first == async_result_t::timeout)
+      {
+        return std::nullopt;
+      }
+      return result;
+    });
+  }
+
+  inline std::future<AsyncMesu::result_t> AsyncMesu::get_future() const { return operation().get_future(); }
+
+  inline void AsyncMesu::then(std::function<void(std::future<result_t>)> continuation) const { operation().then(std::move(continuation)); }
+
+  struct AsyncBatch::state_t
+  {
+    using step_t = std::function<Async()>;
+
+    std::mutex mutex;
+    std::condition_variable completed;
+
+    /* the stages are issued one after another, each once the previous one completed */
+    std::vector<std::vector<step_t>> stages;
+
+    /* stage to continue with after an error, e.g. to resume continuous mode */
+    std::size_t recovery_stage = 0;
+
+    std::size_t stage = 0;
+    bool issued = false;
+    std::vector<Async> pending;
+    bool finished = false;
+
+    async_result_t result = async_result_t::done;
+    std::exception_ptr error;
+
+    /* issues and settles the stages as far as possible without waiting, returns true once all stages completed */
+    bool advance();
+  };
+
+  /** @cond INTERNAL */
+  namespace async_impl
+  {
+    /* rank of a result within a batch, the least favourable one wins */
+    inline int rank(async_result_t result)
+    {
+      switch (result)
+      {
+        case async_result_t::overwritten: return 2;
+        case async_result_t::deferred: return 1;
+        default: return 0;
+      }
+    }
+  } // namespace async_impl
+  /** @endcond */
+
+  inline bool AsyncBatch::state_t::advance()
+  {
+    auto keep_error = [this] {
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    };
+
+    auto settle = [this, &keep_error](Async& async) {
+      try
+      {
+        auto const call_result = async.get(std::chrono::milliseconds(0));
+        if (call_result == async_result_t::timeout)
+        {
+          return false;
+        }
+        if (async_impl::rank(call_result) > async_impl::rank(result))
+        {
+          result = call_result;
+        }
+      }
+      catch (...)
+      {
+        keep_error();
+      }
+      return true;
+    };
+
+    while (stage < stages.size())
+    {
+      if (!issued)
+      {
+        for (auto const& step : stages[stage])
+        {
+          try
           {
-            state_changed = true;
-            last_component_states[k].is_online = comp_state;
+            pending.push_back(step());
+          }
+          catch (...)
+          {
+            keep_error();
+            break;
           }
         }
-        if (state_changed)
-          callback(last_state, last_component_states);
-        else
-        {
-          static const std::chrono::milliseconds poll_time = std::chrono::milliseconds(500);
-          std::this_thread::sleep_for(poll_time);
-        }
+        issued = true;
       }
-    });
+
+      pending.erase(std::remove_if(pending.begin(), pending.end(), settle), pending.end());
+      if (!pending.empty())
+      {
+        return false;
+      }
+      stage = (error && stage < recovery_stage) ? recovery_stage : stage + 1;
+      issued = false;
+    }
+
+    finished = true;
+    completed.notify_all();
+    return true;
   }
 
-  inline void AcquisitionContext::reset_state_change_callback()
+  inline async_result_t AsyncBatch::get(std::chrono::milliseconds waittime)
   {
-    _state_poll_thread_run = false;
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    state_t& state = *_state;
+    if (!state.completed.wait_for(lock, waittime, [&state] { return state.finished; }))
+    {
+      return async_result_t::timeout;
+    }
+    if (state.error)
+    {
+      std::rethrow_exception(state.error);
+    }
+    return state.result;
+  }
 
-    if (_state_poll_thread.joinable())
+  inline AsyncOperation<async_result_t> AsyncBatch::operation() const
+  {
+    return AsyncOperation<async_result_t>([batch = *this](std::chrono::milliseconds wait) mutable -> std::optional<async_result_t> {
+      auto const result = batch.get(wait);
+      if (result == async_result_t::timeout)
+      {
+        return std::nullopt;
+      }
+      return result;
+    });
+  }
+
+  inline std::future<async_result_t> AsyncBatch::get_future() const { return operation().get_future(); }
+
+  inline void AsyncBatch::then(std::function<void(std::future<async_result_t>)> continuation) const { operation().then(std::move(continuation)); }
+
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::add(std::string key, step_t step)
+  {
+    auto it = std::find_if(_steps.begin(), _steps.end(), [&key](auto const& entry) { return entry.first == key; });
+    if (it != _steps.end())
     {
-      _state_poll_thread.join();
+      it->second = std::move(step);
+    }
+    else
+    {
+      _steps.emplace_back(std::move(key), std::move(step));
     }
+    return *this;
   }
 
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_fps(double value)
+  {
+    return add("fps", [value](AcquisitionContext const& acq) { return acq.set_fps(value); });
+  }
 
-  inline Measurement const& Exporter::apply(Measurement const& mesu) const
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_integration_time(double value)
   {
-    chk(cuvis_exporter_apply(*_exporter, *mesu._mesu));
-    return mesu;
+    return add("integration_time", [value](AcquisitionContext const& acq) { return acq.set_integration_time(value); });
   }
 
-  inline size_t Exporter::get_queue_used() const
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_auto_exp(bool value)
   {
-    int_t size;
-    chk(cuvis_exporter_get_queue_used(*_exporter, &size));
-    return size;
+    return add("auto_exp", [value](AcquisitionContext const& acq) { return acq.set_auto_exp(value); });
   }
 
-  inline void Exporter::flush()
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_auto_exp_comp(double value)
   {
-    chk(cuvis_exporter_flush(*_exporter));
+    return add("auto_exp_comp", [value](AcquisitionContext const& acq) { return acq.set_auto_exp_comp(value); });
   }
 
-  inline void Exporter::setHandle(CUVIS_EXPORTER exporter)
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_binning(bool value)
   {
-    _exporter = std::shared_ptr<CUVIS_EXPORTER>(new CUVIS_EXPORTER{exporter}, [](CUVIS_EXPORTER* handle) {
-      cuvis_exporter_free(handle);
-      delete handle;
-    });
+    return add("binning", [value](AcquisitionContext const& acq) { return acq.set_binning(value); });
   }
 
-  inline CubeExporter::CubeExporter(SaveArgs const& args)
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_operation_mode(operation_mode_t value)
   {
-    CUVIS_EXPORTER exporter;
-    chk(cuvis_exporter_create_cube(&exporter, args, args));
-    setHandle(exporter);
+    return add("operation_mode", [value](AcquisitionContext const& acq) { return acq.set_operation_mode(value); });
   }
 
-  inline TiffExporter::TiffExporter(TiffArgs const& args)
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_average(int value)
   {
-    CUVIS_EXPORTER exporter;
-    chk(cuvis_exporter_create_tiff(&exporter, args, args));
-    setHandle(exporter);
+    return add("average", [value](AcquisitionContext const& acq) { return acq.set_average(value); });
   }
 
-  inline EnviExporter::EnviExporter(EnviArgs const& args)
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_component_gain(size_t id, double value)
   {
-    CUVIS_EXPORTER exporter;
-    chk(cuvis_exporter_create_envi(&exporter, args));
-    setHandle(exporter);
+    return add("component_gain/" + std::to_string(id), [id, value](AcquisitionContext const& acq) { return acq.set_component_gain(id, value); });
   }
 
-  inline ViewExporter::ViewExporter(ViewArgs const& args)
+  inline AcquisitionContext::settings_batch_t& AcquisitionContext::settings_batch_t::set_component_integration_time_factor(size_t id, double value)
   {
-    CUVIS_EXPORTER exporter;
-    chk(cuvis_exporter_create_view(&exporter, args, args));
-    setHandle(exporter);
+    return add("component_integration_time_factor/" + std::to_string(id),
+        [id, value](AcquisitionContext const& acq) { return acq.set_component_integration_time_factor(id, value); });
   }
 
-  inline async_result_t Async::get(std::chrono::milliseconds waittime)
+  inline AsyncBatch AcquisitionContext::apply(settings_batch_t const& batch, bool pause_continuous) const
   {
-    auto result = cuvis_async_call_get(_async.get(), int_t(waittime.count()));
-    switch (result)
+    AsyncBatch async;
+    async._state = std::make_shared<AsyncBatch::state_t>();
+    auto& stages = async._state->stages;
+
+    bool const pause = pause_continuous && !batch.empty();
+    if (pause)
     {
-      case cuvis_status_t::status_ok: return async_result_t::done;
-      case cuvis_status_t::status_deferred: return async_result_t::deferred;
-      case cuvis_status_t::status_overwritten: return async_result_t::overwritten;
-      case cuvis_status_t::status_timeout: return async_result_t::timeout;
-      default: throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
+      stages.push_back({[this] { return set_continuous(0); }});
     }
-  }
 
-  inline std::pair<async_result_t, std::optional<Measurement>> AsyncMesu::get(std::chrono::milliseconds waittime)
-  {
-    CUVIS_MESU mesu;
-    auto result = cuvis_async_capture_get(_async.get(), int_t(waittime.count()), &mesu);
-    switch (result)
+    std::vector<AsyncBatch::state_t::step_t> settings;
+    settings.reserve(batch._steps.size());
+    for (auto const& entry : batch._steps)
     {
-      case cuvis_status_t::status_ok: return {async_result_t::done, Measurement(mesu)};
-      case cuvis_status_t::status_deferred: return {async_result_t::deferred, {}};
-      case cuvis_status_t::status_overwritten: return {async_result_t::overwritten, {}};
-      case cuvis_status_t::status_timeout: return {async_result_t::timeout, {}};
-      default: throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
+      settings.push_back([this, step = entry.second] { return step(*this); });
     }
+    stages.push_back(std::move(settings));
+
+    if (pause)
+    {
+      stages.push_back({[this] { return set_continuous(1); }});
+    }
+    async._state->recovery_stage = stages.size() - 1;
+
+    // issue the first stage right away, the completion thread issues the later ones without a waiter
+    std::lock_guard<std::mutex> lock(async._state->mutex);
+    if (!async._state->advance())
+    {
+      async_impl::completion_poller::get_completion_poller().submit([state = async._state](std::chrono::milliseconds) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->advance();
+      });
+    }
+    return async;
   }
 
   inline void AcquisitionContext::capture_queue() { chk(cuvis_acq_cont_capture_async(*_acqCont, nullptr)); }
@@ -2429,6 +4985,39 @@ namespace cuvis
     throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
   }
 
+  inline AsyncOperation<std::optional<Measurement>> AcquisitionContext::get_next_measurement_async(std::optional<std::chrono::milliseconds> timeout_ms) const
+  {
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (timeout_ms.has_value())
+    {
+      deadline = std::chrono::steady_clock::now() + *timeout_ms;
+    }
+    return AsyncOperation<std::optional<Measurement>>(
+        [acqCont = _acqCont, deadline](std::chrono::milliseconds wait) -> std::optional<std::optional<Measurement>> {
+          auto const now = std::chrono::steady_clock::now();
+          if (deadline.has_value())
+          {
+            wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(std::max(*deadline - now, std::chrono::steady_clock::duration::zero())));
+          }
+
+          CUVIS_MESU mesu;
+          auto ret = cuvis_acq_cont_get_next_measurement(*acqCont, &mesu, int_t(wait.count()));
+          if (status_ok == ret)
+          {
+            return std::optional<Measurement>(Measurement(mesu));
+          }
+          if (status_no_measurement != ret)
+          {
+            throw cuvis_sdk_exception(cuvis_get_last_error_msg(), cuvis_get_last_error_msg_localized());
+          }
+          if (deadline.has_value() && std::chrono::steady_clock::now() >= *deadline)
+          {
+            return std::optional<Measurement>();
+          }
+          return std::nullopt;
+        });
+  }
+
   inline bool AcquisitionContext::has_next_measurement() const
   {
     int_t has_next;
@@ -2550,6 +5139,63 @@ namespace cuvis
     event_impl::event_handler_register::get_handler_register().unregister_event_callback(i_handler_id);
   }
 
+  namespace key_impl
+  {
+    class key_register
+    {
+    private:
+      key_register() = default;
+
+    public:
+      static key_register& get_key_register()
+      {
+        static key_register reg;
+        return reg;
+      }
+
+    public:
+      key_register(key_register const&) = delete;
+      key_register(key_register&&) = delete;
+      key_register& operator=(key_register&&) = delete;
+      key_register& operator=(key_register const&) = delete;
+
+    private:
+      std::mutex mtx_;
+      /* transparent comparison, looking up a known key does not allocate */
+      std::map<std::string, std::uint32_t, std::less<>> ids_;
+      /* a deque never moves its elements, so references to the names stay valid */
+      std::deque<std::string> names_;
+
+    public:
+      template <typename name_t>
+      std::uint32_t intern(name_t const& name)
+      {
+        std::lock_guard lock(mtx_);
+        auto const itr = ids_.find(name);
+        if (itr != ids_.end())
+        {
+          return itr->second;
+        }
+        auto const id = static_cast<std::uint32_t>(names_.size());
+        names_.emplace_back(name);
+        ids_.emplace(names_.back(), id);
+        return id;
+      }
+
+      std::string const& name(std::uint32_t id)
+      {
+        std::lock_guard lock(mtx_);
+        return names_[id];
+      }
+    };
+  } // namespace key_impl
+
+  inline data_key_t::data_key_t(char const* name) : _id(key_impl::key_register::get_key_register().intern(name)) {}
+
+  inline data_key_t::data_key_t(std::string const& name) : _id(key_impl::key_register::get_key_register().intern(name)) {}
+
+  inline std::string const& data_key_t::name() const { return key_impl::key_register::get_key_register().name(_id); }
+
   namespace log_impl
   {
     inline std::mutex log_callback_fun_mutex;
@@ -2610,7 +5256,7 @@ namespace cuvis
 
   inline void General::shutdown() { chk(cuvis_shutdown()); }
 
-  inline SessionFile::SessionFile(std::filesystem::path const& path)
+  inline SessionFile::SessionFile(std::filesystem::path const& path) : _path(path)
   {
     CUVIS_SESSION_FILE session;
     chk(cuvis_session_file_load(path.string().c_str(), &session));
@@ -2633,6 +5279,215 @@ namespace cuvis
     return Measurement(mesu);
   }
 
+  namespace session_impl
+  {
+    class frame_reader_state_t
+    {
+    public:
+      frame_reader_state_t(SessionFile session, std::vector<int_t> indices, cuvis_session_item_type_t type, std::size_t prefetch, std::size_t threads)
+          : _session(std::move(session)), _indices(std::move(indices)), _type(type), _slots(std::max<std::size_t>(prefetch, 1))
+      {
+        std::size_t const thread_count = std::min(std::max<std::size_t>(threads, 1), std::max<std::size_t>(_indices.size(), 1));
+        _threads.reserve(thread_count);
+        for (std::size_t k = 0; k < thread_count; k++)
+        {
+          _threads.emplace_back(&frame_reader_state_t::load, this);
+        }
+      }
+
+      ~frame_reader_state_t()
+      {
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _stop = true;
+        }
+        _space.notify_all();
+        for (auto& thread : _threads)
+        {
+          thread.join();
+        }
+      }
+
+      frame_reader_state_t(frame_reader_state_t const&) = delete;
+      frame_reader_state_t& operator=(frame_reader_state_t const&) = delete;
+
+      std::size_t size() const { return _indices.size(); }
+
+      /* waits for the next frame, returns false after the last one */
+      bool next(SessionFile::frame_t& frame)
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_next_read >= _indices.size())
+        {
+          return false;
+        }
+        slot_t& slot = _slots[_next_read % _slots.size()];
+        _ready.wait(lock, [&slot] { return slot.ready; });
+
+        std::exception_ptr error = slot.error;
+        frame = SessionFile::frame_t{_indices[_next_read], std::move(slot.mesu)};
+        slot = slot_t();
+        _next_read++;
+        lock.unlock();
+        _space.notify_all();
+
+        if (error)
+        {
+          std::rethrow_exception(error);
+        }
+        return true;
+      }
+
+    private:
+      struct slot_t
+      {
+        bool ready = false;
+        std::optional<Measurement> mesu;
+        std::exception_ptr error;
+      };
+
+      void load()
+      {
+        while (true)
+        {
+          std::size_t position;
+          {
+            std::unique_lock<std::mutex> lock(_mutex);
+            // stay within the ring ahead of the reader
+            _space.wait(lock, [this] { return _stop || _next_load >= _indices.size() || _next_load < _next_read + _slots.size(); });
+            if (_stop || _next_load >= _indices.size())
+            {
+              return;
+            }
+            position = _next_load++;
+          }
+
+          slot_t loaded;
+          try
+          {
+            loaded.mesu = _session.get_mesu(_indices[position], _type);
+          }
+          catch (...)
+          {
+            loaded.error = std::current_exception();
+          }
+          loaded.ready = true;
+
+          {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _slots[position % _slots.size()] = std::move(loaded);
+          }
+          _ready.notify_all();
+        }
+      }
+
+      SessionFile _session;
+      std::vector<int_t> _indices;
+      cuvis_session_item_type_t _type;
+
+      std::mutex _mutex;
+      std::condition_variable _ready;
+      std::condition_variable _space;
+      std::vector<slot_t> _slots;
+      std::size_t _next_load = 0;
+      std::size_t _next_read = 0;
+      bool _stop = false;
+
+      std::vector<std::thread> _threads;
+    };
+  } // namespace session_impl
+
+  inline SessionFile::frame_reader_t::iterator& SessionFile::frame_reader_t::iterator::operator++()
+  {
+    if (_state != nullptr && !_state->next(_frame))
+    {
+      _state = nullptr;
+    }
+    return *this;
+  }
+
+  inline std::size_t SessionFile::frame_reader_t::size() const { return _state->size(); }
+
+  inline SessionFile::frame_reader_t SessionFile::frames(std::size_t prefetch) const { return frames(prefetch, frame_selection_t()); }
+
+  inline SessionFile::frame_reader_t SessionFile::frames(std::size_t prefetch, frame_selection_t const& selection, std::size_t threads) const
+  {
+    return frame_reader_t(std::make_shared<session_impl::frame_reader_state_t>(*this, get_indices(selection), selection.type, prefetch, threads));
+  }
+
+  inline std::vector<int_t> SessionFile::get_indices(frame_selection_t const& selection) const
+  {
+    if (selection.stride <= 0)
+    {
+      throw std::runtime_error("frame stride must be positive");
+    }
+    // selections past the end of the session end at its last frame
+    int_t const size = get_size(selection.type);
+    int_t const last = std::min(selection.last.value_or(size - 1), size - 1);
+
+    std::vector<int_t> indices;
+    for (int_t index = std::max<int_t>(selection.first, 0); index <= last; index += selection.stride)
+    {
+      indices.push_back(index);
+    }
+    return indices;
+  }
+
+  template <typename data_t>
+  inline std::optional<image_t<data_t>> SessionFile::get_image(int_t frameNo, char const* key, cuvis_session_item_type_t type) const
+  {
+    auto mesu = get_mesu(frameNo, type);
+    if (!mesu.has_value())
+    {
+      return std::nullopt;
+    }
+    return mesu->get_image<data_t>(key);
+  }
+
+  inline bool SessionFile::advise(access_advice_t advice, std::uint64_t offset, std::uint64_t length) const
+  {
+#if defined(_POSIX_ADVISORY_INFO) && _POSIX_ADVISORY_INFO > 0
+    int const fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+    // the hints act on the page cache, which the descriptor of the SDK shares
+    bool const supported = ::posix_fadvise(fd, off_t(offset), off_t(length), advice == access_advice_t::willneed ? POSIX_FADV_WILLNEED : POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return supported;
+#else
+    (void)advice;
+    (void)offset;
+    (void)length;
+    return false;
+#endif
+  }
+
+  inline bool SessionFile::advise_frames(access_advice_t advice, int_t first, int_t count, cuvis_session_item_type_t type) const
+  {
+    int_t const size = get_size(type);
+    if (size <= 0 || count <= 0)
+    {
+      return false;
+    }
+    std::error_code error;
+    std::uint64_t const file_size = std::filesystem::file_size(_path, error);
+    if (error)
+    {
+      return false;
+    }
+    std::int64_t const begin = std::clamp<std::int64_t>(std::int64_t(first) - 1, 0, size);
+    std::int64_t const end = std::clamp<std::int64_t>(std::int64_t(first) + count + 1, 0, size);
+    if (begin >= end)
+    {
+      return false;
+    }
+    std::uint64_t const offset = file_size / std::uint64_t(size) * std::uint64_t(begin);
+    std::uint64_t const length = end == size ? 0 : file_size / std::uint64_t(size) * std::uint64_t(end) - offset;
+    return advise(advice, offset, length);
+  }
+
   inline std::optional<Measurement> SessionFile::get_ref(int_t refNo, cuvis_reference_type_t type) const
   {
     CUVIS_MESU mesu;
@@ -2703,6 +5558,36 @@ namespace cuvis
     return _data[((y)*_width + (x)) * _channels + (z)];
   }
 
+  template <typename data_t>
+  inline contiguous_range_t<data_t const> common_image_t<data_t>::pixel(std::size_t x, std::size_t y) const
+  {
+    assert(x < _width);
+    assert(y < _height);
+    return contiguous_range_t<data_t const>(_data + (y * _width + x) * _channels, _channels);
+  }
+
+  template <typename data_t>
+  inline contiguous_range_t<data_t const> common_image_t<data_t>::row(std::size_t y) const
+  {
+    assert(y < _height);
+    return contiguous_range_t<data_t const>(_data + y * _width * _channels, _width * _channels);
+  }
+
+  template <typename data_t>
+  inline strided_range_t<data_t const> common_image_t<data_t>::band(std::size_t z) const
+  {
+    assert(z < _channels);
+    return strided_range_t<data_t const>(_data + z, _width * _height, _channels);
+  }
+
+  template <typename data_t>
+  inline strided_range_t<data_t const> common_image_t<data_t>::band_row(std::size_t y, std::size_t z) const
+  {
+    assert(y < _height);
+    assert(z < _channels);
+    return strided_range_t<data_t const>(_data + y * _width * _channels + z, _width, _channels);
+  }
+
 
 
   inline GeneralExportArgs::GeneralExportArgs()
@@ -2764,7 +5649,7 @@ namespace cuvis
     return save_args;
   }
 
-  inline ProcessingArgs::ProcessingArgs() : processing_mode(processing_mode_t::Cube_Raw), allow_recalib(false) {}
+  inline ProcessingArgs::ProcessingArgs() : processing_mode(processing_mode_t::Cube_Raw), allow_recalib(false), discard_full_cube(false) {}
   inline ProcessingArgs::operator cuvis_proc_args_t() const
   {
     cuvis_proc_args_t proc_args({});
@@ -0,0 +1,82 @@
+/** @file test_export_pipeline.cpp
+  *
+  *
+  * @details Tests of @ref cuvis::aux::exporting::export_pipeline_t. Needs the SDK, whose settings directory is
+  * passed by CUVIS_TEST_SETTINGS. The test is skipped if it is not set.
+  * @copyright Apache V2.0
+  * */
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <system_error>
+
+#include <cuvis_export_pipeline.hpp>
+
+namespace
+{
+  /* the return code ctest reports as skipped */
+  constexpr int skipped = 77;
+
+  bool flush_after_close(std::filesystem::path const& dir)
+  {
+    cuvis::aux::exporting::pipeline_settings_t settings;
+    settings.lane_count = 2;
+    auto pipeline = std::make_unique<cuvis::aux::exporting::export_pipeline_t>(
+        [&dir](std::size_t) {
+          cuvis::SaveArgs args;
+          args.export_dir = dir;
+          args.allow_overwrite = true;
+          return std::make_unique<cuvis::CubeExporter>(args);
+        },
+        settings);
+
+    pipeline->close();
+    auto flushed = std::async(std::launch::async, [&pipeline] { pipeline->flush(); });
+    if (flushed.wait_for(std::chrono::seconds(5)) != std::future_status::ready)
+    {
+      std::cerr << "flush after close did not return" << std::endl;
+      // the waiting thread cannot be joined
+      std::_Exit(1);
+    }
+    flushed.get();
+
+    // closing again and the destructor return as well
+    pipeline->close();
+    pipeline.reset();
+    return true;
+  }
+} // namespace
+
+int main()
+{
+  char const* settings = std::getenv("CUVIS_TEST_SETTINGS");
+  if (settings == nullptr || *settings == '\0')
+  {
+    std::cout << "skipped: CUVIS_TEST_SETTINGS is not set" << std::endl;
+    return skipped;
+  }
+
+  std::filesystem::path const dir = std::filesystem::temp_directory_path() / "cuvis_test_export_pipeline";
+  bool passed = false;
+  try
+  {
+    cuvis::General::init(settings);
+    std::filesystem::create_directories(dir);
+    passed = flush_after_close(dir);
+    cuvis::General::shutdown();
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << "test failed: " << e.what() << std::endl;
+  }
+
+  std::error_code ignored;
+  std::filesystem::remove_all(dir, ignored);
+  std::cout << (passed ? "flush_after_close passed" : "flush_after_close failed") << std::endl;
+  return passed ? 0 : 1;
+}